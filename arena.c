@@ -0,0 +1,240 @@
+/* Arena implementation*/
+#include <assert.h>
+#include <stdlib.h>
+#include "arena.h"
+#include <string.h>
+
+/* Every object and chunk payload is aligned for any of these*/
+union Align
+{
+   void *pv;
+   long l;
+   double d;
+   size_t u;
+};
+
+/* The minimum number of objects and bytes of strings in a chunk*/
+enum {MIN_OBJECTS_PER_CHUNK = 64, MIN_STRING_CHUNK_SIZE = 4096};
+
+/* The number of string bytes assumed per expected object*/
+enum {STRING_BYTES_PER_OBJECT = 16};
+
+/* Header in front of every malloc'd chunk, the payload
+follows it*/
+struct Chunk
+{
+   /* The address of the next chunk*/
+   struct Chunk *psNextChunk;
+
+   /* So the payload after the header is aligned*/
+   union Align uAlign;
+};
+
+/* An object given back to the arena, its own memory
+holds the free list link*/
+struct FreeObject
+{
+   /* The address of the next free object*/
+   struct FreeObject *psNextFree;
+};
+
+/* Arena owns two chains of chunks, one carved into fixed size
+objects and one into packed strings*/
+struct Arena
+{
+   /* Size of each object rounded up for alignment*/
+   size_t uObjectSize;
+
+   /* Number of objects in the next object chunk*/
+   size_t uObjectsPerChunk;
+
+   /* Size in bytes of the next string chunk*/
+   size_t uStringChunkSize;
+
+   /* All chunks, objects and strings alike*/
+   struct Chunk *psFirstChunk;
+
+   /* Objects given back with Arena_freeObject*/
+   struct FreeObject *psFreeObjects;
+
+   /* Unused part of the current object chunk*/
+   char *pcObjectNext;
+   char *pcObjectEnd;
+
+   /* Unused part of the current string chunk*/
+   char *pcStringNext;
+   char *pcStringEnd;
+};
+
+/* Takes in an Arena_T oArena and a size_t uSize, mallocs a
+chunk with uSize bytes of payload, links it into oArena and
+returns the payload or NULL if there is not enough memory*/
+static char *Arena_newChunk(Arena_T oArena, size_t uSize)
+{
+   struct Chunk *psChunk;
+
+   psChunk = malloc(sizeof(struct Chunk) + uSize);
+   if (psChunk == NULL)
+      return NULL;
+   psChunk->psNextChunk = oArena->psFirstChunk;
+   oArena->psFirstChunk = psChunk;
+   return (char *)(psChunk + 1);
+}
+
+Arena_T Arena_new(size_t uObjectSize, size_t uHint)
+{
+   Arena_T oArena;
+
+   oArena = malloc(sizeof(struct Arena));
+   if (oArena == NULL)
+      return NULL;
+
+   /* Objects have to be able to hold a free list link and
+   keep the ones after them aligned*/
+   if (uObjectSize != 0 && uObjectSize < sizeof(struct FreeObject))
+      uObjectSize = sizeof(struct FreeObject);
+   oArena->uObjectSize = (uObjectSize + sizeof(union Align) - 1)
+      / sizeof(union Align) * sizeof(union Align);
+
+   oArena->uObjectsPerChunk = uHint;
+   if (oArena->uObjectsPerChunk < MIN_OBJECTS_PER_CHUNK)
+      oArena->uObjectsPerChunk = MIN_OBJECTS_PER_CHUNK;
+   oArena->uStringChunkSize = oArena->uObjectsPerChunk
+      * STRING_BYTES_PER_OBJECT;
+   if (oArena->uStringChunkSize < MIN_STRING_CHUNK_SIZE)
+      oArena->uStringChunkSize = MIN_STRING_CHUNK_SIZE;
+
+   oArena->psFirstChunk = NULL;
+   oArena->psFreeObjects = NULL;
+   oArena->pcObjectNext = NULL;
+   oArena->pcObjectEnd = NULL;
+   oArena->pcStringNext = NULL;
+   oArena->pcStringEnd = NULL;
+   return oArena;
+}
+
+void Arena_free(Arena_T oArena)
+{
+   struct Chunk *psCurrentChunk;
+   struct Chunk *psNextChunk;
+
+   assert(oArena != NULL);
+
+   for (psCurrentChunk = oArena->psFirstChunk;
+        psCurrentChunk != NULL;
+        psCurrentChunk = psNextChunk)
+   {
+      psNextChunk = psCurrentChunk->psNextChunk;
+      free(psCurrentChunk);
+   }
+   free(oArena);
+}
+
+void *Arena_allocObject(Arena_T oArena)
+{
+   struct FreeObject *psObject;
+   char *pcObject;
+
+   assert(oArena != NULL);
+   assert(oArena->uObjectSize != 0);
+
+   /* Reuses a freed object first*/
+   if (oArena->psFreeObjects != NULL){
+      psObject = oArena->psFreeObjects;
+      oArena->psFreeObjects = psObject->psNextFree;
+      return psObject;
+   }
+
+   /* Otherwise carves the next object out of the current chunk,
+   starting a new chunk twice the size of the last when it is
+   used up so the number of chunks stays logarithmic*/
+   if (oArena->pcObjectNext == oArena->pcObjectEnd){
+      pcObject = Arena_newChunk(oArena,
+         oArena->uObjectsPerChunk * oArena->uObjectSize);
+      if (pcObject == NULL)
+         return NULL;
+      oArena->pcObjectNext = pcObject;
+      oArena->pcObjectEnd = pcObject
+         + oArena->uObjectsPerChunk * oArena->uObjectSize;
+      oArena->uObjectsPerChunk *= 2;
+   }
+   pcObject = oArena->pcObjectNext;
+   oArena->pcObjectNext += oArena->uObjectSize;
+   return pcObject;
+}
+
+void Arena_freeObject(Arena_T oArena, void *pvObject)
+{
+   struct FreeObject *psObject = pvObject;
+
+   assert(oArena != NULL);
+   assert(pvObject != NULL);
+
+   psObject->psNextFree = oArena->psFreeObjects;
+   oArena->psFreeObjects = psObject;
+}
+
+int Arena_reserveObjects(Arena_T oArena, size_t uCount)
+{
+   char *pcObject;
+
+   assert(oArena != NULL);
+   assert(oArena->uObjectSize != 0);
+
+   if ((size_t)(oArena->pcObjectEnd - oArena->pcObjectNext)
+       >= uCount * oArena->uObjectSize)
+      return 1;
+   if (uCount > ((size_t)-1 - sizeof(struct Chunk))
+       / oArena->uObjectSize)
+      return 0;
+   pcObject = Arena_newChunk(oArena, uCount * oArena->uObjectSize);
+   if (pcObject == NULL)
+      return 0;
+
+   /* What is left of the current chunk goes on the free list so
+   no object is wasted by starting the new one early*/
+   while (oArena->pcObjectNext != oArena->pcObjectEnd){
+      Arena_freeObject(oArena, oArena->pcObjectNext);
+      oArena->pcObjectNext += oArena->uObjectSize;
+   }
+   oArena->pcObjectNext = pcObject;
+   oArena->pcObjectEnd = pcObject + uCount * oArena->uObjectSize;
+   return 1;
+}
+
+char *Arena_copyString(Arena_T oArena, const char *pcString)
+{
+   assert(pcString != NULL);
+   return Arena_copyStringN(oArena, pcString, strlen(pcString));
+}
+
+char *Arena_copyStringN(Arena_T oArena, const char *pcString,
+   size_t uLength)
+{
+   size_t uSize = uLength + 1;
+   size_t uChunkSize;
+   char *pcCopy;
+
+   assert(oArena != NULL);
+   assert(pcString != NULL);
+
+   /* Starts a new string chunk if the string does not fit in
+   what is left of the current one, large enough for the string
+   and twice the size of the last one*/
+   if ((size_t)(oArena->pcStringEnd - oArena->pcStringNext) < uSize){
+      uChunkSize = oArena->uStringChunkSize;
+      if (uChunkSize < uSize)
+         uChunkSize = uSize;
+      pcCopy = Arena_newChunk(oArena, uChunkSize);
+      if (pcCopy == NULL)
+         return NULL;
+      oArena->pcStringNext = pcCopy;
+      oArena->pcStringEnd = pcCopy + uChunkSize;
+      oArena->uStringChunkSize *= 2;
+   }
+   pcCopy = oArena->pcStringNext;
+   oArena->pcStringNext += uSize;
+   memcpy(pcCopy, pcString, uLength);
+   pcCopy[uLength] = '\0';
+   return pcCopy;
+}
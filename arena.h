@@ -0,0 +1,55 @@
+/* Arena Interface, a per-owner allocator for fixed size
+objects and packed strings that is released all at once*/
+#ifndef ARENA_INCLUDED
+#define ARENA_INCLUDED
+#include <stddef.h>
+
+/* For concision Arena_T is defined to
+be a pointer to a struct Arena*/
+typedef struct Arena *Arena_T;
+
+/* Arena_new takes in a size_t uObjectSize, the size of the
+objects Arena_allocObject hands out (0 if the arena only holds
+strings), and a size_t uHint, the number of objects expected,
+used to size the first chunks. Returns a new Arena_T or NULL
+if there is not enough memory */
+Arena_T Arena_new(size_t uObjectSize, size_t uHint);
+
+/* Arena_free takes in an Arena_T oArena and frees every chunk
+it owns, and so every object and string it ever handed out,
+in time proportional to the number of chunks. Returns nothing */
+void Arena_free(Arena_T oArena);
+
+/* Arena_allocObject takes in an Arena_T oArena and returns
+a pointer to uninitialized memory for one object, reusing
+objects given back with Arena_freeObject first. Returns NULL
+if there is not enough memory */
+void *Arena_allocObject(Arena_T oArena);
+
+/* Arena_freeObject takes in an Arena_T oArena and a
+void *pvObject previously returned by Arena_allocObject on
+the same arena and puts it back on the arena's free list.
+Returns nothing */
+void Arena_freeObject(Arena_T oArena, void *pvObject);
+
+/* Arena_reserveObjects takes in an Arena_T oArena and a size_t
+uCount and makes sure the next uCount calls of Arena_allocObject
+take no more memory from malloc, allocating one chunk for all of
+them at once if needed. Returns 1, or 0 if there is not enough
+memory in which case oArena is unchanged */
+int Arena_reserveObjects(Arena_T oArena, size_t uCount);
+
+/* Arena_copyString takes in an Arena_T oArena and a
+const char *pcString and returns a copy of pcString packed
+into the arena's string chunks, or NULL if there is not enough
+memory. The copy lives until Arena_free */
+char *Arena_copyString(Arena_T oArena, const char *pcString);
+
+/* Arena_copyStringN takes in an Arena_T oArena, a const char
+*pcString and a size_t uLength and does what Arena_copyString does
+for the string of the uLength characters at pcString, which need
+not be followed by a '\0' */
+char *Arena_copyStringN(Arena_T oArena, const char *pcString,
+   size_t uLength);
+
+#endif
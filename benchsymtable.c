@@ -0,0 +1,616 @@
+/*--------------------------------------------------------------------*/
+/* benchsymtable.c                                                    */
+/* Benchmark of a SymTable implementation: per-operation time,        */
+/* throughput and latency percentiles over several key distributions */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200112L
+#include "symtable.h"
+#include "strhash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The key distributions. UNIFORM and ZIPF draw short keys, the
+   first uniformly and the second with a Zipf(0.99) skew over a
+   random ranking of the keys. VARLEN draws keys of 8 to 256
+   characters uniformly. ADVERSARIAL draws keys uniformly that all
+   share a 32 character prefix and whose default hash has its low 6
+   bits clear, so they crowd into 1/64 of the buckets. */
+
+enum Distribution {UNIFORM, ZIPF, VARLEN, ADVERSARIAL,
+   DISTRIBUTION_COUNT};
+
+static const char *apcDistributionNames[DISTRIBUTION_COUNT] =
+   {"uniform", "zipf", "varlen", "adversarial"};
+
+/* The ways of reordering chains SymTable_setReorder is benchmarked
+   with, in the order of enum SymTableReorder. */
+
+enum {REORDER_COUNT = 3};
+
+static const char *apcReorderNames[REORDER_COUNT] =
+   {"none", "mtf", "transpose"};
+
+/* The kinds of timed operations. */
+
+enum OpKind {OP_PUT, OP_GET, OP_REMOVE};
+
+/* One timed operation, generated before the timing starts. */
+
+struct Op
+{
+   enum OpKind eKind;
+   const char *pcKey;
+};
+
+enum {ADVERSARIAL_PREFIX_LENGTH = 32, ADVERSARIAL_HASH_MASK = 63};
+enum {MIN_VARLEN_LENGTH = 8, MAX_VARLEN_LENGTH = 256};
+
+/* The Zipf exponent of ZIPF. */
+#define ZIPF_EXPONENT 0.99
+
+/*--------------------------------------------------------------------*/
+
+/* The keys of one distribution: ppcPresent[i] is put into the
+   table before the mixed phase, ppcAbsent[i] never is. */
+
+struct KeySet
+{
+   char **ppcPresent;
+   char **ppcAbsent;
+   size_t uCount;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* The state of the pseudo-random generator (xorshift64*). */
+
+static unsigned long ulRandomState = 88172645463325252UL;
+
+/* Return the next pseudo-random number. */
+
+static unsigned long nextRandom(void)
+{
+   ulRandomState ^= ulRandomState >> 12;
+   ulRandomState ^= ulRandomState << 25;
+   ulRandomState ^= ulRandomState >> 27;
+   return ulRandomState * 2685821657736338717UL;
+}
+
+/* Return a pseudo-random double in [0, 1). */
+
+static double nextUnit(void)
+{
+   return (double)(nextRandom() >> 11) / 9007199254740992.0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return pvResult, or write a message to stderr and exit with
+   EXIT_FAILURE if it is NULL. */
+
+static void *checkAlloc(void *pvResult)
+{
+   if (pvResult == NULL)
+   {
+      fprintf(stderr, "benchsymtable: out of memory\n");
+      exit(EXIT_FAILURE);
+   }
+   return pvResult;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the current wall clock time in nanoseconds. */
+
+static double nowNs(void)
+{
+   struct timespec sTime;
+   clock_gettime(CLOCK_MONOTONIC, &sTime);
+   return (double)sTime.tv_sec * 1e9 + (double)sTime.tv_nsec;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new copy of the key of distribution eDistribution that
+   is number uIndex of the set marked by cSet, which keeps the
+   present and absent keys apart. */
+
+static char *makeKey(enum Distribution eDistribution, char cSet,
+   size_t uIndex)
+{
+   char acBuffer[MAX_VARLEN_LENGTH + 32];
+   size_t uLength;
+   size_t uTarget;
+   unsigned long ulCandidate;
+
+   switch (eDistribution)
+   {
+      case VARLEN:
+         /* The index keeps the key unique, the rest is filler. */
+         uTarget = MIN_VARLEN_LENGTH + (size_t)(nextRandom()
+            % (MAX_VARLEN_LENGTH - MIN_VARLEN_LENGTH + 1));
+         sprintf(acBuffer, "%c%lx:", cSet, (unsigned long)uIndex);
+         for (uLength = strlen(acBuffer); uLength < uTarget;
+              uLength++)
+            acBuffer[uLength] = (char)('a' + nextRandom() % 26);
+         acBuffer[uLength] = '\0';
+         break;
+
+      case ADVERSARIAL:
+         /* Tries successive candidates; one in 64 passes. */
+         memset(acBuffer, 'x', ADVERSARIAL_PREFIX_LENGTH);
+         acBuffer[0] = cSet;
+         for (ulCandidate = (unsigned long)uIndex << 16; ;
+              ulCandidate++)
+         {
+            sprintf(acBuffer + ADVERSARIAL_PREFIX_LENGTH, "%lx",
+               ulCandidate);
+            if ((StrHash_hash(acBuffer, strlen(acBuffer))
+                 & ADVERSARIAL_HASH_MASK) == 0)
+               break;
+         }
+         break;
+
+      default:
+         /* Scattered, unique and 17 characters at most. */
+         sprintf(acBuffer, "%c%lx", cSet,
+            (unsigned long)uIndex * 0x9E3779B97F4A7C15UL);
+         break;
+   }
+   return strcpy(checkAlloc(malloc(strlen(acBuffer) + 1)), acBuffer);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Fill *psKeys with uCount present and uCount absent keys of
+   distribution eDistribution. */
+
+static void makeKeySet(struct KeySet *psKeys,
+   enum Distribution eDistribution, size_t uCount)
+{
+   size_t i;
+
+   psKeys->uCount = uCount;
+   psKeys->ppcPresent = checkAlloc(malloc(uCount * sizeof(char *)));
+   psKeys->ppcAbsent = checkAlloc(malloc(uCount * sizeof(char *)));
+   for (i = 0; i < uCount; i++)
+   {
+      psKeys->ppcPresent[i] = makeKey(eDistribution, 'p', i);
+      psKeys->ppcAbsent[i] = makeKey(eDistribution, 'm', i);
+   }
+}
+
+/* Free the keys of *psKeys. */
+
+static void freeKeySet(struct KeySet *psKeys)
+{
+   size_t i;
+
+   for (i = 0; i < psKeys->uCount; i++)
+   {
+      free(psKeys->ppcPresent[i]);
+      free(psKeys->ppcAbsent[i]);
+   }
+   free(psKeys->ppcPresent);
+   free(psKeys->ppcAbsent);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return an array of the uCount cumulative Zipf probabilities of
+   ranks 1 to uCount. */
+
+static double *makeZipfTable(size_t uCount)
+{
+   double *pdCumulative;
+   double dSum = 0.0;
+   size_t i;
+
+   pdCumulative = checkAlloc(malloc(uCount * sizeof(double)));
+   for (i = 0; i < uCount; i++)
+   {
+      dSum += 1.0 / pow((double)(i + 1), ZIPF_EXPONENT);
+      pdCumulative[i] = dSum;
+   }
+   for (i = 0; i < uCount; i++)
+      pdCumulative[i] /= dSum;
+   return pdCumulative;
+}
+
+/* Return the index of a present key drawn from distribution
+   eDistribution over uCount keys. pdZipf is the table of
+   makeZipfTable and puRanking a permutation of the indices, so
+   the hottest keys are not simply the first ones put. */
+
+static size_t drawIndex(enum Distribution eDistribution,
+   size_t uCount, const double *pdZipf, const size_t *puRanking)
+{
+   size_t uLow;
+   size_t uHigh;
+   size_t uMiddle;
+   double dUnit;
+
+   if (eDistribution != ZIPF)
+      return (size_t)(nextRandom() % uCount);
+
+   dUnit = nextUnit();
+   uLow = 0;
+   uHigh = uCount - 1;
+   while (uLow < uHigh)
+   {
+      uMiddle = uLow + (uHigh - uLow) / 2;
+      if (pdZipf[uMiddle] < dUnit)
+         uLow = uMiddle + 1;
+      else
+         uHigh = uMiddle;
+   }
+   return puRanking[uLow];
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return an array of the uOpCount operations of the mixed phase
+   over *psKeys, drawn from eDistribution. iReadPercent of them are
+   gets, iHitPercent of the gets are for present keys. The other
+   operations take turns removing a drawn present key and putting
+   it back, so the table keeps its size and the gets their hit
+   ratio. */
+
+static struct Op *makeMixedOps(const struct KeySet *psKeys,
+   enum Distribution eDistribution, size_t uOpCount,
+   int iReadPercent, int iHitPercent)
+{
+   struct Op *psOps;
+   double *pdZipf = NULL;
+   size_t *puRanking;
+   const char *pcRemovedKey = NULL;
+   size_t uIndex;
+   size_t uSwap;
+   size_t uCount = psKeys->uCount;
+   size_t i;
+
+   psOps = checkAlloc(malloc(uOpCount * sizeof(struct Op)));
+   puRanking = checkAlloc(malloc(uCount * sizeof(size_t)));
+   for (i = 0; i < uCount; i++)
+      puRanking[i] = i;
+   for (i = uCount; i > 1; i--)
+   {
+      uIndex = (size_t)(nextRandom() % i);
+      uSwap = puRanking[i - 1];
+      puRanking[i - 1] = puRanking[uIndex];
+      puRanking[uIndex] = uSwap;
+   }
+   if (eDistribution == ZIPF)
+      pdZipf = makeZipfTable(uCount);
+
+   for (i = 0; i < uOpCount; i++)
+   {
+      if ((int)(nextRandom() % 100) < iReadPercent)
+      {
+         psOps[i].eKind = OP_GET;
+         if ((int)(nextRandom() % 100) < iHitPercent)
+            psOps[i].pcKey = psKeys->ppcPresent[drawIndex(
+               eDistribution, uCount, pdZipf, puRanking)];
+         else
+            psOps[i].pcKey =
+               psKeys->ppcAbsent[nextRandom() % uCount];
+      }
+      else if (pcRemovedKey != NULL)
+      {
+         psOps[i].eKind = OP_PUT;
+         psOps[i].pcKey = pcRemovedKey;
+         pcRemovedKey = NULL;
+      }
+      else
+      {
+         psOps[i].eKind = OP_REMOVE;
+         psOps[i].pcKey = psKeys->ppcPresent[drawIndex(eDistribution,
+            uCount, pdZipf, puRanking)];
+         pcRemovedKey = psOps[i].pcKey;
+      }
+   }
+
+   free(pdZipf);
+   free(puRanking);
+   return psOps;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run operation *psOp on oSymTable and return 1 if it found (or
+   put) its key, 0 otherwise. */
+
+static int runOp(SymTable_T oSymTable, const struct Op *psOp)
+{
+   switch (psOp->eKind)
+   {
+      case OP_PUT:
+         return SymTable_put(oSymTable, psOp->pcKey, psOp->pcKey);
+      case OP_GET:
+         return SymTable_get(oSymTable, psOp->pcKey) != NULL;
+      default:
+         return SymTable_remove(oSymTable, psOp->pcKey) != NULL;
+   }
+}
+
+/* Run the uOpCount operations psOps on oSymTable. If pdLatencies
+   is not NULL, time each operation on its own into it. Return the
+   number of operations that found (or put) their key. */
+
+static size_t runOps(SymTable_T oSymTable, const struct Op *psOps,
+   size_t uOpCount, double *pdLatencies)
+{
+   size_t uFound = 0;
+   double dStart;
+   size_t i;
+
+   if (pdLatencies == NULL)
+   {
+      for (i = 0; i < uOpCount; i++)
+         uFound += (size_t)runOp(oSymTable, &psOps[i]);
+      return uFound;
+   }
+   for (i = 0; i < uOpCount; i++)
+   {
+      dStart = nowNs();
+      uFound += (size_t)runOp(oSymTable, &psOps[i]);
+      pdLatencies[i] = nowNs() - dStart;
+   }
+   return uFound;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare the doubles at pv1 and pv2 for qsort. */
+
+static int compareDoubles(const void *pv1, const void *pv2)
+{
+   double d1 = *(const double *)pv1;
+   double d2 = *(const double *)pv2;
+   return (d1 > d2) - (d1 < d2);
+}
+
+/* Return the time in nanoseconds that one pair of clock readings
+   takes, which every timed latency includes. */
+
+static double timerOverheadNs(void)
+{
+   enum {SAMPLE_COUNT = 10001};
+   double adSamples[SAMPLE_COUNT];
+   double dStart;
+   int i;
+
+   for (i = 0; i < SAMPLE_COUNT; i++)
+   {
+      dStart = nowNs();
+      adSamples[i] = nowNs() - dStart;
+   }
+   qsort(adSamples, SAMPLE_COUNT, sizeof(double), compareDoubles);
+   return adSamples[SAMPLE_COUNT / 2];
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write one result line for phase pcPhase of distribution
+   eDistribution to stdout: uOpCount operations took dTotalNs when
+   run back to back, and took the uOpCount latencies of pdLatencies
+   (sorted here) when timed one by one. uFound of them found (or
+   put) their key. */
+
+static void report(enum Distribution eDistribution,
+   const char *pcPhase, size_t uOpCount, double dTotalNs,
+   double *pdLatencies, size_t uFound)
+{
+   qsort(pdLatencies, uOpCount, sizeof(double), compareDoubles);
+   printf("%-11s %-7s %9lu %9.1f %9.3f %8.0f %8.0f %8.0f %6.1f%%\n",
+      apcDistributionNames[eDistribution], pcPhase,
+      (unsigned long)uOpCount, dTotalNs / (double)uOpCount,
+      (double)uOpCount / dTotalNs * 1e3,
+      pdLatencies[uOpCount / 2],
+      pdLatencies[uOpCount - 1 - uOpCount / 100],
+      pdLatencies[uOpCount - 1 - uOpCount / 1000],
+      100.0 * (double)uFound / (double)uOpCount);
+   fflush(stdout);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Benchmark distribution eDistribution with uKeyCount keys and
+   uOpCount mixed operations, iReadPercent of them gets of which
+   iHitPercent are for present keys, on tables that reorder their
+   chains as eReorder says and keep a filter if iFilter is 1. Each
+   phase (putting every key,
+   the mixed operations, removing every key left) runs twice on a
+   fresh table: once back to back for the throughput, once with
+   every operation timed for the latency percentiles. Timing each
+   operation keeps the processor from overlapping the cache misses
+   of consecutive ones, so the percentiles can exceed ns/op. */
+
+static void benchDistribution(enum Distribution eDistribution,
+   size_t uKeyCount, size_t uOpCount, int iReadPercent,
+   int iHitPercent, enum SymTableReorder eReorder, int iFilter)
+{
+   enum {PHASE_COUNT = 3};
+   static const char *apcPhaseNames[PHASE_COUNT] =
+      {"put", "mixed", "remove"};
+
+   struct KeySet sKeys;
+   struct Op *apsPhaseOps[PHASE_COUNT];
+   size_t auPhaseOpCounts[PHASE_COUNT];
+   size_t auFound[PHASE_COUNT];
+   double adTotalNs[PHASE_COUNT];
+   double *pdLatencies;
+   SymTable_T oSymTable;
+   size_t uRemoveCount = 0;
+   size_t uMaxOpCount;
+   size_t i;
+   int iPass;
+   int iPhase;
+   double dStart;
+
+   makeKeySet(&sKeys, eDistribution, uKeyCount);
+
+   /* Put every present key. */
+   apsPhaseOps[0] = checkAlloc(malloc(uKeyCount * sizeof(struct Op)));
+   for (i = 0; i < uKeyCount; i++)
+   {
+      apsPhaseOps[0][i].eKind = OP_PUT;
+      apsPhaseOps[0][i].pcKey = sKeys.ppcPresent[i];
+   }
+   auPhaseOpCounts[0] = uKeyCount;
+
+   apsPhaseOps[1] = makeMixedOps(&sKeys, eDistribution, uOpCount,
+      iReadPercent, iHitPercent);
+   auPhaseOpCounts[1] = uOpCount;
+
+   /* Remove every key the mixed phase leaves in the table, found
+      by running the first two phases on a scratch table. */
+   apsPhaseOps[2] = checkAlloc(malloc(uKeyCount * sizeof(struct Op)));
+   oSymTable = checkAlloc(SymTable_new());
+   (void)runOps(oSymTable, apsPhaseOps[0], uKeyCount, NULL);
+   (void)runOps(oSymTable, apsPhaseOps[1], uOpCount, NULL);
+   for (i = 0; i < uKeyCount; i++)
+      if (SymTable_contains(oSymTable, sKeys.ppcPresent[i]))
+      {
+         apsPhaseOps[2][uRemoveCount].eKind = OP_REMOVE;
+         apsPhaseOps[2][uRemoveCount].pcKey = sKeys.ppcPresent[i];
+         uRemoveCount++;
+      }
+   SymTable_free(oSymTable);
+   auPhaseOpCounts[2] = uRemoveCount;
+
+   uMaxOpCount = uKeyCount > uOpCount ? uKeyCount : uOpCount;
+   pdLatencies = checkAlloc(malloc(uMaxOpCount * sizeof(double)));
+
+   /* Pass 0 is back to back, pass 1 times each operation. */
+   for (iPass = 0; iPass < 2; iPass++)
+   {
+      oSymTable = checkAlloc(SymTable_new());
+      SymTable_setReorder(oSymTable, eReorder);
+      if (! SymTable_setFilter(oSymTable, iFilter))
+      {
+         fprintf(stderr, "benchsymtable: out of memory\n");
+         exit(EXIT_FAILURE);
+      }
+      for (iPhase = 0; iPhase < PHASE_COUNT; iPhase++)
+      {
+         if (iPass == 0)
+         {
+            dStart = nowNs();
+            auFound[iPhase] = runOps(oSymTable, apsPhaseOps[iPhase],
+               auPhaseOpCounts[iPhase], NULL);
+            adTotalNs[iPhase] = nowNs() - dStart;
+         }
+         else
+         {
+            (void)runOps(oSymTable, apsPhaseOps[iPhase],
+               auPhaseOpCounts[iPhase], pdLatencies);
+            if (auPhaseOpCounts[iPhase] > 0)
+               report(eDistribution, apcPhaseNames[iPhase],
+                  auPhaseOpCounts[iPhase], adTotalNs[iPhase],
+                  pdLatencies, auFound[iPhase]);
+         }
+      }
+      SymTable_free(oSymTable);
+   }
+
+   for (iPhase = 0; iPhase < PHASE_COUNT; iPhase++)
+      free(apsPhaseOps[iPhase]);
+   free(pdLatencies);
+   freeKeySet(&sKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Benchmark a SymTable implementation. As always, argc is the
+   command-line argument count, argv contains the command-line
+   arguments, and argv[0] is the name of the executable binary file.
+   The optional arguments are, in order: the number of keys
+   (default 100000), the number of mixed operations (default 10
+   times the keys), the distribution (uniform, zipf, varlen,
+   adversarial or all, the default), the percentage of gets among
+   the mixed operations (default 90), the percentage of the gets
+   that are for present keys (default 90), how the tables reorder
+   their chains (none, the default, mtf or transpose) and whether
+   they keep a filter of their keys (1, or 0 the default). Exit with
+   EXIT_FAILURE if an argument is not valid. Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   unsigned long ulKeyCount = 100000;
+   unsigned long ulOpCount;
+   int iReadPercent = 90;
+   int iHitPercent = 90;
+   int iDistribution = -1;
+   int iReorder = 0;
+   int iFilter = 0;
+   int i;
+
+   if (argc > 8 ||
+       (argc > 1 && sscanf(argv[1], "%lu", &ulKeyCount) != 1))
+   {
+      fprintf(stderr, "Usage: %s [keycount [opcount [distribution "
+         "[readpercent [hitpercent [reorder [filter]]]]]]]\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+   ulOpCount = ulKeyCount * 10;
+   if ((argc > 2 && sscanf(argv[2], "%lu", &ulOpCount) != 1) ||
+       (argc > 4 && sscanf(argv[4], "%d", &iReadPercent) != 1) ||
+       (argc > 5 && sscanf(argv[5], "%d", &iHitPercent) != 1) ||
+       (argc > 7 && sscanf(argv[7], "%d", &iFilter) != 1) ||
+       ulKeyCount == 0 || iReadPercent < 0 || iReadPercent > 100 ||
+       iHitPercent < 0 || iHitPercent > 100 ||
+       (iFilter != 0 && iFilter != 1))
+   {
+      fprintf(stderr, "keycount must be positive, opcount numeric, "
+         "the percentages 0 to 100 and filter 0 or 1\n");
+      exit(EXIT_FAILURE);
+   }
+   if (argc > 3 && strcmp(argv[3], "all") != 0)
+   {
+      for (i = 0; i < DISTRIBUTION_COUNT; i++)
+         if (strcmp(argv[3], apcDistributionNames[i]) == 0)
+            iDistribution = i;
+      if (iDistribution == -1)
+      {
+         fprintf(stderr, "distribution must be uniform, zipf, "
+            "varlen, adversarial or all\n");
+         exit(EXIT_FAILURE);
+      }
+   }
+
+   if (argc > 6)
+   {
+      iReorder = -1;
+      for (i = 0; i < REORDER_COUNT; i++)
+         if (strcmp(argv[6], apcReorderNames[i]) == 0)
+            iReorder = i;
+      if (iReorder == -1)
+      {
+         fprintf(stderr, "reorder must be none, mtf or transpose\n");
+         exit(EXIT_FAILURE);
+      }
+   }
+
+   printf("%s: %lu keys, %lu mixed operations (%d%% gets, "
+      "%d%% of them hits, reorder %s, filter %d)\n", argv[0],
+      ulKeyCount, ulOpCount, iReadPercent, iHitPercent,
+      apcReorderNames[iReorder], iFilter);
+   printf("Latencies include %.0f ns of timer overhead\n",
+      timerOverheadNs());
+   printf("%-11s %-7s %9s %9s %9s %8s %8s %8s %7s\n",
+      "keys", "phase", "ops", "ns/op", "Mops/s", "p50 ns", "p99 ns",
+      "p999 ns", "found");
+   for (i = 0; i < DISTRIBUTION_COUNT; i++)
+      if (iDistribution == -1 || iDistribution == i)
+         benchDistribution((enum Distribution)i, (size_t)ulKeyCount,
+            (size_t)ulOpCount, iReadPercent, iHitPercent,
+            (enum SymTableReorder)iReorder, iFilter);
+   return 0;
+}
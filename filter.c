@@ -0,0 +1,168 @@
+/* Filter implementation*/
+/* A blocked counting Bloom filter. The counters are 4 bits, two to
+a byte, and grouped in blocks of one cache line each. A hash picks
+one block with its low bits and PROBE_COUNT counters inside it with
+its high bits, so every operation touches a single cache line. A
+hash is present when all of its counters are nonzero. A counter
+that reaches COUNTER_MAX stays there, as it no longer knows how
+many hashes use it, so a removal never clears a counter that
+another hash still needs*/
+#define _POSIX_C_SOURCE 200112L
+#include <assert.h>
+#include <limits.h>
+#include <stdlib.h>
+#include "filter.h"
+#include <string.h>
+
+/* The bytes of a block, one cache line, and the counters in it*/
+enum {BLOCK_BYTES = 64, BLOCK_COUNTERS = BLOCK_BYTES * 2};
+
+/* The number of bits that pick one counter of a block*/
+enum {COUNTER_INDEX_BITS = 7};
+
+/* The counters each hash sets, and the number of hashes a block is
+sized for. Eight hashes to a block is 16 counters per hash, which
+turns away more than 99 percent of absent hashes*/
+enum {PROBE_COUNT = 4, HASHES_PER_BLOCK = 8};
+
+/* The largest value of a counter, where it sticks*/
+enum {COUNTER_MAX = 15};
+
+/* Odd constant the hash is multiplied by, so the counters depend
+on every bit of it and not only on the bits that picked the
+block*/
+#define FILTER_MULTIPLIER 0x9E3779B1UL
+
+/* Filter is the array of blocks*/
+struct Filter
+{
+   /* The counters, uBlockCount blocks of BLOCK_BYTES bytes aligned
+   to a cache line*/
+   unsigned char *pucBlocks;
+
+   /* The number of blocks, a power of two*/
+   size_t uBlockCount;
+};
+
+/* Takes in Filter_T oFilter and a size_t uHash and returns the
+block of oFilter that uHash uses*/
+static unsigned char *Filter_block(Filter_T oFilter, size_t uHash)
+{
+   return oFilter->pucBlocks
+      + (uHash & (oFilter->uBlockCount - 1)) * BLOCK_BYTES;
+}
+
+/* Takes in a size_t uHash and an int iProbe and returns the index,
+within its block, of counter iProbe of uHash*/
+static size_t Filter_counter(size_t uHash, int iProbe)
+{
+   size_t uMix = uHash * (size_t)FILTER_MULTIPLIER;
+
+   return (uMix >> (sizeof(size_t) * CHAR_BIT
+      - COUNTER_INDEX_BITS * (size_t)(iProbe + 1)))
+      & (BLOCK_COUNTERS - 1);
+}
+
+/* Takes in the unsigned char *pucBlock of a filter and a size_t
+uCounter and returns the value of that counter of pucBlock*/
+static unsigned Filter_get(unsigned char *pucBlock, size_t uCounter)
+{
+   return (pucBlock[uCounter / 2] >> (uCounter % 2 * 4)) & 0xF;
+}
+
+Filter_T Filter_new(size_t uExpected)
+{
+   Filter_T oFilter;
+   void *pvBlocks;
+   size_t uBlockCount = 1;
+
+   while (uBlockCount * HASHES_PER_BLOCK < uExpected){
+      if (uBlockCount > ((size_t)-1 / BLOCK_BYTES) / 2)
+         return NULL;
+      uBlockCount *= 2;
+   }
+
+   oFilter = malloc(sizeof(struct Filter));
+   if (oFilter == NULL)
+      return NULL;
+   if (posix_memalign(&pvBlocks, BLOCK_BYTES,
+         uBlockCount * BLOCK_BYTES) != 0){
+      free(oFilter);
+      return NULL;
+   }
+   oFilter->pucBlocks = pvBlocks;
+   memset(oFilter->pucBlocks, 0, uBlockCount * BLOCK_BYTES);
+   oFilter->uBlockCount = uBlockCount;
+   return oFilter;
+}
+
+void Filter_free(Filter_T oFilter)
+{
+   assert(oFilter != NULL);
+
+   free(oFilter->pucBlocks);
+   free(oFilter);
+}
+
+void Filter_add(Filter_T oFilter, size_t uHash)
+{
+   unsigned char *pucBlock;
+   size_t uCounter;
+   int iProbe;
+
+   assert(oFilter != NULL);
+
+   pucBlock = Filter_block(oFilter, uHash);
+   for (iProbe = 0; iProbe < PROBE_COUNT; iProbe++){
+      uCounter = Filter_counter(uHash, iProbe);
+      if (Filter_get(pucBlock, uCounter) < COUNTER_MAX)
+         pucBlock[uCounter / 2] = (unsigned char)
+            (pucBlock[uCounter / 2] + (1U << (uCounter % 2 * 4)));
+   }
+}
+
+void Filter_remove(Filter_T oFilter, size_t uHash)
+{
+   unsigned char *pucBlock;
+   size_t uCounter;
+   unsigned uValue;
+   int iProbe;
+
+   assert(oFilter != NULL);
+
+   pucBlock = Filter_block(oFilter, uHash);
+   for (iProbe = 0; iProbe < PROBE_COUNT; iProbe++){
+      uCounter = Filter_counter(uHash, iProbe);
+      uValue = Filter_get(pucBlock, uCounter);
+      assert(uValue > 0);
+      if (uValue > 0 && uValue < COUNTER_MAX)
+         pucBlock[uCounter / 2] = (unsigned char)
+            (pucBlock[uCounter / 2] - (1U << (uCounter % 2 * 4)));
+   }
+}
+
+int Filter_mayContain(Filter_T oFilter, size_t uHash)
+{
+   unsigned char *pucBlock;
+   int iProbe;
+
+   assert(oFilter != NULL);
+
+   pucBlock = Filter_block(oFilter, uHash);
+   for (iProbe = 0; iProbe < PROBE_COUNT; iProbe++)
+      if (Filter_get(pucBlock, Filter_counter(uHash, iProbe)) == 0)
+         return 0;
+   return 1;
+}
+
+size_t Filter_getCapacity(Filter_T oFilter)
+{
+   assert(oFilter != NULL);
+   return oFilter->uBlockCount * HASHES_PER_BLOCK;
+}
+
+size_t Filter_getBytes(Filter_T oFilter)
+{
+   assert(oFilter != NULL);
+   return sizeof(struct Filter) + oFilter->uBlockCount * BLOCK_BYTES;
+}
@@ -0,0 +1,48 @@
+/* Filter Interface, an approximate set of key hashes that a symbol
+table asks before looking for a key, so that most keys it does not
+hold are turned away without walking a chain. It can answer that a
+hash is present when it is not, never the other way round, and it
+supports removals*/
+#ifndef FILTER_INCLUDED
+#define FILTER_INCLUDED
+#include <stddef.h>
+
+/* For concision Filter_T is defined to
+be a pointer to a struct Filter*/
+typedef struct Filter *Filter_T;
+
+/* Filter_new takes in a size_t uExpected, the number of hashes
+expected, and returns a new, empty Filter_T sized to hold at least
+that many, a capacity rounded up to a power of two, or NULL if
+there is not enough memory */
+Filter_T Filter_new(size_t uExpected);
+
+/* Filter_free takes in a Filter_T oFilter and frees it. Returns
+nothing */
+void Filter_free(Filter_T oFilter);
+
+/* Filter_add takes in a Filter_T oFilter and a size_t uHash and
+adds uHash to oFilter, once more if it is there already. Returns
+nothing */
+void Filter_add(Filter_T oFilter, size_t uHash);
+
+/* Filter_remove takes in a Filter_T oFilter and a size_t uHash
+added to it by Filter_add and not removed since, and removes it
+once. Returns nothing */
+void Filter_remove(Filter_T oFilter, size_t uHash);
+
+/* Filter_mayContain takes in a Filter_T oFilter and a size_t uHash
+and returns 0 if uHash is certainly not in oFilter, 1 if it may be.
+It reads a single cache line of oFilter */
+int Filter_mayContain(Filter_T oFilter, size_t uHash);
+
+/* Filter_getCapacity takes in a Filter_T oFilter and returns the
+size_t number of hashes it was sized for. More can be added, but
+each one raises the rate of wrong answers */
+size_t Filter_getCapacity(Filter_T oFilter);
+
+/* Filter_getBytes takes in a Filter_T oFilter and returns the
+size_t number of bytes it occupies */
+size_t Filter_getBytes(Filter_T oFilter);
+
+#endif
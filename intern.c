@@ -0,0 +1,234 @@
+/* Intern implementation*/
+/* The pool is a chained hash table of entries, each followed in
+memory by its characters, so a string returned by Intern_addN leads
+straight back to its entry and releasing it needs no lookup of the
+characters. One mutex guards it all, taken by every function of
+the pool, Intern_find and Intern_getLength included. A table only
+calls into the pool, and so only takes the mutex, when it adds or
+drops a key*/
+#define _POSIX_C_SOURCE 200112L
+#include <assert.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "intern.h"
+#include "strhash.h"
+#include <string.h>
+
+/* The number of buckets of a new pool, a power of two, doubled
+whenever there are more strings than buckets*/
+enum {INITIAL_BUCKET_COUNT = 64};
+
+/* A string of the pool, its characters and null character right
+after the entry*/
+struct Entry
+{
+   /* The address of the next entry of the bucket*/
+   struct Entry *psNext;
+
+   /* StrHash_hash of the string*/
+   size_t uHash;
+
+   /* The number of characters of the string*/
+   size_t uLength;
+
+   /* The number of references to the string*/
+   size_t uRefs;
+};
+
+/* Intern is the pool*/
+struct Intern
+{
+   /* Guards everything below*/
+   pthread_mutex_t mutex;
+
+   /* The number of strings*/
+   size_t uLength;
+
+   /* The buckets, uBucketCount of them*/
+   struct Entry **apsBuckets;
+   size_t uBucketCount;
+};
+
+/* Takes in struct Entry *psEntry and returns its characters*/
+static char *Intern_chars(struct Entry *psEntry)
+{
+   return (char *)(psEntry + 1);
+}
+
+/* Takes in Intern_T oIntern, the string const char *pcKey of size_t
+uLength characters and its size_t uHash and returns its entry, or
+NULL if there is none. The mutex must be held*/
+static struct Entry *Intern_lookup(Intern_T oIntern,
+    const char *pcKey, size_t uLength, size_t uHash)
+{
+   struct Entry *psEntry;
+
+   for (psEntry = oIntern->apsBuckets[uHash
+            & (oIntern->uBucketCount - 1)];
+         psEntry != NULL; psEntry = psEntry->psNext)
+      if (psEntry->uHash == uHash && psEntry->uLength == uLength &&
+            memcmp(Intern_chars(psEntry), pcKey, uLength) == 0)
+         return psEntry;
+   return NULL;
+}
+
+/* Takes in Intern_T oIntern and doubles its buckets, which it keeps
+as they are if there is not enough memory. The mutex must be held.
+Returns nothing*/
+static void Intern_grow(Intern_T oIntern)
+{
+   struct Entry **apsBuckets;
+   struct Entry *psEntry;
+   struct Entry *psNext;
+   size_t uBucketCount = oIntern->uBucketCount * 2;
+   size_t i;
+
+   apsBuckets = calloc(uBucketCount, sizeof(struct Entry *));
+   if (apsBuckets == NULL)
+      return;
+   for (i = 0; i < oIntern->uBucketCount; i++)
+      for (psEntry = oIntern->apsBuckets[i]; psEntry != NULL;
+            psEntry = psNext){
+         psNext = psEntry->psNext;
+         psEntry->psNext =
+            apsBuckets[psEntry->uHash & (uBucketCount - 1)];
+         apsBuckets[psEntry->uHash & (uBucketCount - 1)] = psEntry;
+      }
+   free(oIntern->apsBuckets);
+   oIntern->apsBuckets = apsBuckets;
+   oIntern->uBucketCount = uBucketCount;
+}
+
+Intern_T Intern_new(void)
+{
+   Intern_T oIntern;
+
+   oIntern = malloc(sizeof(struct Intern));
+   if (oIntern == NULL)
+      return NULL;
+   oIntern->uLength = 0;
+   oIntern->uBucketCount = INITIAL_BUCKET_COUNT;
+   oIntern->apsBuckets = calloc(oIntern->uBucketCount,
+      sizeof(struct Entry *));
+   if (oIntern->apsBuckets == NULL){
+      free(oIntern);
+      return NULL;
+   }
+   pthread_mutex_init(&oIntern->mutex, NULL);
+   return oIntern;
+}
+
+void Intern_free(Intern_T oIntern)
+{
+   struct Entry *psEntry;
+   struct Entry *psNext;
+   size_t i;
+
+   assert(oIntern != NULL);
+
+   for (i = 0; i < oIntern->uBucketCount; i++)
+      for (psEntry = oIntern->apsBuckets[i]; psEntry != NULL;
+            psEntry = psNext){
+         psNext = psEntry->psNext;
+         free(psEntry);
+      }
+   pthread_mutex_destroy(&oIntern->mutex);
+   free(oIntern->apsBuckets);
+   free(oIntern);
+}
+
+const char *Intern_addN(Intern_T oIntern, const char *pcKey,
+    size_t uLength)
+{
+   struct Entry *psEntry;
+   struct Entry **ppsBucket;
+   size_t uHash;
+
+   assert(oIntern != NULL);
+   assert(pcKey != NULL);
+
+   /* Hashed before the lock is taken*/
+   uHash = StrHash_hash(pcKey, uLength);
+   pthread_mutex_lock(&oIntern->mutex);
+   psEntry = Intern_lookup(oIntern, pcKey, uLength, uHash);
+   if (psEntry != NULL){
+      psEntry->uRefs++;
+      pthread_mutex_unlock(&oIntern->mutex);
+      return Intern_chars(psEntry);
+   }
+
+   psEntry = malloc(sizeof(struct Entry) + uLength + 1);
+   if (psEntry == NULL){
+      pthread_mutex_unlock(&oIntern->mutex);
+      return NULL;
+   }
+   psEntry->uHash = uHash;
+   psEntry->uLength = uLength;
+   psEntry->uRefs = 1;
+   memcpy(Intern_chars(psEntry), pcKey, uLength);
+   Intern_chars(psEntry)[uLength] = '\0';
+   ppsBucket = &oIntern->apsBuckets[uHash
+      & (oIntern->uBucketCount - 1)];
+   psEntry->psNext = *ppsBucket;
+   *ppsBucket = psEntry;
+   oIntern->uLength++;
+   if (oIntern->uLength > oIntern->uBucketCount)
+      Intern_grow(oIntern);
+   pthread_mutex_unlock(&oIntern->mutex);
+   return Intern_chars(psEntry);
+}
+
+void Intern_release(Intern_T oIntern, const char *pcKey)
+{
+   struct Entry *psEntry;
+   struct Entry **ppsLink;
+
+   assert(oIntern != NULL);
+   assert(pcKey != NULL);
+
+   /* The entry sits right before its characters*/
+   psEntry = (struct Entry *)(void *)pcKey - 1;
+   pthread_mutex_lock(&oIntern->mutex);
+   assert(psEntry->uRefs > 0);
+   if (--psEntry->uRefs > 0){
+      pthread_mutex_unlock(&oIntern->mutex);
+      return;
+   }
+   for (ppsLink = &oIntern->apsBuckets[psEntry->uHash
+            & (oIntern->uBucketCount - 1)];
+         *ppsLink != psEntry; ppsLink = &(*ppsLink)->psNext)
+      assert(*ppsLink != NULL);
+   *ppsLink = psEntry->psNext;
+   oIntern->uLength--;
+   pthread_mutex_unlock(&oIntern->mutex);
+   free(psEntry);
+}
+
+const char *Intern_find(Intern_T oIntern, const char *pcKey)
+{
+   struct Entry *psEntry;
+   size_t uLength;
+   size_t uHash;
+
+   assert(oIntern != NULL);
+   assert(pcKey != NULL);
+
+   uLength = strlen(pcKey);
+   uHash = StrHash_hash(pcKey, uLength);
+   pthread_mutex_lock(&oIntern->mutex);
+   psEntry = Intern_lookup(oIntern, pcKey, uLength, uHash);
+   pthread_mutex_unlock(&oIntern->mutex);
+   return psEntry == NULL ? NULL : Intern_chars(psEntry);
+}
+
+size_t Intern_getLength(Intern_T oIntern)
+{
+   size_t uLength;
+
+   assert(oIntern != NULL);
+
+   pthread_mutex_lock(&oIntern->mutex);
+   uLength = oIntern->uLength;
+   pthread_mutex_unlock(&oIntern->mutex);
+   return uLength;
+}
@@ -0,0 +1,47 @@
+/* Intern Interface, a pool of strings that holds one shared,
+reference-counted copy of each, so that symbol tables opting into
+the same pool share their keys. Safe to use from several threads
+at once*/
+#ifndef INTERN_INCLUDED
+#define INTERN_INCLUDED
+#include <stddef.h>
+
+/* For concision Intern_T is defined to
+be a pointer to a struct Intern*/
+typedef struct Intern *Intern_T;
+
+/* Intern_new takes in nothing (void) and returns a new, empty
+Intern_T, or NULL if there is not enough memory */
+Intern_T Intern_new(void);
+
+/* Intern_free takes in an Intern_T oIntern and frees it with
+every string it holds, referenced or not, so every table using it
+must be freed first. Returns nothing */
+void Intern_free(Intern_T oIntern);
+
+/* Intern_addN takes in an Intern_T oIntern and a string const char
+*pcKey of size_t uLength characters, takes a reference to the copy
+of that string in oIntern, making the copy if there is none yet, and
+returns the null-terminated copy. The copy stays where it is until
+its last reference is released. Returns NULL if there is not enough
+memory */
+const char *Intern_addN(Intern_T oIntern, const char *pcKey,
+    size_t uLength);
+
+/* Intern_release takes in an Intern_T oIntern and a const char
+*pcKey returned by Intern_addN on it and drops one reference to
+pcKey, freeing it once none is left. Returns nothing */
+void Intern_release(Intern_T oIntern, const char *pcKey);
+
+/* Intern_find takes in an Intern_T oIntern and a string const char
+*pcKey and returns the copy of pcKey in oIntern without taking a
+reference, or NULL if there is none. A table of oIntern then finds
+the key by comparing that pointer instead of the characters. The
+copy is only valid as long as something references it */
+const char *Intern_find(Intern_T oIntern, const char *pcKey);
+
+/* Intern_getLength takes in an Intern_T oIntern and returns the
+size_t number of different strings it holds */
+size_t Intern_getLength(Intern_T oIntern);
+
+#endif
@@ -0,0 +1,84 @@
+/* Parallel implementation*/
+#define _POSIX_C_SOURCE 200112L
+#include <assert.h>
+#include <pthread.h>
+#include "parallel.h"
+
+/* The most threads Parallel_run starts, the calling one included*/
+enum {MAX_THREADS = 64};
+
+/* What every thread of one Parallel_run shares*/
+struct Work
+{
+   /* The number of items*/
+   size_t uCount;
+
+   /* The number of items claimed at a time*/
+   size_t uGrain;
+
+   /* The first item not claimed yet, only changed atomically*/
+   size_t uNext;
+
+   /* The function called on each range and its extra parameter*/
+   void (*pfRange)(size_t uStart, size_t uEnd, void *pvExtra);
+   void *pvExtra;
+};
+
+/* Takes in the struct Work *pvWork shares and calls its pfRange on
+one range after another until none is left. A thread done early
+simply claims more, so uneven ranges even out. Returns NULL*/
+static void *Parallel_work(void *pvWork)
+{
+   struct Work *psWork = pvWork;
+   size_t uStart;
+   size_t uEnd;
+
+   for (;;){
+      uStart = __atomic_fetch_add(&psWork->uNext, psWork->uGrain,
+         __ATOMIC_RELAXED);
+      if (uStart >= psWork->uCount)
+         break;
+      uEnd = psWork->uCount - uStart < psWork->uGrain ?
+         psWork->uCount : uStart + psWork->uGrain;
+      (*psWork->pfRange)(uStart, uEnd, psWork->pvExtra);
+   }
+   return NULL;
+}
+
+void Parallel_run(size_t uCount, size_t uGrain, int iThreads,
+    void (*pfRange)(size_t uStart, size_t uEnd, void *pvExtra),
+    void *pvExtra)
+{
+   pthread_t aThreads[MAX_THREADS];
+   struct Work sWork;
+   size_t uRanges;
+   int iStarted = 0;
+   int i;
+
+   assert(uGrain > 0);
+   assert(pfRange != NULL);
+
+   sWork.uCount = uCount;
+   sWork.uGrain = uGrain;
+   sWork.uNext = 0;
+   sWork.pfRange = pfRange;
+   sWork.pvExtra = pvExtra;
+
+   /* No more threads than ranges, the calling one being the first*/
+   uRanges = uCount / uGrain + (uCount % uGrain != 0);
+   if (iThreads < 1)
+      iThreads = 1;
+   if (iThreads > MAX_THREADS)
+      iThreads = MAX_THREADS;
+   if ((size_t)iThreads > uRanges)
+      iThreads = (int)uRanges;
+   for (i = 1; i < iThreads; i++){
+      if (pthread_create(&aThreads[iStarted], NULL, Parallel_work,
+            &sWork) != 0)
+         break;
+      iStarted++;
+   }
+   Parallel_work(&sWork);
+   for (i = 0; i < iStarted; i++)
+      pthread_join(aThreads[i], NULL);
+}
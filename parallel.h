@@ -0,0 +1,20 @@
+/* Parallel Interface, spreads the ranges of an index space over
+several threads, each claiming the next range not yet claimed as
+soon as it is done with one*/
+#ifndef PARALLEL_INCLUDED
+#define PARALLEL_INCLUDED
+#include <stddef.h>
+
+/* Parallel_run takes in a size_t uCount, the number of items, a
+size_t uGrain, the number of items claimed at a time, an int
+iThreads, function *pfRange(size_t uStart, size_t uEnd,
+void *pvExtra) and a void *pvExtra, and calls pfRange once for
+each range [uStart, uEnd) of at most uGrain items between 0 and
+uCount, from up to iThreads threads at once, the calling one among
+them. If fewer threads can be started the others do their share.
+Returns nothing once every range is done */
+void Parallel_run(size_t uCount, size_t uGrain, int iThreads,
+    void (*pfRange)(size_t uStart, size_t uEnd, void *pvExtra),
+    void *pvExtra);
+
+#endif
@@ -0,0 +1,15 @@
+/* Prefetch Interface, a hint to start loading memory that
+will be read soon*/
+#ifndef PREFETCH_INCLUDED
+#define PREFETCH_INCLUDED
+
+/* PREFETCH takes in an address pv and asks the processor to start
+bringing it into the cache, it never faults and compiles to nothing
+where the compiler has no prefetch builtin */
+#if defined(__GNUC__) && !defined(S_SPLINT_S)
+#define PREFETCH(pv) __builtin_prefetch(pv)
+#else
+#define PREFETCH(pv) ((void)(pv))
+#endif
+
+#endif
@@ -0,0 +1,122 @@
+/* String hash implementation, the XXH64 algorithm*/
+#include <assert.h>
+#include <limits.h>
+#include "strhash.h"
+#include <string.h>
+
+#if ULONG_MAX >> 31 >> 31 < 3
+#error "strhash.c needs a 64 bit unsigned long"
+#endif
+
+/* The five XXH64 primes*/
+static const unsigned long PRIME1 = 0x9E3779B185EBCA87UL;
+static const unsigned long PRIME2 = 0xC2B2AE3D27D4EB4FUL;
+static const unsigned long PRIME3 = 0x165667B19E3779F9UL;
+static const unsigned long PRIME4 = 0x85EBCA77C2B2AE63UL;
+static const unsigned long PRIME5 = 0x27D4EB2F165667C5UL;
+
+/* Takes in an unsigned long ulWord and an int iBits and returns
+ulWord rotated left by iBits*/
+static unsigned long StrHash_rotl(unsigned long ulWord, int iBits)
+{
+   return (ulWord << iBits) | (ulWord >> (64 - iBits));
+}
+
+/* Takes in a const char *pc and returns the 8 bytes
+starting there as one word, pc need not be aligned*/
+static unsigned long StrHash_read64(const char *pc)
+{
+   unsigned long ulWord;
+   memcpy(&ulWord, pc, sizeof(ulWord));
+   return ulWord;
+}
+
+/* Takes in a const char *pc and returns the 4 bytes
+starting there as one word*/
+static unsigned long StrHash_read32(const char *pc)
+{
+   unsigned int uWord;
+   memcpy(&uWord, pc, sizeof(uWord));
+   return (unsigned long)uWord;
+}
+
+/* Takes in an accumulator unsigned long ulAcc and the next input
+word unsigned long ulInput and returns the mixed accumulator*/
+static unsigned long StrHash_round(unsigned long ulAcc,
+   unsigned long ulInput)
+{
+   ulAcc += ulInput * PRIME2;
+   ulAcc = StrHash_rotl(ulAcc, 31);
+   return ulAcc * PRIME1;
+}
+
+/* Takes in the hash so far unsigned long ulHash and a lane
+accumulator unsigned long ulAcc and returns ulHash with ulAcc
+merged in*/
+static unsigned long StrHash_merge(unsigned long ulHash,
+   unsigned long ulAcc)
+{
+   ulHash ^= StrHash_round(0, ulAcc);
+   return ulHash * PRIME1 + PRIME4;
+}
+
+size_t StrHash_hash(const char *pcKey, size_t uLength)
+{
+   const char *pc = pcKey;
+   const char *pcEnd = pcKey + uLength;
+   unsigned long ulHash;
+   unsigned long ulAcc1;
+   unsigned long ulAcc2;
+   unsigned long ulAcc3;
+   unsigned long ulAcc4;
+
+   assert(pcKey != NULL || uLength == 0);
+
+   /* Long keys go through four independent lanes of 8 byte
+   words so the multiplies overlap*/
+   if (uLength >= 32){
+      ulAcc1 = PRIME1 + PRIME2;
+      ulAcc2 = PRIME2;
+      ulAcc3 = 0;
+      ulAcc4 = 0 - PRIME1;
+      do {
+         ulAcc1 = StrHash_round(ulAcc1, StrHash_read64(pc));
+         ulAcc2 = StrHash_round(ulAcc2, StrHash_read64(pc + 8));
+         ulAcc3 = StrHash_round(ulAcc3, StrHash_read64(pc + 16));
+         ulAcc4 = StrHash_round(ulAcc4, StrHash_read64(pc + 24));
+         pc += 32;
+      } while (pcEnd - pc >= 32);
+      ulHash = StrHash_rotl(ulAcc1, 1) + StrHash_rotl(ulAcc2, 7)
+         + StrHash_rotl(ulAcc3, 12) + StrHash_rotl(ulAcc4, 18);
+      ulHash = StrHash_merge(ulHash, ulAcc1);
+      ulHash = StrHash_merge(ulHash, ulAcc2);
+      ulHash = StrHash_merge(ulHash, ulAcc3);
+      ulHash = StrHash_merge(ulHash, ulAcc4);
+   }
+   else
+      ulHash = PRIME5;
+   ulHash += (unsigned long)uLength;
+
+   /* The rest a word, then half a word, then a byte at a time*/
+   for (; pcEnd - pc >= 8; pc += 8){
+      ulHash ^= StrHash_round(0, StrHash_read64(pc));
+      ulHash = StrHash_rotl(ulHash, 27) * PRIME1 + PRIME4;
+   }
+   if (pcEnd - pc >= 4){
+      ulHash ^= StrHash_read32(pc) * PRIME1;
+      ulHash = StrHash_rotl(ulHash, 23) * PRIME2 + PRIME3;
+      pc += 4;
+   }
+   for (; pc < pcEnd; pc++){
+      ulHash ^= (unsigned long)(unsigned char)*pc * PRIME5;
+      ulHash = StrHash_rotl(ulHash, 11) * PRIME1;
+   }
+
+   /* Final avalanche so every input bit reaches the low bits*/
+   ulHash ^= ulHash >> 33;
+   ulHash *= PRIME2;
+   ulHash ^= ulHash >> 29;
+   ulHash *= PRIME3;
+   ulHash ^= ulHash >> 32;
+   return (size_t)ulHash;
+}
@@ -0,0 +1,14 @@
+/* String Hash Interface, the default hash function
+of the hashing SymTable implementations*/
+#ifndef STRHASH_INCLUDED
+#define STRHASH_INCLUDED
+#include <stddef.h>
+
+/* StrHash_hash takes in a const char *pcKey and a size_t uLength,
+the number of bytes of pcKey to hash, and returns a size_t hash of
+those bytes. It reads the key a word at a time and mixes every bit
+of the key into every bit of the hash, so the low bits can be
+masked off directly as a power-of-two table index */
+size_t StrHash_hash(const char *pcKey, size_t uLength);
+
+#endif
@@ -2,15 +2,165 @@
 #ifndef SYMTABLE_INCLUDED
 #define SYMTABLE_INCLUDED
 #include <stddef.h>
+#include "intern.h"
 
 /* For concision SymTable_T is defined to 
 be a pointer to a struct SymTable*/
 typedef struct SymTable *SymTable_T;
 
+/* For concision SymTableIter_T is defined to be a pointer to a
+struct SymTableIter, a cursor over the bindings of a symbol table*/
+typedef struct SymTableIter *SymTableIter_T;
+
+/* The number of chain lengths SymTable_getStats counts one by one,
+every longer chain is counted with the last of them*/
+enum {SYMTABLE_STATS_CHAIN_LENGTHS = 16};
+
+/* How SymTable_setReorder lets a chain reorganize itself as keys
+are found in it: not at all, by moving the binding found to the
+front of its chain, or by swapping it with the binding before it*/
+enum SymTableReorder
+{
+   SYMTABLE_REORDER_NONE,
+   SYMTABLE_REORDER_MOVE_TO_FRONT,
+   SYMTABLE_REORDER_TRANSPOSE
+};
+
+/* What SymTable_getStats reports about a symbol table. The fields
+up to uBindingBytes are measured when it is called. The others are
+counters kept as the table is used, only when its implementation is
+compiled with SYMTABLE_STATS defined, and are 0 otherwise*/
+struct SymTableStats
+{
+   /* The number of bindings*/
+   size_t uLength;
+
+   /* The number of buckets, slots for open addressing and for
+   the index of the hybrid, 1 for the linked list which is a single
+   chain and for a hybrid table still small enough to be one*/
+   size_t uBucketCount;
+
+   /* Bindings per bucket*/
+   double dLoadFactor;
+
+   /* The most bindings in one bucket. For open addressing a chain
+   is the run of slots a lookup probes to reach a binding, and this
+   is the longest such run*/
+   size_t uLongestChain;
+
+   /* auChainLengths[i] is the number of buckets holding i bindings,
+   for open addressing the number of bindings reached after i
+   probes*/
+   size_t auChainLengths[SYMTABLE_STATS_CHAIN_LENGTHS];
+
+   /* Bytes held by the copies of the keys, short keys stored in
+   their binding included*/
+   size_t uKeyBytes;
+
+   /* Bytes held by the bindings, the bucket (or slot) arrays and
+   the filter of SymTable_setFilter*/
+   size_t uBindingBytes;
+
+   /* The number of calls of each operation, where putOrGet counts
+   as a put and each key of a batch as one call*/
+   unsigned long ulPuts;
+   unsigned long ulGets;
+   unsigned long ulReplaces;
+   unsigned long ulRemoves;
+   unsigned long ulContains;
+
+   /* The number of bindings (or slots) lookups have examined, for
+   open addressing the number of windows of slots whose control
+   bytes were compared at once*/
+   unsigned long ulProbes;
+
+   /* The number of lookups the filter of SymTable_setFilter
+   answered on its own, without examining any binding*/
+   unsigned long ulFilterRejects;
+
+   /* The number of resizes and the CPU time they took. For the
+   incremental expansion of the hash table this includes the
+   steps spread over the following operations*/
+   unsigned long ulResizes;
+   double dResizeSeconds;
+};
+
 /* SymTable_new(void) takes in nothing (void) and returns 
 a new symbol table SymTable_T object*/
 SymTable_T SymTable_new(void);
 
+/* SymTable_newWithArena takes in a size_t uHint, the number of
+bindings expected, and returns a new symbol table SymTable_T object
+whose bindings and key copies come from a per-table arena sized by
+uHint instead of one malloc each. Removed bindings are reused but
+the space of removed keys is only given back by SymTable_free,
+which releases the whole arena at once. Returns NULL if there is
+not enough memory*/
+SymTable_T SymTable_newWithArena(size_t uHint);
+
+/* SymTable_newWithHash takes in a hash function
+size_t (*pfHash)(const char *pcKey, size_t uLength), which hashes
+the uLength bytes at pcKey, and returns a new symbol table
+SymTable_T object that uses it in place of the default hash
+(implementations that do not hash keys ignore it). The low bits
+of the hash must be well mixed since buckets are found by masking.
+Returns NULL if there is not enough memory*/
+SymTable_T SymTable_newWithHash(
+    size_t (*pfHash)(const char *pcKey, size_t uLength));
+
+/* SymTable_newWithIntern takes in an Intern_T oIntern and returns a
+new symbol table SymTable_T object that keeps its keys in oIntern
+instead of copies of its own, so tables using the same pool share
+one reference-counted copy of each key. A key found by Intern_find
+is then recognized by its address before its characters are
+compared. oIntern must outlive the table. Returns NULL if there is
+not enough memory*/
+SymTable_T SymTable_newWithIntern(Intern_T oIntern);
+
+/* SymTable_newWithCapacity takes in a size_t uExpected, the number
+of bindings expected, and returns a new symbol table SymTable_T
+object that can hold that many, as if by SymTable_reserve, without
+ever resizing on the way. Returns NULL if there is not enough
+memory*/
+SymTable_T SymTable_newWithCapacity(size_t uExpected);
+
+/* SymTable_reserve takes in a SymTable_T oSymTable and a size_t
+uCount and sizes oSymTable at once so that it holds uCount bindings
+in all without resizing, and does not shrink below that size as
+bindings are removed (SymTable_compact still does). The linked list
+has no buckets and preallocates its bindings instead. Returns an
+int 1, or 0 if there is not enough memory in which case oSymTable
+still holds the same bindings*/
+int SymTable_reserve(SymTable_T oSymTable, size_t uCount);
+
+/* SymTable_setReorder takes in a SymTable_T oSymTable and an
+enum SymTableReorder eReorder and from then on has each successful
+SymTable_get (and getN and getBatch) of oSymTable move the binding
+found forward in its chain as eReorder says, so that the keys
+looked up most often are found after the fewest comparisons. Only
+the linked list and the bucket chains of the hash table reorder,
+the other implementations ignore it. A reordering get changes the
+table, so it must not be called on oSymTable from pfApply or while
+an iterator over the linked list is in use. New tables start with
+SYMTABLE_REORDER_NONE. Returns nothing (void)*/
+void SymTable_setReorder(SymTable_T oSymTable,
+    enum SymTableReorder eReorder);
+
+/* SymTable_setFilter takes in a SymTable_T oSymTable and an int
+iEnabled and, if iEnabled is nonzero, gives oSymTable a filter of
+the hashes of its keys that SymTable_get, contains, replace,
+remove and put ask first, so that most keys oSymTable does not hold
+are turned away after reading one cache line instead of walking a
+chain. The filter takes 8 to 16 bytes per binding, is kept up to
+date as bindings are put and removed, and is rebuilt twice as
+large, in time proportional to the number of bindings, each time
+they outgrow it.
+With iEnabled 0 the filter is freed. Only the linked list and the
+hash table keep a filter, the other implementations ignore it.
+Returns an int 1, or 0 if there is not enough memory in which case
+oSymTable is left as it was*/
+int SymTable_setFilter(SymTable_T oSymTable, int iEnabled);
+
 /* SymTable_free takes in a SymTable_T oSymTable, 
 frees the dynamic memory
 that the symbol table has and returns nothing (void) */
@@ -29,6 +179,18 @@ the symbol table 0 otherwise */
 int SymTable_put(SymTable_T oSymTable,
     const char *pcKey, const void *pvValue);
 
+/* SymTable_putOrGet takes in a SymTable_T oSymTable,
+the corresponding key value pair const char *pcKey,
+const void *pvValue and a void **ppvValue. If pcKey is not in
+the symbol table it inserts the pair, stores pvValue in *ppvValue
+and returns 1. If pcKey is already present nothing is changed,
+the existing value is stored in *ppvValue and 0 is returned.
+Returns -1 and leaves *ppvValue untouched if there is not enough
+memory. ppvValue may be NULL if the value is not needed.
+Either way the key is only looked up once */
+int SymTable_putOrGet(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue, void **ppvValue);
+
 /* SymTable_replace takes in a SymTable_T oSymTable,
 the corresponding key value pair 
 const char *pcKey, const void *pvValue,
@@ -60,6 +222,64 @@ and removes that binding from the symbol table else it returns NULL
 */
 void *SymTable_remove(SymTable_T oSymTable, const char *pcKey);
 
+/* SymTable_putN, SymTable_getN, SymTable_containsN,
+SymTable_removeN and SymTable_replaceN do what SymTable_put,
+SymTable_get, SymTable_contains, SymTable_remove and
+SymTable_replace do, but take the key as the size_t uLength
+characters at const char *pcKey, which need not be followed by a
+'\0', e.g. a slice of an input buffer, so it is neither copied nor
+scanned for its end. Those characters must not include a '\0'. The
+key is the same as the string of those characters, so a binding
+put with one form is found with the other
+*/
+int SymTable_putN(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, const void *pvValue);
+void *SymTable_getN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength);
+int SymTable_containsN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength);
+void *SymTable_removeN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength);
+void *SymTable_replaceN(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, const void *pvValue);
+
+
+/* SymTable_getBatch takes in a SymTable_T oSymTable, an array
+const char **ppcKeys of size_t uCount keys and an array
+void **ppvValues of uCount values, and stores in ppvValues[i]
+what SymTable_get would return for ppcKeys[i]. The lookups of
+independent keys are overlapped so their cache misses are not
+paid one after another. Returns nothing (void)
+*/
+void SymTable_getBatch(SymTable_T oSymTable, const char **ppcKeys,
+    size_t uCount, void **ppvValues);
+
+/* SymTable_putBatch takes in a SymTable_T oSymTable, an array
+const char **ppcKeys of size_t uCount keys and an array
+void **ppvValues of uCount values, and does SymTable_put for each
+pair in order, overlapping their lookups like SymTable_getBatch.
+Returns the size_t number of pairs that were inserted
+*/
+size_t SymTable_putBatch(SymTable_T oSymTable, const char **ppcKeys,
+    void **ppvValues, size_t uCount);
+
+/* SymTable_compact takes in a SymTable_T oSymTable and shrinks it
+right away to the fewest buckets that hold its bindings within the
+maximum load, freeing the rest. Tables also shrink on their own,
+by halves, as bindings are removed; this is for giving memory back
+at once, e.g. after a burst of removals. If there is not enough
+memory oSymTable is left as it was. Returns nothing (void)
+*/
+void SymTable_compact(SymTable_T oSymTable);
+
+/* SymTable_getStats takes in a SymTable_T oSymTable and a
+struct SymTableStats *psStats and fills *psStats with the shape of
+oSymTable and its counters, see struct SymTableStats. It walks
+every bucket, so it takes time proportional to their number.
+Returns nothing (void)
+*/
+void SymTable_getStats(SymTable_T oSymTable,
+    struct SymTableStats *psStats);
 
 /* SymTable_map takes in a SymTable_T oSymTable
 function *pfApply(const char *pcKey, void *pvValue, void *pvExtra)
@@ -70,4 +290,56 @@ void SymTable_map(SymTable_T oSymTable,
 void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
     const void *pvExtra);
 
+/* SymTable_mapParallel takes in a SymTable_T oSymTable, function
+*pfApply, const void *pvExtra and an int iThreads and applies
+pfApply to each binding like SymTable_map, but from up to iThreads
+threads at once, the calling one among them, that split the table
+between them. pfApply is called concurrently with itself, on
+different bindings in no particular order. The only calls it may
+make on oSymTable are SymTable_getLength, SymTable_get,
+SymTable_getN, SymTable_contains, SymTable_containsN and
+SymTable_getBatch, and those only if SymTable_setReorder has not
+made lookups reorder oSymTable. With SYMTABLE_STATS defined those
+lookups count atomically, so the counters stay exact. With iThreads
+at most 1 it is SymTable_map. Returns nothing (void)
+*/
+void SymTable_mapParallel(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra, int iThreads);
+
+/* SymTable_iterBegin takes in a SymTable_T oSymTable and returns a
+new SymTableIter_T positioned before the first binding of
+oSymTable, which SymTable_iterNext then visits in the order of
+SymTable_map, or NULL if there is not enough memory. Until
+SymTable_iterEnd oSymTable may only be changed through
+SymTable_iterRemove and SymTable_replace. The concurrent table is
+locked from SymTable_iterBegin to SymTable_iterEnd, and the thread
+iterating must not call anything else on it meanwhile
+*/
+SymTableIter_T SymTable_iterBegin(SymTable_T oSymTable);
+
+/* SymTable_iterNext takes in a SymTableIter_T oIter, a
+const char **ppcKey and a void **ppvValue, moves oIter to the next
+binding and stores its key and value in *ppcKey and *ppvValue,
+either of which may be NULL if not needed. Returns an int 1, or 0
+once every binding has been visited
+*/
+int SymTable_iterNext(SymTableIter_T oIter, const char **ppcKey,
+    void **ppvValue);
+
+/* SymTable_iterRemove takes in a SymTableIter_T oIter and removes
+the binding the last SymTable_iterNext moved it to from its table,
+the next SymTable_iterNext going on to the binding after it as if
+nothing had been removed. Returns the void * value of the removed
+binding, or NULL if oIter is at no binding: before the first
+SymTable_iterNext, right after a SymTable_iterRemove or at the end
+*/
+void *SymTable_iterRemove(SymTableIter_T oIter);
+
+/* SymTable_iterEnd takes in a SymTableIter_T oIter and frees it,
+after which its table may be used as usual again. Returns nothing
+(void)
+*/
+void SymTable_iterEnd(SymTableIter_T oIter);
+
 #endif
\ No newline at end of file
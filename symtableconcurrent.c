@@ -0,0 +1,1592 @@
+/* Symbol table concurrent hash table implementation*/
+/* Every function may be called from any number of threads at once
+on the same SymTable_T, except SymTable_free which must be the last
+call on a table. The buckets are split into STRIPE_COUNT stripes,
+each with its own mutex, so operations on keys in different stripes
+run in parallel. Expanding the table takes every stripe lock, so it
+never overlaps an operation in progress. SymTable_map holds every
+stripe lock while it runs, so pfApply may only look keys up in the
+same table, which the threads mapping it do without locking. Each
+thread keeps a stack of the tables it is mapping, maps of other
+tables nested in pfApply included, and the threads of
+SymTable_mapParallel share the stack of the one that started them.
+A table made by SymTable_newReadMostly is read without any lock:
+writers still take the stripe locks, but publish each change with
+a single atomic store, expansion builds a new bucket array of copied
+bindings instead of relinking the old ones, and anything a reader
+may still be walking is only freed after a grace period, once every
+reader that started before it was unlinked has finished*/
+#define _POSIX_C_SOURCE 200112L
+#include <assert.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include "symtableconcurrent.h"
+#include "arena.h"
+#include "strhash.h"
+#include "parallel.h"
+#include "symtablestats.h"
+#include <string.h>
+
+/* The number of stripes, a power of two. Stripe i guards every
+bucket whose index is i modulo STRIPE_COUNT, which stays true as
+the table doubles or halves since bucket counts are powers of two
+as well, never below INITIAL_BUCKET_SIZE*/
+enum {STRIPE_COUNT = 64};
+
+/* The number of buckets a new table starts with, a multiple of
+STRIPE_COUNT*/
+enum {INITIAL_BUCKET_SIZE = 512};
+
+/* Size stripes are padded to so two stripes never share a cache
+line*/
+enum {CACHE_LINE_SIZE = 64};
+
+/* The number of reader counters of a read-mostly table, a power
+of two. Threads are spread over them so readers seldom write the
+cache line of another thread*/
+enum {READER_SLOT_COUNT = 64};
+
+/* The number of removed bindings of a read-mostly table freed
+together after one grace period*/
+enum {RETIRE_BATCH = 64};
+
+/* SymTable_mapParallel hands out this many buckets at a time*/
+enum {MAP_GRAIN = 4096};
+
+/* The table is expanded once it holds more than
+SYMTABLE_MAX_LOAD_PERCENT bindings per 100 buckets,
+can be overridden at compile time with -D*/
+#ifndef SYMTABLE_MAX_LOAD_PERCENT
+#define SYMTABLE_MAX_LOAD_PERCENT 100
+#endif
+
+/* The table is shrunk to half its buckets, never below
+INITIAL_BUCKET_SIZE, once it holds fewer than
+SYMTABLE_MIN_LOAD_PERCENT bindings per 100 buckets, a quarter of
+the maximum so it never resizes back and forth around one size*/
+#ifndef SYMTABLE_MIN_LOAD_PERCENT
+#define SYMTABLE_MIN_LOAD_PERCENT (SYMTABLE_MAX_LOAD_PERCENT / 4)
+#endif
+
+/* Keys of fewer than SYMTABLE_INLINE_KEY_SIZE characters are stored
+inside their binding instead of in a copy of their own, can be
+overridden at compile time with -D*/
+#ifndef SYMTABLE_INLINE_KEY_SIZE
+#define SYMTABLE_INLINE_KEY_SIZE 16
+#endif
+
+/* Same structure as Binding in hash table implementation*/
+struct Binding
+{
+   /* Key*/
+   const char *pcKey;
+
+   /* Value*/
+   void *pvValue;
+
+   /* Full hash of the key*/
+   size_t uHash;
+
+   /* The address of the next Binding.*/
+   struct Binding *psNextBinding;
+
+   /* The number of characters of the key*/
+   size_t uLength;
+
+   /* A short key is copied here and pcKey points at it. A copy of
+   the binding points at its own acKey instead*/
+   char acKey[SYMTABLE_INLINE_KEY_SIZE];
+};
+
+/* The state one stripe lock guards*/
+struct StripeState
+{
+   /* Lock for every bucket of the stripe*/
+   pthread_mutex_t mutex;
+
+   /* The number of bindings in the stripe's buckets, only
+   written with the lock held*/
+   size_t length;
+
+   /* Arena the stripe's bindings and keys come from, NULL when
+   each one is malloc'd and freed on its own*/
+   Arena_T oArena;
+
+   /* The pool every key is interned in, NULL when the table
+   copies its own keys. The pool has a lock of its own*/
+   Intern_T oIntern;
+};
+
+/* A stripe padded out to its own cache line(s)*/
+union Stripe
+{
+   struct StripeState s;
+   char acPad[(sizeof(struct StripeState) + CACHE_LINE_SIZE - 1)
+      / CACHE_LINE_SIZE * CACHE_LINE_SIZE];
+};
+
+/* The bucket array with its size, replaced as a whole when the
+table expands so a reader without a lock never pairs an array
+with the size of another*/
+struct Buckets
+{
+   /* The number of buckets*/
+   size_t BucketSize;
+
+   /* Pointer to an array of BucketSize pointers to bindings*/
+   struct Binding **buckets;
+};
+
+/* The number of readers of a read-mostly table that entered in
+each of the two phases, padded out to its own cache line(s)*/
+union ReaderSlot
+{
+   size_t auReaders[2];
+   char acPad[(2 * sizeof(size_t) + CACHE_LINE_SIZE - 1)
+      / CACHE_LINE_SIZE * CACHE_LINE_SIZE];
+};
+
+/* SymTable is the chained hash table of symtablehash.c with its
+buckets guarded by striped locks*/
+struct SymTable
+{
+   /* The stripes*/
+   union Stripe aStripes[STRIPE_COUNT];
+
+   /* The buckets, only replaced with every stripe lock held*/
+   struct Buckets *psBuckets;
+
+   /* The fewest buckets the table shrinks back to on its own,
+   INITIAL_BUCKET_SIZE unless raised by SymTable_reserve. Only
+   changed with every stripe lock held*/
+   size_t BucketSizeMin;
+
+   /* Hash function applied to the keys*/
+   size_t (*pfHash)(const char *pcKey, size_t uLength);
+
+   /* Array of READER_SLOT_COUNT reader counters, NULL unless the
+   table is read-mostly*/
+   union ReaderSlot *asReaders;
+
+   /* Incremented to start each phase of a grace period, the
+   low bit picks the counter new readers enter on*/
+   size_t uPhase;
+
+   /* Lets one grace period run at a time, and guards
+   apsRetired and uRetired*/
+   pthread_mutex_t graceMutex;
+
+   /* Bindings removed from a read-mostly table that readers may
+   still see, the first uRetired of them*/
+   struct Binding *apsRetired[RETIRE_BATCH];
+
+   /* The number of bindings in apsRetired*/
+   size_t uRetired;
+
+   /* Nonzero while SymTable_map or SymTable_mapParallel holds every
+   stripe lock, only then do lookups check whether their thread is
+   one of those mapping the table*/
+   int iMapping;
+
+#ifdef SYMTABLE_STATS
+   /* The counters reported by SymTable_getStats, the resize ones
+   only written with every stripe lock held and the others
+   atomically*/
+   struct SymTableStats sStats;
+#endif
+};
+
+/* One map in progress on a thread, kept on the stack of the map
+call. The frames of a thread are linked from its innermost map
+out*/
+struct MapFrame
+{
+   /* The table mapped*/
+   SymTable_T oSymTable;
+
+   /* The map this one is nested in, NULL if none*/
+   struct MapFrame *psOuter;
+};
+
+/* What every thread of SymTable_mapParallel is given*/
+struct MapTask
+{
+   /* The frame of the map, which the threads make theirs*/
+   struct MapFrame *psFrame;
+
+   /* The buckets mapped*/
+   struct Buckets *psBuckets;
+
+   /* The function applied to each binding and its extra
+   parameter*/
+   void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra);
+   void *pvExtra;
+};
+
+/* A cursor over the buckets, holding every stripe lock of its
+table while it lives*/
+struct SymTableIter
+{
+   /* The table walked*/
+   SymTable_T oSymTable;
+
+   /* The bucket the cursor is in*/
+   size_t uBucket;
+
+   /* The link into the binding the cursor is at, or into the one
+   after it once it was removed*/
+   struct Binding **ppsLink;
+
+   /* The binding the cursor is at, NULL before the first one and
+   after it was removed*/
+   struct Binding *psCurrent;
+
+   /* Bindings removed from a read-mostly table that readers may
+   still see, the first uRetired of them. They are freed with the
+   locks still held, which readers never take*/
+   struct Binding *apsRetired[RETIRE_BATCH];
+
+   /* The number of bindings in apsRetired*/
+   size_t uRetired;
+};
+
+/* Each thread's reader slot, shared by every table, stored as the
+slot index plus 1 so that 0 (NULL) means not assigned yet*/
+static pthread_key_t readerSlotKey;
+
+/* Makes sure readerSlotKey is created once*/
+static pthread_once_t readerSlotOnce = PTHREAD_ONCE_INIT;
+
+/* Whether readerSlotKey could be created*/
+static int iReaderSlotKeyOk;
+
+/* The number of reader slots handed out so far*/
+static size_t uReaderSlotsAssigned;
+
+/* The innermost struct MapFrame of each thread, NULL if it is
+mapping no table*/
+static pthread_key_t mappingKey;
+
+/* Makes sure mappingKey is created once*/
+static pthread_once_t mappingOnce = PTHREAD_ONCE_INIT;
+
+/* Whether mappingKey could be created*/
+static int iMappingKeyOk;
+
+/* Hash Function takes in SymTable_T oSymTable and the key const
+char *pcKey of size_t uLength characters and returns the full
+size_t hash, computed before any lock is taken*/
+static size_t SymTable_hash(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength)
+{
+   assert(pcKey != NULL);
+   return (*oSymTable->pfHash)(pcKey, uLength);
+}
+
+/* Takes in struct Binding *psBinding and the key const char *pcKey
+of size_t uLength characters whose hash is uHash and returns 1 if
+psBinding holds that key, 0 otherwise. An interned key passed in
+is the very pointer stored*/
+static int SymTable_matches(struct Binding *psBinding,
+    const char *pcKey, size_t uLength, size_t uHash)
+{
+   return psBinding->uHash == uHash && psBinding->uLength == uLength
+      && (psBinding->pcKey == pcKey
+         || memcmp(psBinding->pcKey, pcKey, uLength) == 0);
+}
+
+/* Takes in SymTable_T oSymTable and a size_t uHash, locks the
+stripe that guards the bucket of uHash and returns it*/
+static struct StripeState *SymTable_lock(SymTable_T oSymTable,
+    size_t uHash)
+{
+   struct StripeState *psStripe;
+   psStripe = &oSymTable->aStripes[uHash & (STRIPE_COUNT - 1)].s;
+   pthread_mutex_lock(&psStripe->mutex);
+   return psStripe;
+}
+
+/* Takes in SymTable_T oSymTable and locks every stripe, always in
+the same order so two threads doing it cannot deadlock*/
+static void SymTable_lockAll(SymTable_T oSymTable)
+{
+   size_t i;
+   for (i = 0; i < STRIPE_COUNT; i++)
+      pthread_mutex_lock(&oSymTable->aStripes[i].s.mutex);
+}
+
+/* Takes in SymTable_T oSymTable and unlocks every stripe*/
+static void SymTable_unlockAll(SymTable_T oSymTable)
+{
+   size_t i;
+   for (i = STRIPE_COUNT; i > 0; i--)
+      pthread_mutex_unlock(&oSymTable->aStripes[i - 1].s.mutex);
+}
+
+/* Takes in SymTable_T oSymTable and a size_t uHash and returns the
+address of the head of its bucket, the stripe lock of uHash (or
+every lock) must be held*/
+static struct Binding **SymTable_bucket(SymTable_T oSymTable,
+    size_t uHash)
+{
+   struct Buckets *psBuckets = oSymTable->psBuckets;
+   return &psBuckets->buckets[uHash & (psBuckets->BucketSize - 1)];
+}
+
+/* Creates mappingKey, run once through mappingOnce*/
+static void SymTable_createMappingKey(void)
+{
+   iMappingKeyOk = pthread_key_create(&mappingKey, NULL) == 0;
+}
+
+/* Takes in SymTable_T oSymTable and returns 1 if the calling thread
+is mapping it, every stripe lock held for it, 0 otherwise*/
+static int SymTable_isMapping(SymTable_T oSymTable)
+{
+   struct MapFrame *psFrame;
+
+   if (! __atomic_load_n(&oSymTable->iMapping, __ATOMIC_ACQUIRE))
+      return 0;
+   for (psFrame = pthread_getspecific(mappingKey); psFrame != NULL;
+        psFrame = psFrame->psOuter)
+      if (psFrame->oSymTable == oSymTable)
+         return 1;
+   return 0;
+}
+
+/* Takes in SymTable_T oSymTable and the struct MapFrame *psFrame
+of a map of it about to start on the calling thread. Takes every
+stripe lock unless this thread holds them already for an outer map
+of the same table, and pushes psFrame on the maps of the thread.
+Returns 1 if it took the locks, 0 otherwise*/
+static int SymTable_beginMap(SymTable_T oSymTable,
+    struct MapFrame *psFrame)
+{
+   int iLocked;
+
+   pthread_once(&mappingOnce, SymTable_createMappingKey);
+   iLocked = ! SymTable_isMapping(oSymTable);
+   if (iLocked){
+      SymTable_lockAll(oSymTable);
+      if (iMappingKeyOk)
+         __atomic_store_n(&oSymTable->iMapping, 1, __ATOMIC_RELEASE);
+   }
+   psFrame->oSymTable = oSymTable;
+   psFrame->psOuter = NULL;
+   if (iMappingKeyOk){
+      psFrame->psOuter = pthread_getspecific(mappingKey);
+      pthread_setspecific(mappingKey, psFrame);
+   }
+   return iLocked;
+}
+
+/* Takes in SymTable_T oSymTable, the struct MapFrame *psFrame
+SymTable_beginMap pushed and the int iLocked it returned, pops
+psFrame and releases every stripe lock if SymTable_beginMap took
+them. Returns nothing*/
+static void SymTable_endMap(SymTable_T oSymTable,
+    struct MapFrame *psFrame, int iLocked)
+{
+   if (iMappingKeyOk)
+      pthread_setspecific(mappingKey, psFrame->psOuter);
+   if (iLocked){
+      __atomic_store_n(&oSymTable->iMapping, 0, __ATOMIC_RELEASE);
+      SymTable_unlockAll(oSymTable);
+   }
+}
+
+/* Creates readerSlotKey, run once through readerSlotOnce*/
+static void SymTable_createReaderSlotKey(void)
+{
+   iReaderSlotKeyOk = pthread_key_create(&readerSlotKey, NULL) == 0;
+}
+
+/* Takes in nothing and returns the reader slot of the calling
+thread, giving it the next one on its first read*/
+static size_t SymTable_readerSlot(void)
+{
+   size_t uSlot;
+   void *pvSlot;
+
+   pthread_once(&readerSlotOnce, SymTable_createReaderSlotKey);
+   if (! iReaderSlotKeyOk)
+      return 0;
+   pvSlot = pthread_getspecific(readerSlotKey);
+   if (pvSlot != NULL)
+      return (size_t)pvSlot - 1;
+   uSlot = __atomic_fetch_add(&uReaderSlotsAssigned, 1,
+      __ATOMIC_RELAXED) & (READER_SLOT_COUNT - 1);
+   pthread_setspecific(readerSlotKey, (void *)(uSlot + 1));
+   return uSlot;
+}
+
+/* Takes in a read-mostly SymTable_T oSymTable and counts the
+calling thread as one of its readers. Returns the counter to give
+back to SymTable_readUnlock. Never waits*/
+static size_t *SymTable_readLock(SymTable_T oSymTable)
+{
+   size_t *puReaders;
+   size_t uPhase;
+
+   uPhase = __atomic_load_n(&oSymTable->uPhase, __ATOMIC_RELAXED);
+   puReaders = &oSymTable->asReaders[SymTable_readerSlot()]
+      .auReaders[uPhase & 1];
+   /* A full barrier, so nothing the reader loads next can be older
+   than the count*/
+   __atomic_fetch_add(puReaders, 1, __ATOMIC_SEQ_CST);
+   return puReaders;
+}
+
+/* Takes in the size_t *puReaders SymTable_readLock returned and
+ends that read*/
+static void SymTable_readUnlock(size_t *puReaders)
+{
+   __atomic_fetch_sub(puReaders, 1, __ATOMIC_RELEASE);
+}
+
+/* Takes in a read-mostly SymTable_T oSymTable after bindings (or a
+bucket array) have been unlinked from it, and waits until every
+reader that could still see them is done, so they can be freed.
+Each of the two phases flips the counter new readers enter on and
+waits for the old one to drain. The second one catches a reader
+that read the phase just before the first flip and only then
+entered on the old counter*/
+static void SymTable_synchronize(SymTable_T oSymTable)
+{
+    size_t uReaders;
+    size_t uPhase;
+    size_t i;
+    int iFlip;
+
+    pthread_mutex_lock(&oSymTable->graceMutex);
+    for (iFlip = 0; iFlip < 2; iFlip++){
+        uPhase = __atomic_fetch_add(&oSymTable->uPhase, 1,
+            __ATOMIC_SEQ_CST) & 1;
+        for (;;){
+            uReaders = 0;
+            for (i = 0; i < READER_SLOT_COUNT; i++)
+                uReaders += __atomic_load_n(
+                    &oSymTable->asReaders[i].auReaders[uPhase],
+                    __ATOMIC_ACQUIRE);
+            if (uReaders == 0)
+                break;
+            sched_yield();
+        }
+    }
+    pthread_mutex_unlock(&oSymTable->graceMutex);
+}
+
+/* Takes in struct StripeState *psStripe and the key const char
+*pcKey of size_t uLength characters and returns a new binding
+holding a copy of pcKey, inline if it is short, taken from the
+arena of psStripe if it has one, or the interned pcKey if psStripe
+interns its keys. Returns NULL if there is not enough memory. The
+lock of psStripe must be held*/
+static struct Binding *SymTable_newBinding(struct StripeState *psStripe,
+    const char *pcKey, size_t uLength)
+{
+   struct Binding *psNewBinding;
+   char *pcKeyCopy;
+
+   if (psStripe->oArena != NULL)
+      psNewBinding = Arena_allocObject(psStripe->oArena);
+   else
+      psNewBinding = malloc(sizeof(struct Binding));
+   if (psNewBinding == NULL)
+      return NULL;
+
+   /* An interning table has no arenas*/
+   if (psStripe->oIntern != NULL){
+      psNewBinding->pcKey =
+         Intern_addN(psStripe->oIntern, pcKey, uLength);
+      if (psNewBinding->pcKey == NULL){
+         free(psNewBinding);
+         return NULL;
+      }
+      psNewBinding->uLength = uLength;
+      return psNewBinding;
+   }
+
+   if (uLength < SYMTABLE_INLINE_KEY_SIZE)
+      pcKeyCopy = psNewBinding->acKey;
+   else if (psStripe->oArena != NULL)
+      pcKeyCopy = Arena_copyStringN(psStripe->oArena, pcKey, uLength);
+   else
+      pcKeyCopy = malloc(uLength + 1);
+   if (pcKeyCopy == NULL){
+      if (psStripe->oArena != NULL)
+         Arena_freeObject(psStripe->oArena, psNewBinding);
+      else
+         free(psNewBinding);
+      return NULL;
+   }
+   memcpy(pcKeyCopy, pcKey, uLength);
+   pcKeyCopy[uLength] = '\0';
+   psNewBinding->pcKey = pcKeyCopy;
+   psNewBinding->uLength = uLength;
+   return psNewBinding;
+}
+
+/* Takes in struct StripeState *psStripe and struct Binding
+*psBinding, whose key was malloc'd unless it is inline or
+interned, and frees that key copy or releases it. Returns
+nothing*/
+static void SymTable_freeKey(struct StripeState *psStripe,
+    struct Binding *psBinding)
+{
+   if (psStripe->oIntern != NULL)
+      Intern_release(psStripe->oIntern, psBinding->pcKey);
+   else if (psBinding->pcKey != psBinding->acKey)
+      free((void *)psBinding->pcKey);
+}
+
+/* Takes in struct StripeState *psStripe and struct Binding
+*psBinding and frees psBinding and its key, or gives the binding
+back to the arena of psStripe. The lock of psStripe must be held*/
+static void SymTable_freeBinding(struct StripeState *psStripe,
+    struct Binding *psBinding)
+{
+   if (psStripe->oArena != NULL){
+      Arena_freeObject(psStripe->oArena, psBinding);
+      return;
+   }
+   SymTable_freeKey(psStripe, psBinding);
+   free(psBinding);
+}
+
+/* Takes in a read-mostly SymTable_T oSymTable and struct Binding
+*psBinding, just unlinked from it, and frees psBinding and its key
+once no reader can see them. Bindings are gathered RETIRE_BATCH at
+a time so one grace period covers the whole batch. No lock may be
+held*/
+static void SymTable_retire(SymTable_T oSymTable,
+    struct Binding *psBinding)
+{
+    struct Binding *apsBatch[RETIRE_BATCH];
+    struct StripeState *psStripe;
+    size_t i;
+
+    pthread_mutex_lock(&oSymTable->graceMutex);
+    oSymTable->apsRetired[oSymTable->uRetired++] = psBinding;
+    if (oSymTable->uRetired < RETIRE_BATCH){
+        pthread_mutex_unlock(&oSymTable->graceMutex);
+        return;
+    }
+    memcpy(apsBatch, oSymTable->apsRetired, sizeof(apsBatch));
+    oSymTable->uRetired = 0;
+    pthread_mutex_unlock(&oSymTable->graceMutex);
+
+    SymTable_synchronize(oSymTable);
+    for (i = 0; i < RETIRE_BATCH; i++){
+        psStripe = &oSymTable->aStripes[apsBatch[i]->uHash
+            & (STRIPE_COUNT - 1)].s;
+        /* The arena of the stripe is only used under its lock*/
+        if (psStripe->oArena != NULL){
+            pthread_mutex_lock(&psStripe->mutex);
+            SymTable_freeBinding(psStripe, apsBatch[i]);
+            pthread_mutex_unlock(&psStripe->mutex);
+        }
+        else
+            SymTable_freeBinding(psStripe, apsBatch[i]);
+    }
+}
+
+/* Takes in SymTable_T oSymTable and struct Binding *psBinding,
+a binding whose key another binding now owns (or holds its own
+copy of, if inline), and frees psBinding alone. Every stripe
+lock must be held*/
+static void SymTable_freeBindingOnly(SymTable_T oSymTable,
+    struct Binding *psBinding)
+{
+   struct StripeState *psStripe;
+
+   psStripe = &oSymTable->aStripes[psBinding->uHash
+      & (STRIPE_COUNT - 1)].s;
+   if (psStripe->oArena != NULL)
+      Arena_freeObject(psStripe->oArena, psBinding);
+   else
+      free(psBinding);
+}
+
+/* Takes in a struct StripeState *psStripe and returns its number
+of bindings, readable without its lock*/
+static size_t SymTable_stripeLength(struct StripeState *psStripe)
+{
+   return __atomic_load_n(&psStripe->length, __ATOMIC_RELAXED);
+}
+
+/* Takes in a struct StripeState *psStripe whose lock is held and a
+size_t uLength and sets its number of bindings to uLength*/
+static void SymTable_setStripeLength(struct StripeState *psStripe,
+    size_t uLength)
+{
+   __atomic_store_n(&psStripe->length, uLength, __ATOMIC_RELAXED);
+}
+
+/* Takes in SymTable_T oSymTable and struct Buckets *psBuckets and
+frees every binding of psBuckets but not their keys, which other
+bindings own. Every stripe
+lock must be held*/
+static void SymTable_freeBindingsOnly(SymTable_T oSymTable,
+    struct Buckets *psBuckets)
+{
+    struct Binding *psCurrentBinding;
+    struct Binding *psNextBinding;
+    size_t i;
+
+    for (i = 0; i < psBuckets->BucketSize; i++)
+        for (psCurrentBinding = psBuckets->buckets[i];
+                psCurrentBinding != NULL;
+                psCurrentBinding = psNextBinding){
+            psNextBinding = psCurrentBinding->psNextBinding;
+            SymTable_freeBindingOnly(oSymTable, psCurrentBinding);
+        }
+}
+
+/* Takes in SymTable_T oSymTable, struct Buckets *psOld, its current
+buckets, and struct Buckets *psNew, empty, and fills
+psNew with a copy of every binding of psOld sharing its key, leaving
+psOld untouched for the readers still walking it. Returns 1, or 0
+with psNew emptied again if there is not enough memory. Every
+stripe lock must be held*/
+static int SymTable_copyBuckets(SymTable_T oSymTable,
+    struct Buckets *psOld, struct Buckets *psNew)
+{
+    struct Binding *psCurrentBinding;
+    struct Binding *psCopy;
+    struct StripeState *psStripe;
+    size_t hash;
+    size_t i;
+
+    for (i = 0; i < psOld->BucketSize; i++)
+        for (psCurrentBinding = psOld->buckets[i];
+                psCurrentBinding != NULL;
+                psCurrentBinding = psCurrentBinding->psNextBinding){
+            psStripe = &oSymTable->aStripes[psCurrentBinding->uHash
+                & (STRIPE_COUNT - 1)].s;
+            if (psStripe->oArena != NULL)
+                psCopy = Arena_allocObject(psStripe->oArena);
+            else
+                psCopy = malloc(sizeof(struct Binding));
+            if (psCopy == NULL){
+                SymTable_freeBindingsOnly(oSymTable, psNew);
+                return 0;
+            }
+            *psCopy = *psCurrentBinding;
+            if (psCurrentBinding->pcKey == psCurrentBinding->acKey)
+                psCopy->pcKey = psCopy->acKey;
+            hash = psCopy->uHash & (psNew->BucketSize - 1);
+            psCopy->psNextBinding = psNew->buckets[hash];
+            psNew->buckets[hash] = psCopy;
+        }
+    return 1;
+}
+
+/* Takes in size_t uLength bindings held in size_t BucketSize
+buckets, size_t BucketSizeMin and int iCompact and returns the
+number of buckets the table should have: the fewest within the
+maximum load if iCompact, otherwise at least BucketSizeMin, twice
+as many past the maximum load and half as many below the minimum
+load. Returns BucketSize itself if the table is to be left as it
+is*/
+static size_t SymTable_targetSize(size_t uLength, size_t BucketSize,
+    size_t BucketSizeMin, int iCompact)
+{
+    size_t BucketSizeNew = INITIAL_BUCKET_SIZE;
+
+    if (iCompact){
+        while (uLength * 100 > BucketSizeNew * SYMTABLE_MAX_LOAD_PERCENT)
+            BucketSizeNew *= 2;
+        return BucketSizeNew < BucketSize ? BucketSizeNew : BucketSize;
+    }
+    if (BucketSize < BucketSizeMin)
+        return BucketSizeMin;
+    if (uLength * 100 > BucketSize * SYMTABLE_MAX_LOAD_PERCENT &&
+        BucketSize <= ((size_t)-1 / sizeof(struct Binding *)) / 2)
+        return BucketSize * 2;
+    if (BucketSize > BucketSizeMin &&
+        uLength * 100 < BucketSize * SYMTABLE_MIN_LOAD_PERCENT)
+        return BucketSize / 2;
+    return BucketSize;
+}
+
+/* Resize is a helper function that takes in SymTable_T oSymTable
+with no lock held and int iCompact, takes every stripe lock so no
+other operation is in progress, and gives the table the number of
+buckets SymTable_targetSize picks for it under those locks,
+repositioning the bindings by their cached hash. A read-mostly
+table gets copies of the bindings instead, and the old ones are
+freed once no reader can be walking them. Returns nothing (void).
+If there is not enough memory oSymTable is left as it was*/
+static void SymTable_Resize(SymTable_T oSymTable, int iCompact)
+{
+    struct Binding *psCurrentBinding;
+    struct Binding *psNextBinding;
+    struct Buckets *psOld;
+    struct Buckets *psNew;
+    size_t uLength = 0;
+    size_t BucketSizeNew;
+    size_t hash;
+    size_t i;
+    clock_t iStart;
+
+    SymTable_lockAll(oSymTable);
+    iStart = STATS_CLOCK();
+    psOld = oSymTable->psBuckets;
+
+    /* Another thread may have resized the table while this one
+    waited for the locks*/
+    for (i = 0; i < STRIPE_COUNT; i++)
+        uLength += oSymTable->aStripes[i].s.length;
+    if (iCompact)
+        oSymTable->BucketSizeMin = INITIAL_BUCKET_SIZE;
+    BucketSizeNew = SymTable_targetSize(uLength, psOld->BucketSize,
+        oSymTable->BucketSizeMin, iCompact);
+    if (BucketSizeNew == psOld->BucketSize){
+        SymTable_unlockAll(oSymTable);
+        return;
+    }
+
+    psNew = malloc(sizeof(struct Buckets));
+    if (psNew == NULL){
+        SymTable_unlockAll(oSymTable);
+        return;
+    }
+    psNew->BucketSize = BucketSizeNew;
+    psNew->buckets = calloc(psNew->BucketSize,
+        sizeof(struct Binding *));
+    if (psNew->buckets == NULL ||
+        (oSymTable->asReaders != NULL &&
+         ! SymTable_copyBuckets(oSymTable, psOld, psNew))){
+        free(psNew->buckets);
+        free(psNew);
+        SymTable_unlockAll(oSymTable);
+        return;
+    }
+
+    if (oSymTable->asReaders == NULL)
+        for (i = 0; i < psOld->BucketSize; i++)
+            for (psCurrentBinding = psOld->buckets[i];
+                    psCurrentBinding != NULL;
+                    psCurrentBinding = psNextBinding){
+                psNextBinding = psCurrentBinding->psNextBinding;
+                hash = psCurrentBinding->uHash
+                    & (psNew->BucketSize - 1);
+                psCurrentBinding->psNextBinding = psNew->buckets[hash];
+                psNew->buckets[hash] = psCurrentBinding;
+            }
+    __atomic_store_n(&oSymTable->psBuckets, psNew, __ATOMIC_RELEASE);
+
+    if (oSymTable->asReaders != NULL){
+        SymTable_synchronize(oSymTable);
+        SymTable_freeBindingsOnly(oSymTable, psOld);
+    }
+    free(psOld->buckets);
+    free(psOld);
+    STATS_ADD(oSymTable, ulResizes, 1);
+    STATS_ADD(oSymTable, dResizeSeconds, STATS_SECONDS(iStart));
+    SymTable_unlockAll(oSymTable);
+}
+
+SymTable_T SymTable_new(void)
+{
+   SymTable_T oSymTable;
+   size_t i;
+
+   oSymTable = malloc(sizeof(struct SymTable));
+   if (oSymTable == NULL)
+      return NULL;
+
+   oSymTable->psBuckets = malloc(sizeof(struct Buckets));
+   if (oSymTable->psBuckets == NULL){
+      free(oSymTable);
+      return NULL;
+   }
+   oSymTable->psBuckets->BucketSize = INITIAL_BUCKET_SIZE;
+   oSymTable->psBuckets->buckets = calloc(INITIAL_BUCKET_SIZE,
+      sizeof(struct Binding *));
+   if (oSymTable->psBuckets->buckets == NULL){
+      free(oSymTable->psBuckets);
+      free(oSymTable);
+      return NULL;
+   }
+   oSymTable->BucketSizeMin = INITIAL_BUCKET_SIZE;
+   oSymTable->pfHash = StrHash_hash;
+   oSymTable->asReaders = NULL;
+   oSymTable->uPhase = 0;
+   oSymTable->uRetired = 0;
+   oSymTable->iMapping = 0;
+#ifdef SYMTABLE_STATS
+   memset(&oSymTable->sStats, 0, sizeof(struct SymTableStats));
+#endif
+   pthread_mutex_init(&oSymTable->graceMutex, NULL);
+   for (i = 0; i < STRIPE_COUNT; i++){
+      pthread_mutex_init(&oSymTable->aStripes[i].s.mutex, NULL);
+      oSymTable->aStripes[i].s.length = 0;
+      oSymTable->aStripes[i].s.oArena = NULL;
+      oSymTable->aStripes[i].s.oIntern = NULL;
+   }
+   return oSymTable;
+}
+
+SymTable_T SymTable_newReadMostly(void)
+{
+   SymTable_T oSymTable;
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+      return NULL;
+   oSymTable->asReaders = calloc(READER_SLOT_COUNT,
+      sizeof(union ReaderSlot));
+   if (oSymTable->asReaders == NULL){
+      SymTable_free(oSymTable);
+      return NULL;
+   }
+   return oSymTable;
+}
+
+SymTable_T SymTable_newWithArena(size_t uHint)
+{
+   SymTable_T oSymTable;
+   size_t i;
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+      return NULL;
+
+   /* One arena per stripe so the stripe lock is all an arena
+   needs*/
+   for (i = 0; i < STRIPE_COUNT; i++){
+      oSymTable->aStripes[i].s.oArena =
+         Arena_new(sizeof(struct Binding), uHint / STRIPE_COUNT);
+      if (oSymTable->aStripes[i].s.oArena == NULL){
+         SymTable_free(oSymTable);
+         return NULL;
+      }
+   }
+   return oSymTable;
+}
+
+SymTable_T SymTable_newWithCapacity(size_t uExpected)
+{
+   SymTable_T oSymTable;
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+      return NULL;
+
+   if (! SymTable_reserve(oSymTable, uExpected)){
+      SymTable_free(oSymTable);
+      return NULL;
+   }
+   return oSymTable;
+}
+
+SymTable_T SymTable_newWithHash(
+    size_t (*pfHash)(const char *pcKey, size_t uLength))
+{
+   SymTable_T oSymTable;
+   assert(pfHash != NULL);
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+      return NULL;
+   oSymTable->pfHash = pfHash;
+   return oSymTable;
+}
+
+SymTable_T SymTable_newWithIntern(Intern_T oIntern)
+{
+   SymTable_T oSymTable;
+   size_t i;
+   assert(oIntern != NULL);
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+      return NULL;
+   for (i = 0; i < STRIPE_COUNT; i++)
+      oSymTable->aStripes[i].s.oIntern = oIntern;
+   return oSymTable;
+}
+
+void SymTable_free(SymTable_T oSymTable)
+{
+   struct Binding *psCurrentBinding;
+   struct Binding *psNextBinding;
+   struct StripeState *psStripe;
+   struct Buckets *psBuckets;
+   size_t i;
+
+   assert(oSymTable != NULL);
+
+   psBuckets = oSymTable->psBuckets;
+   for (i = 0; i < psBuckets->BucketSize; i++){
+      psStripe = &oSymTable->aStripes[i & (STRIPE_COUNT - 1)].s;
+      if (psStripe->oArena != NULL)
+         continue;
+      for (psCurrentBinding = psBuckets->buckets[i];
+           psCurrentBinding != NULL;
+           psCurrentBinding = psNextBinding)
+      {
+         psNextBinding = psCurrentBinding->psNextBinding;
+         SymTable_freeKey(psStripe, psCurrentBinding);
+         free(psCurrentBinding);
+      }
+   }
+   for (i = 0; i < oSymTable->uRetired; i++){
+      psStripe = &oSymTable->aStripes[oSymTable->apsRetired[i]->uHash
+         & (STRIPE_COUNT - 1)].s;
+      SymTable_freeBinding(psStripe, oSymTable->apsRetired[i]);
+   }
+   for (i = 0; i < STRIPE_COUNT; i++){
+      psStripe = &oSymTable->aStripes[i].s;
+      if (psStripe->oArena != NULL)
+         Arena_free(psStripe->oArena);
+      pthread_mutex_destroy(&psStripe->mutex);
+   }
+   pthread_mutex_destroy(&oSymTable->graceMutex);
+   free(oSymTable->asReaders);
+   free(psBuckets->buckets);
+   free(psBuckets);
+   free(oSymTable);
+}
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+    size_t uLength = 0;
+    size_t i;
+
+    assert(oSymTable != NULL);
+
+    /* Each stripe count is exact, the sum is a snapshot only
+    when no other thread is modifying the table*/
+    for (i = 0; i < STRIPE_COUNT; i++)
+        uLength += SymTable_stripeLength(&oSymTable->aStripes[i].s);
+    return uLength;
+}
+
+/* Takes in SymTable_T oSymTable, const char *pcKey and its
+size_t uHash and returns the binding of pcKey or NULL if it is not
+present. The stripe lock of uHash must be held, or a read lock if
+the table is read-mostly, which is why every link is loaded
+atomically*/
+static struct Binding *SymTable_find(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, size_t uHash)
+{
+    struct Binding *psCurrentBinding;
+    struct Buckets *psBuckets;
+
+    psBuckets = __atomic_load_n(&oSymTable->psBuckets,
+        __ATOMIC_ACQUIRE);
+    for (psCurrentBinding = __atomic_load_n(&psBuckets->buckets[
+                uHash & (psBuckets->BucketSize - 1)], __ATOMIC_ACQUIRE);
+            psCurrentBinding != NULL;
+            psCurrentBinding = __atomic_load_n(
+                &psCurrentBinding->psNextBinding, __ATOMIC_ACQUIRE))
+    {
+        STATS_ADD_ATOMIC(oSymTable, ulProbes, 1);
+        if (SymTable_matches(psCurrentBinding, pcKey, uLength, uHash))
+            return psCurrentBinding;
+    }
+    return NULL;
+}
+
+/* Takes in SymTable_T oSymTable and the key const char *pcKey of
+size_t uLength characters and returns 1 with the value of pcKey in
+*ppvValue if it is present, or 0.
+Takes the stripe lock of pcKey, or only a read lock if the table is
+read-mostly*/
+static int SymTable_lookup(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength, void **ppvValue)
+{
+    struct StripeState *psStripe;
+    struct Binding *psBinding;
+    size_t *puReaders;
+    size_t uHash;
+
+    uHash = SymTable_hash(oSymTable, pcKey, uLength);
+    if (oSymTable->asReaders != NULL){
+        puReaders = SymTable_readLock(oSymTable);
+        psBinding = SymTable_find(oSymTable, pcKey, uLength, uHash);
+        if (psBinding != NULL)
+            *ppvValue = __atomic_load_n(&psBinding->pvValue,
+                __ATOMIC_ACQUIRE);
+        SymTable_readUnlock(puReaders);
+        return psBinding != NULL;
+    }
+
+    /* A lookup from pfApply of SymTable_map or SymTable_mapParallel
+    finds every stripe locked already, for the threads mapping*/
+    if (SymTable_isMapping(oSymTable)){
+        psBinding = SymTable_find(oSymTable, pcKey, uLength, uHash);
+        if (psBinding != NULL)
+            *ppvValue = psBinding->pvValue;
+        return psBinding != NULL;
+    }
+
+    psStripe = SymTable_lock(oSymTable, uHash);
+    psBinding = SymTable_find(oSymTable, pcKey, uLength, uHash);
+    if (psBinding != NULL)
+        *ppvValue = psBinding->pvValue;
+    pthread_mutex_unlock(&psStripe->mutex);
+    return psBinding != NULL;
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    return SymTable_containsN(oSymTable, pcKey, strlen(pcKey));
+}
+
+int SymTable_containsN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength)
+{
+    void *pvValue;
+    assert(oSymTable != NULL);
+    STATS_ADD_ATOMIC(oSymTable, ulContains, 1);
+    return SymTable_lookup(oSymTable, pcKey, uLength, &pvValue);
+}
+
+/* Takes in SymTable_T oSymTable, the key const char *pcKey of
+size_t uLength characters, its size_t uHash and const void
+*pvValue, and under the stripe lock
+of uHash walks the bucket once: if pcKey is present it stores the
+existing value in *ppvValue and returns 0, otherwise it puts the
+new binding at the beginning of that bucket, stores pvValue in
+*ppvValue and returns 1. Returns -1 if there is not enough memory.
+Expands the table afterwards if needed*/
+static int SymTable_insert(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength, size_t uHash, const void *pvValue, void **ppvValue)
+{
+    struct StripeState *psStripe;
+    struct Binding *psBinding;
+    struct Binding **ppsBucket;
+    size_t uStripeLength;
+    size_t BucketSize;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    assert(ppvValue != NULL);
+
+    STATS_ADD_ATOMIC(oSymTable, ulPuts, 1);
+    psStripe = SymTable_lock(oSymTable, uHash);
+    psBinding = SymTable_find(oSymTable, pcKey, uLength, uHash);
+    if (psBinding != NULL){
+        *ppvValue = psBinding->pvValue;
+        pthread_mutex_unlock(&psStripe->mutex);
+        return 0;
+    }
+
+    psBinding = SymTable_newBinding(psStripe, pcKey, uLength);
+    if (psBinding == NULL){
+        pthread_mutex_unlock(&psStripe->mutex);
+        return -1;
+    }
+    ppsBucket = SymTable_bucket(oSymTable, uHash);
+    psBinding->pvValue = (void *)pvValue;
+    psBinding->uHash = uHash;
+    psBinding->psNextBinding = *ppsBucket;
+    /* Only publishes the binding once it is complete*/
+    __atomic_store_n(ppsBucket, psBinding, __ATOMIC_RELEASE);
+    uStripeLength = psStripe->length + 1;
+    SymTable_setStripeLength(psStripe, uStripeLength);
+    BucketSize = oSymTable->psBuckets->BucketSize;
+    pthread_mutex_unlock(&psStripe->mutex);
+    *ppvValue = (void *)pvValue;
+
+    /* Keys spread evenly over the stripes, so one stripe past its
+    share of the maximum load means the table is close to it. Only
+    then are the stripe counts summed, and SymTable_Resize checks
+    the real total again under every lock*/
+    if (uStripeLength * STRIPE_COUNT * 100 >
+            BucketSize * SYMTABLE_MAX_LOAD_PERCENT &&
+        SymTable_getLength(oSymTable) * 100 >
+            BucketSize * SYMTABLE_MAX_LOAD_PERCENT)
+        SymTable_Resize(oSymTable, 0);
+    return 1;
+}
+
+int SymTable_put(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    return SymTable_putN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+int SymTable_putN(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, const void *pvValue)
+{
+    void *pvFound;
+    assert(oSymTable != NULL);
+    return SymTable_insert(oSymTable, pcKey, uLength,
+        SymTable_hash(oSymTable, pcKey, uLength), pvValue,
+        &pvFound) == 1;
+}
+
+int SymTable_putOrGet(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue, void **ppvValue)
+{
+    void *pvFound;
+    size_t uLength;
+    int iResult;
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    iResult = SymTable_insert(oSymTable, pcKey, uLength,
+        SymTable_hash(oSymTable, pcKey, uLength), pvValue, &pvFound);
+    if (iResult != -1 && ppvValue != NULL)
+        *ppvValue = pvFound;
+    return iResult;
+}
+
+void *SymTable_replace(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    return SymTable_replaceN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+void *SymTable_replaceN(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, const void *pvValue)
+{
+    struct StripeState *psStripe;
+    struct Binding *psBinding;
+    void *OldValue = NULL;
+    size_t uHash;
+
+    assert(oSymTable != NULL);
+    STATS_ADD_ATOMIC(oSymTable, ulReplaces, 1);
+    uHash = SymTable_hash(oSymTable, pcKey, uLength);
+    psStripe = SymTable_lock(oSymTable, uHash);
+    psBinding = SymTable_find(oSymTable, pcKey, uLength, uHash);
+    if (psBinding != NULL){
+        OldValue = psBinding->pvValue;
+        __atomic_store_n(&psBinding->pvValue, (void *)pvValue,
+            __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&psStripe->mutex);
+    return OldValue;
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    return SymTable_getN(oSymTable, pcKey, strlen(pcKey));
+}
+
+void *SymTable_getN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength)
+{
+    void *pvValue = NULL;
+    assert(oSymTable != NULL);
+    STATS_ADD_ATOMIC(oSymTable, ulGets, 1);
+    (void)SymTable_lookup(oSymTable, pcKey, uLength, &pvValue);
+    return pvValue;
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    return SymTable_removeN(oSymTable, pcKey, strlen(pcKey));
+}
+
+void *SymTable_removeN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength)
+{
+    struct StripeState *psStripe;
+    struct Binding *psCurrentBinding;
+    struct Binding *psRetired = NULL;
+    struct Binding **ppsLink;
+    void *value = NULL;
+    size_t uHash;
+    size_t uStripeLength;
+    size_t BucketSize;
+    size_t BucketSizeMin;
+
+    assert(oSymTable != NULL);
+    STATS_ADD_ATOMIC(oSymTable, ulRemoves, 1);
+    uHash = SymTable_hash(oSymTable, pcKey, uLength);
+    psStripe = SymTable_lock(oSymTable, uHash);
+
+    /* Walks the links into each binding of the bucket so the
+    first binding needs no special case*/
+    for (ppsLink = SymTable_bucket(oSymTable, uHash);
+            *ppsLink != NULL;
+            ppsLink = &(*ppsLink)->psNextBinding)
+    {
+        psCurrentBinding = *ppsLink;
+        STATS_ADD_ATOMIC(oSymTable, ulProbes, 1);
+        if (SymTable_matches(psCurrentBinding, pcKey, uLength, uHash)){
+            value = psCurrentBinding->pvValue;
+            __atomic_store_n(ppsLink, psCurrentBinding->psNextBinding,
+                __ATOMIC_RELEASE);
+            /* Readers may still be on the binding, which still
+            links to the rest of the bucket*/
+            if (oSymTable->asReaders != NULL)
+                psRetired = psCurrentBinding;
+            else
+                SymTable_freeBinding(psStripe, psCurrentBinding);
+            SymTable_setStripeLength(psStripe, psStripe->length - 1);
+            break;
+        }
+    }
+    uStripeLength = psStripe->length;
+    BucketSize = oSymTable->psBuckets->BucketSize;
+    BucketSizeMin = oSymTable->BucketSizeMin;
+    pthread_mutex_unlock(&psStripe->mutex);
+    if (psRetired != NULL)
+        SymTable_retire(oSymTable, psRetired);
+
+    /* The mirror image of the expansion check of SymTable_insert*/
+    if (BucketSize > BucketSizeMin &&
+        uStripeLength * STRIPE_COUNT * 100 <
+            BucketSize * SYMTABLE_MIN_LOAD_PERCENT &&
+        SymTable_getLength(oSymTable) * 100 <
+            BucketSize * SYMTABLE_MIN_LOAD_PERCENT)
+        SymTable_Resize(oSymTable, 0);
+    return value;
+}
+
+void SymTable_getBatch(SymTable_T oSymTable, const char **ppcKeys,
+    size_t uCount, void **ppvValues)
+{
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(ppcKeys != NULL || uCount == 0);
+    assert(ppvValues != NULL || uCount == 0);
+
+    /* Each key takes its own stripe lock, or read lock*/
+    for (i = 0; i < uCount; i++)
+        ppvValues[i] = SymTable_get(oSymTable, ppcKeys[i]);
+}
+
+size_t SymTable_putBatch(SymTable_T oSymTable, const char **ppcKeys,
+    void **ppvValues, size_t uCount)
+{
+    size_t uInserted = 0;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(ppcKeys != NULL || uCount == 0);
+    assert(ppvValues != NULL || uCount == 0);
+
+    for (i = 0; i < uCount; i++)
+        if (SymTable_put(oSymTable, ppcKeys[i], ppvValues[i]))
+            uInserted++;
+    return uInserted;
+}
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCount)
+{
+    struct StripeState *psStripe;
+    size_t BucketSizeNew = INITIAL_BUCKET_SIZE;
+    size_t uShare;
+    int iSuccess = 1;
+    size_t i;
+
+    assert(oSymTable != NULL);
+
+    if (uCount > (size_t)-1 / 100)
+        return 0;
+    while (uCount * 100 > BucketSizeNew * SYMTABLE_MAX_LOAD_PERCENT){
+        if (BucketSizeNew > ((size_t)-1 / sizeof(struct Binding *)) / 2)
+            return 0;
+        BucketSizeNew *= 2;
+    }
+
+    /* Each stripe arena gets its share of the bindings to come,
+    rounded up*/
+    uShare = uCount / STRIPE_COUNT + 1;
+    SymTable_lockAll(oSymTable);
+    if (BucketSizeNew > oSymTable->BucketSizeMin)
+        oSymTable->BucketSizeMin = BucketSizeNew;
+    for (i = 0; i < STRIPE_COUNT; i++){
+        psStripe = &oSymTable->aStripes[i].s;
+        if (psStripe->oArena != NULL && uShare > psStripe->length &&
+            ! Arena_reserveObjects(psStripe->oArena,
+                uShare - psStripe->length))
+            iSuccess = 0;
+    }
+    SymTable_unlockAll(oSymTable);
+
+    /* Grows the buckets to the new minimum*/
+    SymTable_Resize(oSymTable, 0);
+    if (__atomic_load_n(&oSymTable->psBuckets, __ATOMIC_ACQUIRE)
+            ->BucketSize < BucketSizeNew)
+        iSuccess = 0;
+    return iSuccess;
+}
+
+void SymTable_setReorder(SymTable_T oSymTable,
+    enum SymTableReorder eReorder)
+{
+   /* Reordering would turn every get into a write that needs the
+   stripe exclusively, so lookups leave the stripes as they are*/
+   assert(oSymTable != NULL);
+   (void)oSymTable;
+   (void)eReorder;
+}
+
+int SymTable_setFilter(SymTable_T oSymTable, int iEnabled)
+{
+   /* Readers of a read-mostly table take no lock, so they could
+   not read counters a writer is changing, and a filter per stripe
+   would cost each stripe a lock held for it alone*/
+   assert(oSymTable != NULL);
+   (void)oSymTable;
+   (void)iEnabled;
+   return 1;
+}
+
+void SymTable_compact(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+    SymTable_Resize(oSymTable, 1);
+}
+
+void SymTable_getStats(SymTable_T oSymTable,
+    struct SymTableStats *psStats)
+{
+    struct Binding *psCurrentBinding;
+    struct Buckets *psBuckets;
+    size_t uChain;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(psStats != NULL);
+
+    memset(psStats, 0, sizeof(struct SymTableStats));
+    SymTable_lockAll(oSymTable);
+#ifdef SYMTABLE_STATS
+    /* Readers of a read-mostly table count without any lock*/
+    psStats->ulPuts = __atomic_load_n(&oSymTable->sStats.ulPuts,
+        __ATOMIC_RELAXED);
+    psStats->ulGets = __atomic_load_n(&oSymTable->sStats.ulGets,
+        __ATOMIC_RELAXED);
+    psStats->ulReplaces = __atomic_load_n(
+        &oSymTable->sStats.ulReplaces, __ATOMIC_RELAXED);
+    psStats->ulRemoves = __atomic_load_n(
+        &oSymTable->sStats.ulRemoves, __ATOMIC_RELAXED);
+    psStats->ulContains = __atomic_load_n(
+        &oSymTable->sStats.ulContains, __ATOMIC_RELAXED);
+    psStats->ulProbes = __atomic_load_n(&oSymTable->sStats.ulProbes,
+        __ATOMIC_RELAXED);
+    psStats->ulResizes = oSymTable->sStats.ulResizes;
+    psStats->dResizeSeconds = oSymTable->sStats.dResizeSeconds;
+#endif
+    psBuckets = oSymTable->psBuckets;
+    for (i = 0; i < STRIPE_COUNT; i++)
+        psStats->uLength += oSymTable->aStripes[i].s.length;
+    psStats->uBucketCount = psBuckets->BucketSize;
+    psStats->dLoadFactor =
+        (double)psStats->uLength / (double)psBuckets->BucketSize;
+    for (i = 0; i < psBuckets->BucketSize; i++){
+        uChain = 0;
+        for (psCurrentBinding = psBuckets->buckets[i];
+                psCurrentBinding != NULL;
+                psCurrentBinding = psCurrentBinding->psNextBinding){
+            psStats->uKeyBytes += psCurrentBinding->uLength + 1;
+            uChain++;
+        }
+        if (uChain > psStats->uLongestChain)
+            psStats->uLongestChain = uChain;
+        if (uChain >= SYMTABLE_STATS_CHAIN_LENGTHS)
+            uChain = SYMTABLE_STATS_CHAIN_LENGTHS - 1;
+        psStats->auChainLengths[uChain]++;
+    }
+    psStats->uBindingBytes = psStats->uLength * sizeof(struct Binding)
+        + psBuckets->BucketSize * sizeof(struct Binding *);
+    SymTable_unlockAll(oSymTable);
+}
+
+void SymTable_map(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+    struct Binding *psCurrentBinding;
+    struct Buckets *psBuckets;
+    struct MapFrame sFrame;
+    int iLocked;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    /* Holds every stripe so the traversal sees one consistent
+    table, and lets the lookups of pfApply read it as it is*/
+    iLocked = SymTable_beginMap(oSymTable, &sFrame);
+    psBuckets = oSymTable->psBuckets;
+    for (i = 0; i < psBuckets->BucketSize; i++)
+        for (psCurrentBinding = psBuckets->buckets[i];
+                psCurrentBinding != NULL;
+                psCurrentBinding = psCurrentBinding->psNextBinding)
+            (*pfApply)(psCurrentBinding->pcKey,
+                psCurrentBinding->pvValue, (void *)pvExtra);
+    SymTable_endMap(oSymTable, &sFrame, iLocked);
+}
+
+/* Takes in size_t uStart, size_t uEnd and the struct MapTask
+*pvTask and applies its function to the bindings of buckets uStart
+to uEnd - 1. Returns nothing*/
+static void SymTable_mapTask(size_t uStart, size_t uEnd, void *pvTask)
+{
+    struct MapTask *psTask = pvTask;
+    struct Binding *psCurrentBinding;
+    struct MapFrame *psPrevious = NULL;
+    size_t i;
+
+    /* The thread that started the map holds the stripes for this
+    one too, those of the maps it is nested in included*/
+    if (iMappingKeyOk){
+        psPrevious = pthread_getspecific(mappingKey);
+        pthread_setspecific(mappingKey, psTask->psFrame);
+    }
+    for (i = uStart; i < uEnd; i++)
+        for (psCurrentBinding = psTask->psBuckets->buckets[i];
+                psCurrentBinding != NULL;
+                psCurrentBinding = psCurrentBinding->psNextBinding)
+            (*psTask->pfApply)(psCurrentBinding->pcKey,
+                psCurrentBinding->pvValue, psTask->pvExtra);
+    if (iMappingKeyOk)
+        pthread_setspecific(mappingKey, psPrevious);
+}
+
+void SymTable_mapParallel(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra, int iThreads)
+{
+    struct MapTask sTask;
+    struct MapFrame sFrame;
+    int iLocked;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    /* The calling thread holds every stripe for all of them, the
+    threads it starts only read, lookups of pfApply included*/
+    iLocked = SymTable_beginMap(oSymTable, &sFrame);
+    sTask.psFrame = &sFrame;
+    sTask.psBuckets = oSymTable->psBuckets;
+    sTask.pfApply = pfApply;
+    sTask.pvExtra = (void *)pvExtra;
+    Parallel_run(sTask.psBuckets->BucketSize, MAP_GRAIN, iThreads,
+        SymTable_mapTask, &sTask);
+    SymTable_endMap(oSymTable, &sFrame, iLocked);
+}
+
+SymTableIter_T SymTable_iterBegin(SymTable_T oSymTable)
+{
+    SymTableIter_T oIter;
+
+    assert(oSymTable != NULL);
+
+    oIter = malloc(sizeof(struct SymTableIter));
+    if (oIter == NULL)
+        return NULL;
+
+    /* Like SymTable_map, but the locks outlive the call*/
+    SymTable_lockAll(oSymTable);
+    oIter->oSymTable = oSymTable;
+    oIter->uBucket = 0;
+    oIter->ppsLink = &oSymTable->psBuckets->buckets[0];
+    oIter->psCurrent = NULL;
+    oIter->uRetired = 0;
+    return oIter;
+}
+
+int SymTable_iterNext(SymTableIter_T oIter, const char **ppcKey,
+    void **ppvValue)
+{
+    struct Buckets *psBuckets;
+
+    assert(oIter != NULL);
+
+    /* After a removal the link already leads to the next binding*/
+    psBuckets = oIter->oSymTable->psBuckets;
+    if (oIter->psCurrent != NULL)
+        oIter->ppsLink = &oIter->psCurrent->psNextBinding;
+    while (*oIter->ppsLink == NULL){
+        if (oIter->uBucket + 1 >= psBuckets->BucketSize){
+            oIter->psCurrent = NULL;
+            return 0;
+        }
+        oIter->uBucket++;
+        oIter->ppsLink = &psBuckets->buckets[oIter->uBucket];
+    }
+    oIter->psCurrent = *oIter->ppsLink;
+    if (ppcKey != NULL)
+        *ppcKey = oIter->psCurrent->pcKey;
+    if (ppvValue != NULL)
+        *ppvValue = oIter->psCurrent->pvValue;
+    return 1;
+}
+
+/* Takes in SymTableIter_T oIter of a read-mostly table and frees
+the bindings it removed, once no reader can see them. Returns
+nothing*/
+static void SymTable_iterFlush(SymTableIter_T oIter)
+{
+    SymTable_T oSymTable = oIter->oSymTable;
+    struct Binding *psBinding;
+    size_t i;
+
+    if (oIter->uRetired == 0)
+        return;
+    SymTable_synchronize(oSymTable);
+    for (i = 0; i < oIter->uRetired; i++){
+        psBinding = oIter->apsRetired[i];
+        SymTable_freeBinding(&oSymTable->aStripes[psBinding->uHash
+            & (STRIPE_COUNT - 1)].s, psBinding);
+    }
+    oIter->uRetired = 0;
+}
+
+void *SymTable_iterRemove(SymTableIter_T oIter)
+{
+    SymTable_T oSymTable;
+    struct StripeState *psStripe;
+    struct Binding *psCurrentBinding;
+    void *value;
+
+    assert(oIter != NULL);
+
+    psCurrentBinding = oIter->psCurrent;
+    if (psCurrentBinding == NULL)
+        return NULL;
+    oSymTable = oIter->oSymTable;
+    STATS_ADD_ATOMIC(oSymTable, ulRemoves, 1);
+
+    /* Unlinked as SymTable_removeN does. The table never shrinks
+    here, which would move the bindings not visited yet*/
+    value = psCurrentBinding->pvValue;
+    __atomic_store_n(oIter->ppsLink, psCurrentBinding->psNextBinding,
+        __ATOMIC_RELEASE);
+    psStripe = &oSymTable->aStripes[psCurrentBinding->uHash
+        & (STRIPE_COUNT - 1)].s;
+    SymTable_setStripeLength(psStripe, psStripe->length - 1);
+    if (oSymTable->asReaders != NULL){
+        oIter->apsRetired[oIter->uRetired++] = psCurrentBinding;
+        if (oIter->uRetired == RETIRE_BATCH)
+            SymTable_iterFlush(oIter);
+    }
+    else
+        SymTable_freeBinding(psStripe, psCurrentBinding);
+    oIter->psCurrent = NULL;
+    return value;
+}
+
+void SymTable_iterEnd(SymTableIter_T oIter)
+{
+    assert(oIter != NULL);
+
+    SymTable_iterFlush(oIter);
+    SymTable_unlockAll(oIter->oSymTable);
+    free(oIter);
+}
@@ -0,0 +1,27 @@
+/* Interface of the thread-safe symbol table of symtableconcurrent.c
+beyond the one of symtable.h.
+SymTable_map and SymTable_mapParallel hold every stripe lock while
+they run, so other threads cannot change the table meanwhile. Their
+pfApply may look bindings of the same table up (SymTable_get,
+SymTable_getN, SymTable_contains, SymTable_containsN,
+SymTable_getBatch and SymTable_getLength), which the threads mapping
+it do without taking a lock, but any call that changes the table
+from pfApply deadlocks. The same holds for maps nested in pfApply,
+of other tables or of the same one: lookups of every table being
+mapped are allowed from any of them*/
+#ifndef SYMTABLECONCURRENT_INCLUDED
+#define SYMTABLECONCURRENT_INCLUDED
+#include "symtable.h"
+
+/* SymTable_newReadMostly takes in nothing (void) and returns a new
+symbol table SymTable_T object for tables that are read far more
+often than they are written. SymTable_get, SymTable_contains and
+SymTable_getBatch on it take no lock and never wait, not even for
+a writer, and SymTable_replace never makes a reader wait. In
+exchange removed bindings are only freed in batches, once every
+reader that could still see them is done, and SymTable_remove
+(every so many calls) and expanding the table wait for those
+readers. Returns NULL if there is not enough memory*/
+SymTable_T SymTable_newReadMostly(void);
+
+#endif
@@ -2,11 +2,56 @@
 #include <assert.h>
 #include <stdlib.h>
 #include "symtable.h"
+#include "arena.h"
+#include "filter.h"
+#include "strhash.h"
+#include "prefetch.h"
+#include "parallel.h"
+#include "symtablestats.h"
 #include <string.h>
 
-/* The possible bucket sizes*/
-static const size_t BucketSize[]={509, 1021, 2039, 
-    4093, 8191, 16381, 32749, 65521};
+/* The number of buckets a new table starts with. Bucket sizes
+are powers of two so a bucket is the hash masked rather than
+taken modulo, and every expansion doubles the size*/
+enum {INITIAL_BUCKET_SIZE = 512};
+
+/* The table is expanded once it holds more than
+SYMTABLE_MAX_LOAD_PERCENT bindings per 100 buckets, 
+can be overridden at compile time with -D*/
+#ifndef SYMTABLE_MAX_LOAD_PERCENT
+#define SYMTABLE_MAX_LOAD_PERCENT 100
+#endif
+
+/* The table is shrunk to half its buckets, never below
+INITIAL_BUCKET_SIZE, once it holds fewer than
+SYMTABLE_MIN_LOAD_PERCENT bindings per 100 buckets. At a quarter
+of the maximum a resized table sits halfway between the two
+limits, so puts and removes around one size never resize it
+back and forth*/
+#ifndef SYMTABLE_MIN_LOAD_PERCENT
+#define SYMTABLE_MIN_LOAD_PERCENT (SYMTABLE_MAX_LOAD_PERCENT / 4)
+#endif
+
+/* While the table is being expanded each operation moves this many
+old buckets over, and skips at most REHASH_EMPTY_VISITS empty
+buckets per bucket moved, so no single call does a whole resize*/
+enum {REHASH_STEP = 4, REHASH_EMPTY_VISITS = 10};
+
+/* The batch functions work through the keys this many at a time:
+hash them all, prefetch their buckets, prefetch the first binding
+of each bucket and only then walk the chains, so the cache misses
+of independent keys overlap instead of following one another*/
+enum {BATCH_SIZE = 16};
+
+/* SymTable_mapParallel hands out this many bindings at a time*/
+enum {MAP_GRAIN = 1024};
+
+/* Keys of fewer than SYMTABLE_INLINE_KEY_SIZE characters are stored
+inside their binding instead of in a copy of their own, can be
+overridden at compile time with -D*/
+#ifndef SYMTABLE_INLINE_KEY_SIZE
+#define SYMTABLE_INLINE_KEY_SIZE 16
+#endif
 
 /* Same structure as Binding in linked list implementation*/
 struct Binding
@@ -17,8 +62,28 @@ struct Binding
    /* Value*/
    void * pvValue;
 
+   /* Full hash of the key, before it is reduced to a bucket,
+   so resizing never rehashes the key and a mismatching hash
+   rejects a binding without comparing keys*/
+   size_t uHash;
+
    /* The address of the next Binding.*/
    struct Binding *psNextBinding;
+
+   /* The bindings before and after this one in the iteration
+   order, newest first, a list of every binding that
+   SymTable_map and the iterators walk instead of the buckets*/
+   struct Binding *psPrevInOrder;
+   struct Binding *psNextInOrder;
+
+   /* The number of characters of the key, compared right after
+   the hash so keys of another length never reach memcmp*/
+   size_t uLength;
+
+   /* A short key is copied here and pcKey points at it, so it
+   takes no allocation of its own and comparing it touches no
+   memory beyond the binding*/
+   char acKey[SYMTABLE_INLINE_KEY_SIZE];
 };
 
 /* SymTable now has more parameters to allow for 
@@ -31,32 +96,370 @@ struct SymTable
    /* The number of buckets*/
    size_t BucketSize;
 
-   /* The current position in the BucketSize array
-   corresponding to the current BucketSize*/
-   /* Introduced to allow for not just one symbol table
-   but multiple */
+   /* BucketSize is INITIAL_BUCKET_SIZE doubled BucketIndex
+   times, one more per expansion and one fewer per shrink*/
    size_t BucketIndex;
 
+   /* The fewest buckets the table shrinks back to on its own,
+   INITIAL_BUCKET_SIZE unless raised by SymTable_reserve*/
+   size_t BucketSizeMin;
+
    /* Pointer to an array of pointer to bindings corresponding
    with the size BucketSize*/
    struct Binding **buckets;
+
+   /* While a resize is in progress the previous buckets,
+   their number, and the first of them that has not been moved
+   to buckets yet. bucketsOld is NULL otherwise*/
+   struct Binding **bucketsOld;
+   size_t BucketSizeOld;
+   size_t RehashIndex;
+
+   /* The first binding of the iteration order, NULL if there is
+   none. The order holds the bindings densely whatever the number
+   of buckets, and resizes leave it alone*/
+   struct Binding *psFirstInOrder;
+
+   /* Arena the bindings and keys are allocated from, NULL when
+   each one is malloc'd and freed on its own*/
+   Arena_T oArena;
+
+   /* The pool every key is interned in, NULL when the table
+   copies its own keys*/
+   Intern_T oIntern;
+
+   /* Hash function applied to the keys*/
+   size_t (*pfHash)(const char *pcKey, size_t uLength);
+
+   /* How lookups reorder the chain of a bucket as they find keys,
+   the iteration order is left alone*/
+   enum SymTableReorder eReorder;
+
+   /* The filter of the hashes of every key, asked before a bucket
+   is searched, NULL unless SymTable_setFilter enabled it*/
+   Filter_T oFilter;
+
+#ifdef SYMTABLE_STATS
+   /* The counters reported by SymTable_getStats*/
+   struct SymTableStats sStats;
+#endif
 };
 
-/* Hash Function used to get the corresponding bucket
-takes in const char *pcKey and size_t uBucketCount 
-and returns the corresponding  size_t hash*/
-static size_t SymTable_hash(const char *pcKey, size_t uBucketCount)
+/* What every thread of SymTable_mapParallel is given*/
+struct MapTask
 {
-   const size_t HASH_MULTIPLIER = 65599;
-   size_t u;
-   size_t uHash = 0;
+   /* The bindings, gathered from the iteration order beforehand*/
+   struct Binding **ppsBindings;
+
+   /* The function applied to each binding and its extra
+   parameter*/
+   void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra);
+   void *pvExtra;
+};
+
+/* A cursor over the iteration order*/
+struct SymTableIter
+{
+   /* The table walked*/
+   SymTable_T oSymTable;
+
+   /* The binding the cursor is at, NULL before the first one and
+   after it was removed*/
+   struct Binding *psCurrent;
+
+   /* The binding the next SymTable_iterNext returns, taken before
+   psCurrent can be removed*/
+   struct Binding *psNext;
+};
 
+/* Hash Function used to get the corresponding bucket
+takes in SymTable_T oSymTable and the key const char *pcKey of
+size_t uLength characters and returns the full size_t hash given
+by the hash function of oSymTable, the bucket is that hash masked
+by the number of buckets*/
+static size_t SymTable_hash(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength)
+{
    assert(pcKey != NULL);
+   return (*oSymTable->pfHash)(pcKey, uLength);
+}
+
+/* Takes in struct Binding *psBinding and the key const char *pcKey
+of size_t uLength characters whose hash is uHash and returns 1 if
+psBinding holds that key, 0 otherwise. An interned key passed in
+is the very pointer stored*/
+static int SymTable_matches(struct Binding *psBinding,
+    const char *pcKey, size_t uLength, size_t uHash)
+{
+   return psBinding->uHash == uHash && psBinding->uLength == uLength
+      && (psBinding->pcKey == pcKey
+         || memcmp(psBinding->pcKey, pcKey, uLength) == 0);
+}
+
+/* Takes in size_t uCurrent, the current number of buckets, and
+returns the number of buckets to expand to, twice as many.
+Returns 0 if that number of buckets cannot be represented*/
+static size_t SymTable_nextBucketSize(size_t uCurrent)
+{
+   if (uCurrent > ((size_t)-1 / sizeof(struct Binding *)) / 2)
+      return 0;
+   return uCurrent * 2;
+}
+
+/* Takes in SymTable_T oSymTable and the key const char *pcKey of
+size_t uLength characters and returns a new binding holding a copy
+of pcKey, inline if it is short, taken from the arena of oSymTable
+if it has one, or the interned pcKey if oSymTable interns its keys.
+Returns NULL if there is not enough memory*/
+static struct Binding *SymTable_newBinding(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength)
+{
+   struct Binding *psNewBinding;
+   char *pcKeyCopy;
+
+   if (oSymTable->oArena != NULL)
+      psNewBinding = Arena_allocObject(oSymTable->oArena);
+   else
+      psNewBinding = malloc(sizeof(struct Binding));
+   if (psNewBinding == NULL)
+      return NULL;
+
+   /* An interning table has no arena*/
+   if (oSymTable->oIntern != NULL){
+      psNewBinding->pcKey =
+         Intern_addN(oSymTable->oIntern, pcKey, uLength);
+      if (psNewBinding->pcKey == NULL){
+         free(psNewBinding);
+         return NULL;
+      }
+      psNewBinding->uLength = uLength;
+      return psNewBinding;
+   }
+
+   if (uLength < SYMTABLE_INLINE_KEY_SIZE)
+      pcKeyCopy = psNewBinding->acKey;
+   else if (oSymTable->oArena != NULL)
+      pcKeyCopy = Arena_copyStringN(oSymTable->oArena, pcKey, uLength);
+   else
+      pcKeyCopy = malloc(uLength + 1);
+   if (pcKeyCopy == NULL){
+      if (oSymTable->oArena != NULL)
+         Arena_freeObject(oSymTable->oArena, psNewBinding);
+      else
+         free(psNewBinding);
+      return NULL;
+   }
+   memcpy(pcKeyCopy, pcKey, uLength);
+   pcKeyCopy[uLength] = '\0';
+   psNewBinding->pcKey = pcKeyCopy;
+   psNewBinding->uLength = uLength;
+   return psNewBinding;
+}
+
+/* Takes in SymTable_T oSymTable and struct Binding *psBinding,
+whose key was malloc'd unless it is inline or interned, and frees
+that key copy or releases it. Returns nothing*/
+static void SymTable_freeKey(SymTable_T oSymTable,
+    struct Binding *psBinding)
+{
+   if (oSymTable->oIntern != NULL)
+      Intern_release(oSymTable->oIntern, psBinding->pcKey);
+   else if (psBinding->pcKey != psBinding->acKey)
+      free((void *)psBinding->pcKey);
+}
+
+/* Takes in SymTable_T oSymTable and struct Binding *psBinding
+and frees psBinding and its key, or gives the binding back to
+the arena of oSymTable (arena keys are only released with the
+arena). Returns nothing*/
+static void SymTable_freeBinding(SymTable_T oSymTable,
+    struct Binding *psBinding)
+{
+   if (oSymTable->oArena != NULL){
+      Arena_freeObject(oSymTable->oArena, psBinding);
+      return;
+   }
+   SymTable_freeKey(oSymTable, psBinding);
+   free(psBinding);
+}
+
+/* Takes in SymTable_T oSymTable and struct Binding *psBinding, new,
+and puts psBinding first in the iteration order. Returns nothing*/
+static void SymTable_linkOrder(SymTable_T oSymTable,
+    struct Binding *psBinding)
+{
+   psBinding->psPrevInOrder = NULL;
+   psBinding->psNextInOrder = oSymTable->psFirstInOrder;
+   if (oSymTable->psFirstInOrder != NULL)
+      oSymTable->psFirstInOrder->psPrevInOrder = psBinding;
+   oSymTable->psFirstInOrder = psBinding;
+}
+
+/* Takes in SymTable_T oSymTable and struct Binding *psBinding,
+about to be freed, and takes psBinding out of the iteration
+order. Returns nothing*/
+static void SymTable_unlinkOrder(SymTable_T oSymTable,
+    struct Binding *psBinding)
+{
+   if (psBinding->psPrevInOrder != NULL)
+      psBinding->psPrevInOrder->psNextInOrder =
+         psBinding->psNextInOrder;
+   else
+      oSymTable->psFirstInOrder = psBinding->psNextInOrder;
+   if (psBinding->psNextInOrder != NULL)
+      psBinding->psNextInOrder->psPrevInOrder =
+         psBinding->psPrevInOrder;
+}
+
+/* Takes in SymTable_T oSymTable and the full size_t uHash of a key
+and returns the address of the head of the bucket where that key
+is stored: the old bucket while it has not been moved yet,
+otherwise the bucket in buckets*/
+static struct Binding **SymTable_bucket(SymTable_T oSymTable,
+    size_t uHash)
+{
+   size_t hash;
+
+   if (oSymTable->bucketsOld != NULL){
+      hash = uHash & (oSymTable->BucketSizeOld - 1);
+      if (hash >= oSymTable->RehashIndex)
+         return &oSymTable->bucketsOld[hash];
+   }
+   return &oSymTable->buckets[uHash & (oSymTable->BucketSize - 1)];
+}
+
+/* Takes in enum SymTableReorder eReorder and, for a binding just
+found in a chain, the link struct Binding **ppsFirst to the first
+binding of that chain, the link **ppsPreviousLink to the binding
+before the one found (NULL if it is the first) and the link
+**ppsLink to the one found, and moves it to the front of the chain
+or swaps it with the binding before it as eReorder says. Returns
+nothing*/
+static void SymTable_reorder(enum SymTableReorder eReorder,
+    struct Binding **ppsFirst, struct Binding **ppsPreviousLink,
+    struct Binding **ppsLink)
+{
+   struct Binding *psBinding = *ppsLink;
+   struct Binding *psPrevious;
+
+   if (ppsPreviousLink == NULL)
+      return;
+   switch (eReorder){
+   case SYMTABLE_REORDER_MOVE_TO_FRONT:
+      *ppsLink = psBinding->psNextBinding;
+      psBinding->psNextBinding = *ppsFirst;
+      *ppsFirst = psBinding;
+      break;
+   case SYMTABLE_REORDER_TRANSPOSE:
+      psPrevious = *ppsPreviousLink;
+      psPrevious->psNextBinding = psBinding->psNextBinding;
+      psBinding->psNextBinding = psPrevious;
+      *ppsPreviousLink = psBinding;
+      break;
+   default:
+      break;
+   }
+}
+
+/* Takes in SymTable_T oSymTable and a size_t uExpected and replaces
+the filter of oSymTable with a new one sized for uExpected bindings
+holding the hash of each binding. Returns 1, or 0 if there is not
+enough memory in which case the filter is left as it was*/
+static int SymTable_buildFilter(SymTable_T oSymTable,
+    size_t uExpected)
+{
+   Filter_T oFilter;
+   struct Binding *psCurrentBinding;
 
-   for (u = 0; pcKey[u] != '\0'; u++)
-      uHash = uHash * HASH_MULTIPLIER + (size_t)pcKey[u];
+   oFilter = Filter_new(uExpected);
+   if (oFilter == NULL)
+      return 0;
+   for (psCurrentBinding = oSymTable->psFirstInOrder;
+         psCurrentBinding != NULL;
+         psCurrentBinding = psCurrentBinding->psNextInOrder)
+      Filter_add(oFilter, psCurrentBinding->uHash);
+   if (oSymTable->oFilter != NULL)
+      Filter_free(oSymTable->oFilter);
+   oSymTable->oFilter = oFilter;
+   return 1;
+}
+
+/* Takes in SymTable_T oSymTable, which has just counted a new
+binding whose key hashes to size_t uHash, and adds uHash to its
+filter if it has one, rebuilding the filter twice as large once
+the bindings outgrow it. Returns nothing*/
+static void SymTable_filterAdd(SymTable_T oSymTable, size_t uHash)
+{
+   if (oSymTable->oFilter == NULL)
+      return;
+   Filter_add(oSymTable->oFilter, uHash);
+   if (oSymTable->length > Filter_getCapacity(oSymTable->oFilter))
+      (void)SymTable_buildFilter(oSymTable, oSymTable->length);
+}
+
+/* Takes in SymTable_T oSymTable and the size_t uHash of the key of
+a binding being removed and removes uHash from its filter if it has
+one. Returns nothing*/
+static void SymTable_filterRemove(SymTable_T oSymTable, size_t uHash)
+{
+   if (oSymTable->oFilter != NULL)
+      Filter_remove(oSymTable->oFilter, uHash);
+}
+
+/* Takes in SymTable_T oSymTable and the size_t uHash of a key and
+returns 1 if the filter of oSymTable shows that no key with that
+hash is in oSymTable, 0 if it has no filter or the key may be
+there*/
+static int SymTable_filterRejects(SymTable_T oSymTable, size_t uHash)
+{
+   if (oSymTable->oFilter == NULL
+         || Filter_mayContain(oSymTable->oFilter, uHash))
+      return 0;
+   STATS_ADD_ATOMIC(oSymTable, ulFilterRejects, 1);
+   return 1;
+}
+
+/* Takes in SymTable_T oSymTable and a size_t uSteps and moves the
+bindings of up to uSteps old buckets into buckets using their
+cached hash, visiting at most REHASH_EMPTY_VISITS empty buckets per
+step. Once the last old bucket is moved the old array is freed.
+Returns nothing*/
+static void SymTable_rehashStep(SymTable_T oSymTable, size_t uSteps)
+{
+   struct Binding *psCurrentBinding;
+   struct Binding *psNextBinding;
+   size_t uEmptyVisits = uSteps * REHASH_EMPTY_VISITS;
+   size_t hash;
+   clock_t iStart = STATS_CLOCK();
 
-   return uHash % uBucketCount;
+   while (uSteps > 0 &&
+          oSymTable->RehashIndex < oSymTable->BucketSizeOld){
+      psCurrentBinding = oSymTable->bucketsOld[oSymTable->RehashIndex];
+      if (psCurrentBinding == NULL){
+         oSymTable->RehashIndex++;
+         if (--uEmptyVisits == 0)
+            break;
+         continue;
+      }
+      for (; psCurrentBinding != NULL;
+           psCurrentBinding = psNextBinding){
+         psNextBinding = psCurrentBinding->psNextBinding;
+         hash = psCurrentBinding->uHash & (oSymTable->BucketSize - 1);
+         psCurrentBinding->psNextBinding = oSymTable->buckets[hash];
+         oSymTable->buckets[hash] = psCurrentBinding;
+      }
+      oSymTable->bucketsOld[oSymTable->RehashIndex] = NULL;
+      oSymTable->RehashIndex++;
+      uSteps--;
+   }
+
+   if (oSymTable->RehashIndex == oSymTable->BucketSizeOld){
+      free(oSymTable->bucketsOld);
+      oSymTable->bucketsOld = NULL;
+      oSymTable->BucketSizeOld = 0;
+      oSymTable->RehashIndex = 0;
+   }
+   STATS_ADD(oSymTable, dResizeSeconds, STATS_SECONDS(iStart));
 }
 
 SymTable_T SymTable_new(void)
@@ -70,13 +473,80 @@ SymTable_T SymTable_new(void)
    
    /* Defines the various members of the struct */
    oSymTable->length = 0;
+   oSymTable->psFirstInOrder = NULL;
+   oSymTable->oArena = NULL;
+   oSymTable->oIntern = NULL;
+   oSymTable->bucketsOld = NULL;
+   oSymTable->BucketSizeOld = 0;
+   oSymTable->RehashIndex = 0;
+   oSymTable->pfHash = StrHash_hash;
+   oSymTable->eReorder = SYMTABLE_REORDER_NONE;
+   oSymTable->oFilter = NULL;
    oSymTable->BucketIndex=0;
-   oSymTable->BucketSize=BucketSize[oSymTable->BucketIndex];
+   oSymTable->BucketSize=INITIAL_BUCKET_SIZE;
+   oSymTable->BucketSizeMin=INITIAL_BUCKET_SIZE;
    oSymTable->buckets = calloc(oSymTable->BucketSize,sizeof(struct Binding*));
    if (oSymTable->buckets==NULL){
     free(oSymTable);
     return NULL;
    }
+#ifdef SYMTABLE_STATS
+   memset(&oSymTable->sStats, 0, sizeof(struct SymTableStats));
+#endif
+   return oSymTable;
+}
+
+SymTable_T SymTable_newWithArena(size_t uHint)
+{
+   SymTable_T oSymTable;
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+      return NULL;
+
+   oSymTable->oArena = Arena_new(sizeof(struct Binding), uHint);
+   if (oSymTable->oArena == NULL){
+      SymTable_free(oSymTable);
+      return NULL;
+   }
+   return oSymTable;
+}
+
+SymTable_T SymTable_newWithCapacity(size_t uExpected)
+{
+   SymTable_T oSymTable;
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+      return NULL;
+
+   if (! SymTable_reserve(oSymTable, uExpected)){
+      SymTable_free(oSymTable);
+      return NULL;
+   }
+   return oSymTable;
+}
+
+SymTable_T SymTable_newWithHash(
+    size_t (*pfHash)(const char *pcKey, size_t uLength))
+{
+   SymTable_T oSymTable;
+   assert(pfHash != NULL);
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+      return NULL;
+   oSymTable->pfHash = pfHash;
+   return oSymTable;
+}
+
+SymTable_T SymTable_newWithIntern(Intern_T oIntern)
+{
+   SymTable_T oSymTable;
+   assert(oIntern != NULL);
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+      return NULL;
+   oSymTable->oIntern = oIntern;
    return oSymTable;
 }
 
@@ -84,22 +554,33 @@ void SymTable_free(SymTable_T oSymTable)
 {
    struct Binding *psCurrentBinding;
    struct Binding *psNextBinding;
-   size_t i;
    assert(oSymTable != NULL);
+
+   if (oSymTable->oFilter != NULL)
+      Filter_free(oSymTable->oFilter);
+
+   /* With an arena every binding and key goes at once*/
+   if (oSymTable->oArena != NULL){
+      Arena_free(oSymTable->oArena);
+      free(oSymTable->bucketsOld);
+      free(oSymTable->buckets);
+      free(oSymTable);
+      return;
+   }
    
-   /* Loops through every bucket and every Binding
-   in each bucket and frees the key and binding*/
-   for (i=0; i<oSymTable->BucketSize; i++){
-    for (psCurrentBinding = oSymTable->buckets[i];
+   /* Walks the iteration order, which holds every binding
+   wherever an expansion in progress has put it, and frees the
+   key and binding*/
+   for (psCurrentBinding = oSymTable->psFirstInOrder;
             psCurrentBinding != NULL;
             psCurrentBinding = psNextBinding)
-    {
-        psNextBinding = psCurrentBinding->psNextBinding;
-        free((void *)psCurrentBinding->pcKey);
-        free(psCurrentBinding);
-    }
-}
+   {
+      psNextBinding = psCurrentBinding->psNextInOrder;
+      SymTable_freeKey(oSymTable, psCurrentBinding);
+      free(psCurrentBinding);
+   }
     /* Frees the remaning part of oSymTable*/
+    free(oSymTable->bucketsOld);
     free(oSymTable->buckets);
     free(oSymTable);
 }
@@ -110,18 +591,32 @@ size_t SymTable_getLength(SymTable_T oSymTable){
 }
 
 int SymTable_contains(SymTable_T oSymTable, const char *pcKey){
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    return SymTable_containsN(oSymTable, pcKey, strlen(pcKey));
+}
+
+int SymTable_containsN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength){
     struct Binding *psCurrentBinding;
     struct Binding *psNextBinding;
-    size_t hash = SymTable_hash(pcKey, oSymTable->BucketSize);
+    size_t uHash;
 
     assert(oSymTable != NULL);
+    STATS_ADD_ATOMIC(oSymTable, ulContains, 1);
+    if (oSymTable->bucketsOld != NULL)
+        SymTable_rehashStep(oSymTable, REHASH_STEP);
+    uHash = SymTable_hash(oSymTable, pcKey, uLength);
+    if (SymTable_filterRejects(oSymTable, uHash))
+        return 0;
     /* Loops through the linked list of the corresponding bucket
     and stops if it finds the matching key*/
-    for (psCurrentBinding = oSymTable->buckets[hash];
+    for (psCurrentBinding = *SymTable_bucket(oSymTable, uHash);
             psCurrentBinding != NULL;
             psCurrentBinding = psNextBinding)
     {
-        if (strcmp(psCurrentBinding->pcKey,pcKey)==0){
+        STATS_ADD_ATOMIC(oSymTable, ulProbes, 1);
+        if (SymTable_matches(psCurrentBinding, pcKey, uLength, uHash)){
             return 1;
         }
         psNextBinding = psCurrentBinding->psNextBinding;
@@ -130,102 +625,179 @@ int SymTable_contains(SymTable_T oSymTable, const char *pcKey){
 }
 
 /* Resize is a helper function that takes in 
-SymTable_T oSymTable and what it does it 
-modifies the buckets part of SymTable
-it expands the bucket size to the next value in
-BucketSize and repositions the bindings accordingly in
-this new buckets and returns nothing (void)
+SymTable_T oSymTable and size_t BucketSizeNew, a power of two, and
+what it does it starts moving the buckets part of SymTable
+to BucketSizeNew buckets, more to expand and fewer to shrink: the
+current buckets become bucketsOld and are moved over a few at a
+time by SymTable_rehashStep on the following operations, so no
+single operation pays for the whole resize. Returns nothing (void).
+If BucketSizeNew is 0 or there is not enough memory oSymTable is
+left as it was
 */
-static void SymTable_Resize(SymTable_T oSymTable){
-    struct Binding *psCurrentBinding;
-    struct Binding *psNextBinding;
-    size_t i;
+static void SymTable_Resize(SymTable_T oSymTable,
+    size_t BucketSizeNew){
     struct Binding **bucketsNew;
-    struct Binding **bucketsOld;
-    size_t hash;
+    size_t uSize;
+    clock_t iStart;
     
-    /* Updates the symbol table with the new bucket size and index
-    and callocs a new bucket*/
-    oSymTable->BucketIndex=(oSymTable->BucketIndex)+1;
-    oSymTable->BucketSize=BucketSize[oSymTable->BucketIndex];
-    bucketsNew = calloc(oSymTable->BucketSize,sizeof(struct Binding*));
+    /* A resize still in progress is finished first, this
+    only happens when the load doubles or halves before the few
+    buckets moved per operation have drained the old array*/
+    if (oSymTable->bucketsOld != NULL)
+        SymTable_rehashStep(oSymTable, oSymTable->BucketSizeOld);
+    iStart = STATS_CLOCK();
+
+    /* Callocs the new buckets before touching oSymTable so that
+    a failed resize leaves the table consistent*/
+    if (BucketSizeNew == 0)
+        return;
+    bucketsNew = calloc(BucketSizeNew,sizeof(struct Binding*));
     if (bucketsNew == NULL)
         return;
     
-    /* Loops through every bucket and each linkedlist in each bucket
-    and repositions the bindings into the new buckets in place*/
-    for (i=0; i<BucketSize[(oSymTable->BucketIndex)-1]; i++)
-        for (psCurrentBinding = oSymTable->buckets[i];
-                psCurrentBinding != NULL;
-                psCurrentBinding = psNextBinding){
-                    psNextBinding = psCurrentBinding->psNextBinding;
-                    hash = SymTable_hash(psCurrentBinding->pcKey, 
-                        oSymTable->BucketSize);
-                    psCurrentBinding->psNextBinding = bucketsNew[hash];
-                    bucketsNew[hash] = psCurrentBinding;
-                }
-    
-    /* Frees the old buckets and has the oSymTable point 
-    to the New Buckets*/
-    bucketsOld=oSymTable->buckets;
-    free(bucketsOld);
+    /* The current buckets are kept as the old buckets until
+    every binding has been moved into the new buckets*/
+    oSymTable->bucketsOld=oSymTable->buckets;
+    oSymTable->BucketSizeOld=oSymTable->BucketSize;
+    oSymTable->RehashIndex=0;
     oSymTable->buckets=bucketsNew;
+    for (uSize = BucketSizeNew; uSize > oSymTable->BucketSize;
+            uSize /= 2)
+        oSymTable->BucketIndex=(oSymTable->BucketIndex)+1;
+    for (uSize = BucketSizeNew; uSize < oSymTable->BucketSize;
+            uSize *= 2)
+        oSymTable->BucketIndex=(oSymTable->BucketIndex)-1;
+    oSymTable->BucketSize=BucketSizeNew;
+    STATS_ADD(oSymTable, ulResizes, 1);
+    STATS_ADD(oSymTable, dResizeSeconds, STATS_SECONDS(iStart));
 }
 
-int SymTable_put(SymTable_T oSymTable,
-    const char *pcKey, const void *pvValue){
+/* Takes in SymTable_T oSymTable, the key const char *pcKey of
+size_t uLength characters, its size_t uHash and const void
+*pvValue and walks its bucket once:
+if pcKey is present it stores the existing value in *ppvValue and
+returns 0, otherwise it puts the new binding at the beginning of
+that same bucket, stores pvValue in *ppvValue and returns 1.
+Returns -1 if there is not enough memory for the new binding*/
+static int SymTable_insert(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength, size_t uHash, const void *pvValue, void **ppvValue){
+        struct Binding *psCurrentBinding;
         struct Binding *psNewBinding;
-        size_t hash;
-        size_t bucketMax; 
+        struct Binding **ppsBucket;
+
         assert(oSymTable != NULL);
+        assert(pcKey != NULL);
+        assert(ppvValue != NULL);
+
+        STATS_ADD(oSymTable, ulPuts, 1);
+        if (oSymTable->bucketsOld != NULL)
+            SymTable_rehashStep(oSymTable, REHASH_STEP);
+        ppsBucket = SymTable_bucket(oSymTable, uHash);
 
-        /* If the current number of bindings is greater than the
-         current number
-        of buckets and number of bindings is less than bucketMax 
-        we resize buckets */
-        bucketMax=65521;
-        if(oSymTable->BucketSize<oSymTable->length && oSymTable->length<bucketMax){
-            SymTable_Resize(oSymTable);
+        /* A key the filter rejects cannot be in the bucket, which
+        is then not searched*/
+        for (psCurrentBinding = SymTable_filterRejects(oSymTable,
+                    uHash) ? NULL : *ppsBucket;
+                psCurrentBinding != NULL;
+                psCurrentBinding = psCurrentBinding->psNextBinding)
+        {
+            STATS_ADD_ATOMIC(oSymTable, ulProbes, 1);
+            if (SymTable_matches(psCurrentBinding, pcKey, uLength,
+                    uHash)){
+                *ppvValue = psCurrentBinding->pvValue;
+                return 0;
+            }
         }
-        
-        if (SymTable_contains(oSymTable, pcKey)==1)
-            return 0;
-        
-        psNewBinding = malloc(sizeof(struct Binding));
+
+        psNewBinding = SymTable_newBinding(oSymTable, pcKey, uLength);
         if (psNewBinding == NULL){
-            return 0;
+            return -1;
         }
         
-        /* Puts the new binding at the beginning of the corresponding
-        bucket linked list */
-        hash = SymTable_hash(pcKey, oSymTable->BucketSize);
-        psNewBinding->pcKey=strcpy(malloc(strlen(pcKey)+1),pcKey);
-        if (psNewBinding->pcKey==NULL){
-            free(psNewBinding);
-            return 0;
-        }
+        /* Puts the new binding at the beginning of the bucket
+        linked list that was just searched */
         psNewBinding->pvValue= (void *) pvValue;
-        psNewBinding->psNextBinding=oSymTable->buckets[hash];
-        oSymTable->buckets[hash]=psNewBinding;
+        psNewBinding->uHash=uHash;
+        psNewBinding->psNextBinding=*ppsBucket;
+        *ppsBucket=psNewBinding;
+        SymTable_linkOrder(oSymTable, psNewBinding);
         oSymTable->length=oSymTable->length+1;
-        return 1; 
+        SymTable_filterAdd(oSymTable, uHash);
+        *ppvValue = (void *) pvValue;
+
+        /* If the number of bindings is now past the maximum
+        load factor of the current number of buckets
+        we resize buckets, without any upper limit */
+        if(oSymTable->length * 100 >
+            oSymTable->BucketSize * SYMTABLE_MAX_LOAD_PERCENT){
+            SymTable_Resize(oSymTable,
+                SymTable_nextBucketSize(oSymTable->BucketSize));
+        }
+        return 1;
+    }
+
+int SymTable_put(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue){
+        assert(oSymTable != NULL);
+        assert(pcKey != NULL);
+        return SymTable_putN(oSymTable, pcKey, strlen(pcKey), pvValue);
+    }
+
+int SymTable_putN(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, const void *pvValue){
+        void *pvFound;
+        assert(oSymTable != NULL);
+        return SymTable_insert(oSymTable, pcKey, uLength,
+            SymTable_hash(oSymTable, pcKey, uLength), pvValue,
+            &pvFound) == 1;
+    }
+
+int SymTable_putOrGet(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue, void **ppvValue){
+        void *pvFound;
+        size_t uLength;
+        int iResult;
+        assert(oSymTable != NULL);
+        assert(pcKey != NULL);
+
+        uLength = strlen(pcKey);
+        iResult = SymTable_insert(oSymTable, pcKey, uLength,
+            SymTable_hash(oSymTable, pcKey, uLength), pvValue, &pvFound);
+        if (iResult != -1 && ppvValue != NULL)
+            *ppvValue = pvFound;
+        return iResult;
     }
 
 void *SymTable_replace(SymTable_T oSymTable,
     const char *pcKey, const void *pvValue){
+        assert(oSymTable != NULL);
+        assert(pcKey != NULL);
+        return SymTable_replaceN(oSymTable, pcKey, strlen(pcKey),
+            pvValue);
+    }
+
+void *SymTable_replaceN(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, const void *pvValue){
         struct Binding *psCurrentBinding;
         struct Binding *psNextBinding;
-        size_t hash;
+        size_t uHash;
         assert(oSymTable != NULL);
-        hash = SymTable_hash(pcKey, oSymTable->BucketSize);
+        STATS_ADD(oSymTable, ulReplaces, 1);
+        if (oSymTable->bucketsOld != NULL)
+            SymTable_rehashStep(oSymTable, REHASH_STEP);
+        uHash = SymTable_hash(oSymTable, pcKey, uLength);
+        if (SymTable_filterRejects(oSymTable, uHash))
+            return NULL;
         
         /* Loop through the corresponding linked list until we find the key 
         and replace its value with the new value and return the old value*/
-        for (psCurrentBinding = oSymTable->buckets[hash];
+        for (psCurrentBinding = *SymTable_bucket(oSymTable, uHash);
                 psCurrentBinding != NULL;
                 psCurrentBinding = psNextBinding)
         {
-            if (strcmp(psCurrentBinding->pcKey,pcKey)==0){
+            STATS_ADD_ATOMIC(oSymTable, ulProbes, 1);
+            if (SymTable_matches(psCurrentBinding, pcKey, uLength,
+                    uHash)){
                void * OldValue = psCurrentBinding->pvValue;
                psCurrentBinding->pvValue = (void *) pvValue;
                return OldValue; 
@@ -236,38 +808,82 @@ void *SymTable_replace(SymTable_T oSymTable,
     }
 
 void *SymTable_get(SymTable_T oSymTable, const char *pcKey){
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    return SymTable_getN(oSymTable, pcKey, strlen(pcKey));
+}
+
+void *SymTable_getN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength){
     struct Binding *psCurrentBinding;
-    struct Binding *psNextBinding;
-    size_t hash;
+    struct Binding **ppsBucket;
+    struct Binding **ppsLink;
+    struct Binding **ppsPreviousLink = NULL;
+    size_t uHash;
     
     assert(oSymTable != NULL);
-    hash= SymTable_hash(pcKey, oSymTable->BucketSize);
+    STATS_ADD_ATOMIC(oSymTable, ulGets, 1);
+    if (oSymTable->bucketsOld != NULL)
+        SymTable_rehashStep(oSymTable, REHASH_STEP);
+    uHash = SymTable_hash(oSymTable, pcKey, uLength);
+    if (SymTable_filterRejects(oSymTable, uHash))
+        return NULL;
     
     /* Same gist as SymTable_replace but this time we do not
-    replace anything*/
-    for (psCurrentBinding = oSymTable->buckets[hash];
-            psCurrentBinding != NULL;
-            psCurrentBinding = psNextBinding)
+    replace anything, only follows the links so that the binding
+    found can be moved forward in its chain*/
+    ppsBucket = SymTable_bucket(oSymTable, uHash);
+    for (ppsLink = ppsBucket; (psCurrentBinding = *ppsLink) != NULL;
+            ppsLink = &psCurrentBinding->psNextBinding)
     {
-        if (strcmp(psCurrentBinding->pcKey,pcKey)==0){
+        STATS_ADD_ATOMIC(oSymTable, ulProbes, 1);
+        if (SymTable_matches(psCurrentBinding, pcKey, uLength, uHash)){
+            SymTable_reorder(oSymTable->eReorder, ppsBucket,
+                ppsPreviousLink, ppsLink);
             return psCurrentBinding->pvValue;
         }
-        psNextBinding = psCurrentBinding->psNextBinding;
+        ppsPreviousLink = ppsLink;
     }
     return NULL;
 }
 
+/* Takes in SymTable_T oSymTable right after a binding was removed
+and, if it is now below its minimum load, starts shrinking it to
+half its buckets, never below BucketSizeMin. Returns nothing*/
+static void SymTable_shrinkIfSparse(SymTable_T oSymTable)
+{
+   if (oSymTable->BucketSize > oSymTable->BucketSizeMin &&
+       oSymTable->length * 100 <
+       oSymTable->BucketSize * SYMTABLE_MIN_LOAD_PERCENT)
+      SymTable_Resize(oSymTable, oSymTable->BucketSize / 2);
+}
+
 void *SymTable_remove(SymTable_T oSymTable, const char *pcKey){
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    return SymTable_removeN(oSymTable, pcKey, strlen(pcKey));
+}
+
+void *SymTable_removeN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength){
     struct Binding *psCurrentBinding;
     struct Binding *psPreviousBinding;
     struct Binding *psNextBinding;
-    size_t hash;
+    struct Binding **ppsBucket;
+    size_t uHash;
     
     assert(oSymTable != NULL);
-    hash= SymTable_hash(pcKey, oSymTable->BucketSize);
-    psCurrentBinding=oSymTable->buckets[hash];
+    STATS_ADD(oSymTable, ulRemoves, 1);
+    if (oSymTable->bucketsOld != NULL)
+        SymTable_rehashStep(oSymTable, REHASH_STEP);
+    uHash = SymTable_hash(oSymTable, pcKey, uLength);
+    if (SymTable_filterRejects(oSymTable, uHash))
+        return NULL;
+    ppsBucket = SymTable_bucket(oSymTable, uHash);
+    psCurrentBinding=*ppsBucket;
     if(psCurrentBinding==NULL)
         return NULL;
+    STATS_ADD_ATOMIC(oSymTable, ulProbes, 1);
     
     /* Did it by casework since first case is linked
     to buckets whereas the others we can just call
@@ -276,54 +892,423 @@ void *SymTable_remove(SymTable_T oSymTable, const char *pcKey){
     has the same key as the key passed in we remove it 
     and make the second binding the first one 
     and free the corresponding key and binding*/
-    if (strcmp(psCurrentBinding->pcKey,pcKey)==0){
+    if (SymTable_matches(psCurrentBinding, pcKey, uLength, uHash)){
         void * value = psCurrentBinding->pvValue;
         psNextBinding=psCurrentBinding->psNextBinding;
-        free((void *)(psCurrentBinding->pcKey));
-        free(psCurrentBinding);
-        oSymTable->buckets[hash] = psNextBinding;
+        SymTable_unlinkOrder(oSymTable, psCurrentBinding);
+        SymTable_filterRemove(oSymTable, uHash);
+        SymTable_freeBinding(oSymTable, psCurrentBinding);
+        *ppsBucket = psNextBinding;
         oSymTable->length=oSymTable->length-1;
+        SymTable_shrinkIfSparse(oSymTable);
         return value;
     }
     
     /* Same as above just now looping through the entire linked
     list*/
-    for (psPreviousBinding = oSymTable->buckets[hash];
+    for (psPreviousBinding = *ppsBucket;
             psPreviousBinding != NULL;
             psPreviousBinding = psCurrentBinding)
     {
         psCurrentBinding = psCurrentBinding->psNextBinding;
         if (psCurrentBinding==NULL)
             return NULL;
-        if (strcmp(psCurrentBinding->pcKey,pcKey)==0){
+        STATS_ADD_ATOMIC(oSymTable, ulProbes, 1);
+        if (SymTable_matches(psCurrentBinding, pcKey, uLength, uHash)){
             void * value = psCurrentBinding->pvValue;
             psNextBinding=psCurrentBinding->psNextBinding;
-            free((void *) (psCurrentBinding->pcKey));
-            free(psCurrentBinding);
+            SymTable_unlinkOrder(oSymTable, psCurrentBinding);
+            SymTable_filterRemove(oSymTable, uHash);
+            SymTable_freeBinding(oSymTable, psCurrentBinding);
             psPreviousBinding->psNextBinding=psNextBinding;
             oSymTable->length=oSymTable->length-1;
+            SymTable_shrinkIfSparse(oSymTable);
             return value; 
         }
     }
     return NULL;
 }
 
+void SymTable_getBatch(SymTable_T oSymTable, const char **ppcKeys,
+    size_t uCount, void **ppvValues){
+    struct Binding **appsBucket[BATCH_SIZE];
+    size_t auHash[BATCH_SIZE];
+    size_t auLength[BATCH_SIZE];
+    struct Binding *psCurrentBinding;
+    struct Binding **ppsLink;
+    struct Binding **ppsPreviousLink;
+    size_t uDone;
+    size_t uBatch;
+    size_t j;
+
+    assert(oSymTable != NULL);
+    assert(ppcKeys != NULL || uCount == 0);
+    assert(ppvValues != NULL || uCount == 0);
+
+    STATS_ADD_ATOMIC(oSymTable, ulGets, uCount);
+    if (oSymTable->bucketsOld != NULL)
+        SymTable_rehashStep(oSymTable, REHASH_STEP);
+
+    for (uDone = 0; uDone < uCount; uDone += uBatch){
+        uBatch = uCount - uDone;
+        if (uBatch > BATCH_SIZE)
+            uBatch = BATCH_SIZE;
+
+        /* Hashes every key and starts loading its bucket head,
+        leaving out the keys the filter rejects*/
+        for (j = 0; j < uBatch; j++){
+            auLength[j] = strlen(ppcKeys[uDone + j]);
+            auHash[j] = SymTable_hash(oSymTable, ppcKeys[uDone + j],
+                auLength[j]);
+            if (SymTable_filterRejects(oSymTable, auHash[j])){
+                appsBucket[j] = NULL;
+                continue;
+            }
+            appsBucket[j] = SymTable_bucket(oSymTable, auHash[j]);
+            PREFETCH(appsBucket[j]);
+        }
+
+        /* Starts loading the first binding of every bucket*/
+        for (j = 0; j < uBatch; j++)
+            if (appsBucket[j] != NULL)
+                PREFETCH(*appsBucket[j]);
+
+        /* Walks each chain, by now mostly from the cache*/
+        for (j = 0; j < uBatch; j++){
+            ppvValues[uDone + j] = NULL;
+            if (appsBucket[j] == NULL)
+                continue;
+            ppsPreviousLink = NULL;
+            for (ppsLink = appsBucket[j];
+                    (psCurrentBinding = *ppsLink) != NULL;
+                    ppsLink = &psCurrentBinding->psNextBinding)
+            {
+                STATS_ADD_ATOMIC(oSymTable, ulProbes, 1);
+                if (SymTable_matches(psCurrentBinding,
+                        ppcKeys[uDone + j], auLength[j], auHash[j])){
+                    ppvValues[uDone + j] = psCurrentBinding->pvValue;
+                    SymTable_reorder(oSymTable->eReorder,
+                        appsBucket[j], ppsPreviousLink, ppsLink);
+                    break;
+                }
+                ppsPreviousLink = ppsLink;
+            }
+        }
+    }
+}
+
+size_t SymTable_putBatch(SymTable_T oSymTable, const char **ppcKeys,
+    void **ppvValues, size_t uCount){
+    size_t auHash[BATCH_SIZE];
+    size_t auLength[BATCH_SIZE];
+    void *pvFound;
+    size_t uInserted = 0;
+    size_t uDone;
+    size_t uBatch;
+    size_t j;
+
+    assert(oSymTable != NULL);
+    assert(ppcKeys != NULL || uCount == 0);
+    assert(ppvValues != NULL || uCount == 0);
+
+    for (uDone = 0; uDone < uCount; uDone += uBatch){
+        uBatch = uCount - uDone;
+        if (uBatch > BATCH_SIZE)
+            uBatch = BATCH_SIZE;
+
+        /* Same prefetching as SymTable_getBatch, but the bucket is
+        looked up again for each insert since an insert can start
+        or advance an expansion*/
+        for (j = 0; j < uBatch; j++){
+            auLength[j] = strlen(ppcKeys[uDone + j]);
+            auHash[j] = SymTable_hash(oSymTable, ppcKeys[uDone + j],
+                auLength[j]);
+            PREFETCH(SymTable_bucket(oSymTable, auHash[j]));
+        }
+        for (j = 0; j < uBatch; j++)
+            PREFETCH(*SymTable_bucket(oSymTable, auHash[j]));
+        for (j = 0; j < uBatch; j++)
+            if (SymTable_insert(oSymTable, ppcKeys[uDone + j],
+                    auLength[j], auHash[j], ppvValues[uDone + j],
+                    &pvFound) == 1)
+                uInserted++;
+    }
+    return uInserted;
+}
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCount){
+    size_t BucketSizeNew = INITIAL_BUCKET_SIZE;
+
+    assert(oSymTable != NULL);
+
+    /* The fewest buckets that hold uCount bindings within the
+    maximum load, so the puts to come never resize*/
+    if (uCount > (size_t)-1 / 100)
+        return 0;
+    while (uCount * 100 > BucketSizeNew * SYMTABLE_MAX_LOAD_PERCENT){
+        BucketSizeNew = SymTable_nextBucketSize(BucketSizeNew);
+        if (BucketSizeNew == 0)
+            return 0;
+    }
+
+    /* The new buckets are filled right away rather than over the
+    next operations, the bulk load that follows would only pay for
+    it anyway*/
+    if (BucketSizeNew > oSymTable->BucketSize){
+        SymTable_Resize(oSymTable, BucketSizeNew);
+        if (oSymTable->BucketSize != BucketSizeNew)
+            return 0;
+        SymTable_rehashStep(oSymTable, oSymTable->BucketSizeOld);
+    }
+    if (BucketSizeNew > oSymTable->BucketSizeMin)
+        oSymTable->BucketSizeMin = BucketSizeNew;
+    if (oSymTable->oFilter != NULL &&
+            uCount > Filter_getCapacity(oSymTable->oFilter) &&
+            ! SymTable_buildFilter(oSymTable, uCount))
+        return 0;
+
+    if (oSymTable->oArena != NULL && uCount > oSymTable->length)
+        return Arena_reserveObjects(oSymTable->oArena,
+            uCount - oSymTable->length);
+    return 1;
+}
+
+void SymTable_setReorder(SymTable_T oSymTable,
+    enum SymTableReorder eReorder){
+    assert(oSymTable != NULL);
+    oSymTable->eReorder = eReorder;
+}
+
+int SymTable_setFilter(SymTable_T oSymTable, int iEnabled){
+    assert(oSymTable != NULL);
+
+    if (! iEnabled){
+        if (oSymTable->oFilter != NULL)
+            Filter_free(oSymTable->oFilter);
+        oSymTable->oFilter = NULL;
+        return 1;
+    }
+    if (oSymTable->oFilter != NULL)
+        return 1;
+    return SymTable_buildFilter(oSymTable, oSymTable->length);
+}
+
+void SymTable_compact(SymTable_T oSymTable){
+    size_t BucketSizeNew = INITIAL_BUCKET_SIZE;
+
+    assert(oSymTable != NULL);
+
+    /* The fewest buckets, on the same doubling progression, that
+    keep the table within its maximum load, whatever was reserved*/
+    oSymTable->BucketSizeMin = INITIAL_BUCKET_SIZE;
+    while (oSymTable->length * 100 >
+            BucketSizeNew * SYMTABLE_MAX_LOAD_PERCENT)
+        BucketSizeNew *= 2;
+    if (BucketSizeNew < oSymTable->BucketSize)
+        SymTable_Resize(oSymTable, BucketSizeNew);
+
+    /* Moves every remaining binding now rather than over the next
+    operations, so the old buckets are freed before returning*/
+    if (oSymTable->bucketsOld != NULL)
+        SymTable_rehashStep(oSymTable, oSymTable->BucketSizeOld);
+
+    /* The filter is rebuilt to fit the bindings left, which also
+    clears the counters that had stuck at their maximum*/
+    if (oSymTable->oFilter != NULL)
+        (void)SymTable_buildFilter(oSymTable, oSymTable->length);
+}
+
+/* Takes in struct SymTableStats *psStats and the first binding
+struct Binding *psFirst of a bucket and adds the bucket and its
+bindings to the shape figures of psStats. Returns nothing*/
+static void SymTable_countBucket(struct SymTableStats *psStats,
+    struct Binding *psFirst){
+    struct Binding *psCurrentBinding;
+    size_t uChain = 0;
+
+    for (psCurrentBinding = psFirst;
+            psCurrentBinding != NULL;
+            psCurrentBinding = psCurrentBinding->psNextBinding){
+        psStats->uKeyBytes += psCurrentBinding->uLength + 1;
+        uChain++;
+    }
+    if (uChain > psStats->uLongestChain)
+        psStats->uLongestChain = uChain;
+    if (uChain >= SYMTABLE_STATS_CHAIN_LENGTHS)
+        uChain = SYMTABLE_STATS_CHAIN_LENGTHS - 1;
+    psStats->auChainLengths[uChain]++;
+}
+
+void SymTable_getStats(SymTable_T oSymTable,
+    struct SymTableStats *psStats){
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(psStats != NULL);
+
+#ifdef SYMTABLE_STATS
+    *psStats = oSymTable->sStats;
+#else
+    memset(psStats, 0, sizeof(struct SymTableStats));
+#endif
+    psStats->uLength = oSymTable->length;
+    psStats->uBucketCount = oSymTable->BucketSize;
+    psStats->dLoadFactor =
+        (double)oSymTable->length / (double)oSymTable->BucketSize;
+    psStats->uLongestChain = 0;
+    memset(psStats->auChainLengths, 0, sizeof(psStats->auChainLengths));
+    psStats->uKeyBytes = 0;
+
+    /* During an expansion the old buckets not moved yet are
+    chains too, the ones already moved are not counted*/
+    for (i = oSymTable->RehashIndex; i < oSymTable->BucketSizeOld; i++)
+        SymTable_countBucket(psStats, oSymTable->bucketsOld[i]);
+    for (i = 0; i < oSymTable->BucketSize; i++)
+        SymTable_countBucket(psStats, oSymTable->buckets[i]);
+    psStats->uBindingBytes = oSymTable->length * sizeof(struct Binding)
+        + (oSymTable->BucketSize + oSymTable->BucketSizeOld)
+        * sizeof(struct Binding *);
+    if (oSymTable->oFilter != NULL)
+        psStats->uBindingBytes += Filter_getBytes(oSymTable->oFilter);
+}
+
 void SymTable_map(SymTable_T oSymTable,
     void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
     const void *pvExtra){
         struct Binding *psCurrentBinding;
-        size_t i;
         
         assert(oSymTable != NULL);
         assert(pfApply != NULL);
         
-        /* Applies the function to each binding*/
-        for (i=0; i<oSymTable->BucketSize; i++)
-            for (psCurrentBinding = oSymTable->buckets[i];
+        /* Applies the function to each binding in the iteration
+        order, which skips the empty buckets and needs no care for
+        an expansion in progress*/
+        for (psCurrentBinding = oSymTable->psFirstInOrder;
                 psCurrentBinding != NULL;
-                psCurrentBinding = psCurrentBinding->psNextBinding)
+                psCurrentBinding = psCurrentBinding->psNextInOrder)
             (*pfApply)((void*)psCurrentBinding->pcKey,(void*) 
             psCurrentBinding->pvValue,(void*)pvExtra);
     }
 
+/* Takes in size_t uStart, size_t uEnd and the struct MapTask
+*pvTask and applies its function to the bindings uStart to uEnd - 1
+of it. Returns nothing*/
+static void SymTable_mapTask(size_t uStart, size_t uEnd, void *pvTask)
+{
+    struct MapTask *psTask = pvTask;
+    size_t i;
+
+    for (i = uStart; i < uEnd; i++)
+        (*psTask->pfApply)(psTask->ppsBindings[i]->pcKey,
+            psTask->ppsBindings[i]->pvValue, psTask->pvExtra);
+}
+
+void SymTable_mapParallel(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra, int iThreads){
+    struct MapTask sTask;
+    struct Binding *psCurrentBinding;
+    size_t i = 0;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    if (iThreads <= 1){
+        SymTable_map(oSymTable, pfApply, pvExtra);
+        return;
+    }
+
+    /* A lookup moves buckets while a resize is in progress, so the
+    resize is finished first and lookups made by pfApply from
+    several threads at once only read the table*/
+    if (oSymTable->bucketsOld != NULL)
+        SymTable_rehashStep(oSymTable, oSymTable->BucketSizeOld);
+
+    /* The buckets could be split as they are, but chasing their
+    chains misses the cache at every binding, while the iteration
+    order mostly follows memory. One walk of it fills an array the
+    threads split instead*/
+    sTask.ppsBindings = malloc(oSymTable->length
+        * sizeof(struct Binding *));
+    if (sTask.ppsBindings == NULL){
+        SymTable_map(oSymTable, pfApply, pvExtra);
+        return;
+    }
+    for (psCurrentBinding = oSymTable->psFirstInOrder;
+            psCurrentBinding != NULL;
+            psCurrentBinding = psCurrentBinding->psNextInOrder)
+        sTask.ppsBindings[i++] = psCurrentBinding;
+    sTask.pfApply = pfApply;
+    sTask.pvExtra = (void *)pvExtra;
+    Parallel_run(oSymTable->length, MAP_GRAIN, iThreads,
+        SymTable_mapTask, &sTask);
+    free(sTask.ppsBindings);
+}
+
+SymTableIter_T SymTable_iterBegin(SymTable_T oSymTable){
+    SymTableIter_T oIter;
+
+    assert(oSymTable != NULL);
+
+    oIter = malloc(sizeof(struct SymTableIter));
+    if (oIter == NULL)
+        return NULL;
+    oIter->oSymTable = oSymTable;
+    oIter->psCurrent = NULL;
+    oIter->psNext = oSymTable->psFirstInOrder;
+    return oIter;
+}
+
+int SymTable_iterNext(SymTableIter_T oIter, const char **ppcKey,
+    void **ppvValue){
+    assert(oIter != NULL);
+
+    oIter->psCurrent = oIter->psNext;
+    if (oIter->psCurrent == NULL)
+        return 0;
+    oIter->psNext = oIter->psCurrent->psNextInOrder;
+    if (ppcKey != NULL)
+        *ppcKey = oIter->psCurrent->pcKey;
+    if (ppvValue != NULL)
+        *ppvValue = oIter->psCurrent->pvValue;
+    return 1;
+}
+
+void *SymTable_iterRemove(SymTableIter_T oIter){
+    SymTable_T oSymTable;
+    struct Binding *psCurrentBinding;
+    struct Binding **ppsLink;
+    void *value;
+
+    assert(oIter != NULL);
+
+    psCurrentBinding = oIter->psCurrent;
+    if (psCurrentBinding == NULL)
+        return NULL;
+    oSymTable = oIter->oSymTable;
+    STATS_ADD(oSymTable, ulRemoves, 1);
+
+    /* The cached hash leads to the bucket, where the binding is
+    found by its address without comparing a key. Shrinking only
+    moves bindings between buckets, the order and psNext stay*/
+    for (ppsLink = SymTable_bucket(oSymTable, psCurrentBinding->uHash);
+            *ppsLink != psCurrentBinding;
+            ppsLink = &(*ppsLink)->psNextBinding)
+        STATS_ADD_ATOMIC(oSymTable, ulProbes, 1);
+    value = psCurrentBinding->pvValue;
+    *ppsLink = psCurrentBinding->psNextBinding;
+    SymTable_unlinkOrder(oSymTable, psCurrentBinding);
+    SymTable_filterRemove(oSymTable, psCurrentBinding->uHash);
+    SymTable_freeBinding(oSymTable, psCurrentBinding);
+    oSymTable->length=oSymTable->length-1;
+    oIter->psCurrent = NULL;
+    SymTable_shrinkIfSparse(oSymTable);
+    return value;
+}
+
+void SymTable_iterEnd(SymTableIter_T oIter){
+    assert(oIter != NULL);
+    free(oIter);
+}
+
 
@@ -0,0 +1,997 @@
+/* Symbol table hybrid implementation: a small array inside the
+table itself that is scanned in order, promoted to a hash index
+over the same bindings once it outgrows that array*/
+#include <assert.h>
+#include <stdlib.h>
+#include "symtable.h"
+#include "arena.h"
+#include "strhash.h"
+#include "prefetch.h"
+#include "parallel.h"
+#include "symtablestats.h"
+#include <string.h>
+
+/* The number of bindings a table holds in the array inside it
+before it gets an index, can be overridden at compile time with -D.
+Must be a power of two since the capacity doubles from it and the
+index has twice as many slots*/
+#ifndef SYMTABLE_SMALL_CAPACITY
+#define SYMTABLE_SMALL_CAPACITY 8
+#endif
+
+/* The batch functions work through the keys this many at a time:
+hash them all and prefetch the index slot where each probe starts
+before probing any of them*/
+enum {BATCH_SIZE = 16};
+
+/* SymTable_mapParallel hands out this many bindings at a time*/
+enum {MAP_GRAIN = 1024};
+
+/* A binding of the dense binding array*/
+struct Entry
+{
+   /* Key*/
+   const char *pcKey;
+
+   /* Value*/
+   void *pvValue;
+
+   /* Full hash of the key, only set while the table has an index,
+   kept so growing never rehashes a key string*/
+   size_t uHash;
+
+   /* The number of characters of the key, compared first so keys
+   of another length never reach memcmp*/
+   size_t uLength;
+};
+
+/* SymTable keeps its bindings packed at the front of an array of
+entries. A small table uses the array inside the struct and finds
+a key by scanning it. Past that, the array is malloc'd and an
+index of slots, open addressed with linear probing, maps each hash
+to the entry holding it*/
+struct SymTable
+{
+   /* The number of bindings, which are psEntries[0] to
+   psEntries[length - 1]*/
+   size_t length;
+
+   /* The number of entries psEntries has room for,
+   SYMTABLE_SMALL_CAPACITY while the table is small and a power of
+   two multiple of it after*/
+   size_t uCapacity;
+
+   /* The smallest capacity the table shrinks back to on its own,
+   SYMTABLE_SMALL_CAPACITY unless raised by SymTable_reserve*/
+   size_t uCapacityMin;
+
+   /* The bindings, asSmall while the table is small*/
+   struct Entry *psEntries;
+
+   /* Array of uSlotCount slots, each 0 if empty or 1 plus the
+   number of the entry it leads to. NULL while the table is small*/
+   size_t *puIndex;
+
+   /* The number of slots of puIndex, twice uCapacity so the index
+   is never more than half full, 0 while the table is small*/
+   size_t uSlotCount;
+
+   /* Arena the keys are packed into, NULL when each key is
+   malloc'd on its own. The entries are already one flat array
+   so only the keys need it*/
+   Arena_T oArena;
+
+   /* The pool every key is interned in, NULL when the table
+   copies its own keys*/
+   Intern_T oIntern;
+
+   /* Hash function applied to the keys once the table is
+   indexed*/
+   size_t (*pfHash)(const char *pcKey, size_t uLength);
+
+#ifdef SYMTABLE_STATS
+   /* The counters reported by SymTable_getStats*/
+   struct SymTableStats sStats;
+#endif
+
+   /* The entries of a small table, so that it takes a single
+   allocation*/
+   struct Entry asSmall[SYMTABLE_SMALL_CAPACITY];
+};
+
+/* What every thread of SymTable_mapParallel is given*/
+struct MapTask
+{
+   /* The table mapped*/
+   SymTable_T oSymTable;
+
+   /* The function applied to each binding and its extra
+   parameter*/
+   void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra);
+   void *pvExtra;
+};
+
+/* A cursor over the entries in array order*/
+struct SymTableIter
+{
+   /* The table walked*/
+   SymTable_T oSymTable;
+
+   /* The entry of the binding the cursor is at, if iHasCurrent,
+   which is 0 before the first one and after it was removed*/
+   size_t uCurrent;
+   int iHasCurrent;
+
+   /* The entry visited next*/
+   size_t uNext;
+};
+
+/* Hash Function takes in SymTable_T oSymTable and the key const
+char *pcKey of size_t uLength characters and returns the full
+size_t hash given by the hash function of oSymTable*/
+static size_t SymTable_hash(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength)
+{
+   assert(pcKey != NULL);
+   return (*oSymTable->pfHash)(pcKey, uLength);
+}
+
+/* Returns the first slot that the probe sequence for hash uHash
+visits in an index of uSlotCount slots*/
+static size_t SymTable_start(size_t uHash, size_t uSlotCount)
+{
+   return uHash & (uSlotCount - 1);
+}
+
+/* Takes in SymTable_T oSymTable, struct Entry *psEntry and the key
+const char *pcKey of size_t uLength characters and sets the key of
+psEntry to a copy of pcKey owned by oSymTable, or to the interned
+pcKey if oSymTable interns its keys. Returns 1, or 0 if there is
+not enough memory*/
+static int SymTable_copyKey(SymTable_T oSymTable, struct Entry *psEntry,
+    const char *pcKey, size_t uLength)
+{
+   char *pcKeyCopy;
+
+   if (oSymTable->oIntern != NULL){
+      psEntry->pcKey = Intern_addN(oSymTable->oIntern, pcKey, uLength);
+      psEntry->uLength = uLength;
+      return psEntry->pcKey != NULL;
+   }
+   if (oSymTable->oArena != NULL)
+      pcKeyCopy = Arena_copyStringN(oSymTable->oArena, pcKey, uLength);
+   else {
+      pcKeyCopy = malloc(uLength + 1);
+      if (pcKeyCopy != NULL){
+         memcpy(pcKeyCopy, pcKey, uLength);
+         pcKeyCopy[uLength] = '\0';
+      }
+   }
+   if (pcKeyCopy == NULL)
+      return 0;
+   psEntry->pcKey = pcKeyCopy;
+   psEntry->uLength = uLength;
+   return 1;
+}
+
+/* Takes in SymTable_T oSymTable and struct Entry *psEntry, whose key
+was set by SymTable_copyKey, and frees that key, arena keys are
+only released with the arena and interned keys are released to the
+pool. Returns nothing*/
+static void SymTable_freeKey(SymTable_T oSymTable,
+    struct Entry *psEntry)
+{
+   if (oSymTable->oIntern != NULL)
+      Intern_release(oSymTable->oIntern, psEntry->pcKey);
+   else if (oSymTable->oArena == NULL)
+      free((void *)psEntry->pcKey);
+}
+
+/* Takes in struct Entry *psEntry and the key const char *pcKey of
+size_t uLength characters and returns 1 if psEntry holds that key,
+0 otherwise. An interned key passed in is the very pointer
+stored*/
+static int SymTable_matches(struct Entry *psEntry, const char *pcKey,
+    size_t uLength)
+{
+   return psEntry->uLength == uLength
+      && (psEntry->pcKey == pcKey
+         || memcmp(psEntry->pcKey, pcKey, uLength) == 0);
+}
+
+/* Looks up the key pcKey of uLength characters, whose hash is
+uHash if oSymTable is indexed (and unused otherwise), and returns
+the number of its entry, storing the slot leading to it in *puSlot
+if oSymTable is indexed and puSlot is not NULL. Returns length if
+pcKey is not in oSymTable*/
+static size_t SymTable_find(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength, size_t uHash, size_t *puSlot)
+{
+   struct Entry *psEntry;
+   size_t uMask;
+   size_t i;
+   size_t u;
+
+   /* A small table is short enough to scan, and needs no hash*/
+   if (oSymTable->puIndex == NULL){
+      for (u = 0; u < oSymTable->length; u++){
+         STATS_ADD_ATOMIC(oSymTable, ulProbes, 1);
+         if (SymTable_matches(&oSymTable->psEntries[u], pcKey,
+               uLength))
+            return u;
+      }
+      return oSymTable->length;
+   }
+
+   uMask = oSymTable->uSlotCount - 1;
+   for (i = SymTable_start(uHash, oSymTable->uSlotCount); ;
+        i = (i + 1) & uMask){
+      STATS_ADD_ATOMIC(oSymTable, ulProbes, 1);
+      u = oSymTable->puIndex[i];
+      if (u == 0)
+         return oSymTable->length;
+      psEntry = &oSymTable->psEntries[u - 1];
+      if (psEntry->uHash == uHash
+         && SymTable_matches(psEntry, pcKey, uLength)){
+         if (puSlot != NULL)
+            *puSlot = i;
+         return u - 1;
+      }
+   }
+}
+
+/* Takes in an indexed SymTable_T oSymTable and the size_t u of one
+of its entries and returns the slot of the index leading to it*/
+static size_t SymTable_slotOf(SymTable_T oSymTable, size_t u)
+{
+   size_t uMask = oSymTable->uSlotCount - 1;
+   size_t i;
+
+   for (i = SymTable_start(oSymTable->psEntries[u].uHash,
+           oSymTable->uSlotCount);
+        oSymTable->puIndex[i] != u + 1; i = (i + 1) & uMask)
+      assert(oSymTable->puIndex[i] != 0);
+   return i;
+}
+
+/* Takes in an indexed SymTable_T oSymTable and the size_t u of an
+entry the index does not lead to yet and puts it in the first
+empty slot of its probe sequence. Returns nothing*/
+static void SymTable_indexEntry(SymTable_T oSymTable, size_t u)
+{
+   size_t uMask = oSymTable->uSlotCount - 1;
+   size_t i;
+
+   for (i = SymTable_start(oSymTable->psEntries[u].uHash,
+           oSymTable->uSlotCount);
+        oSymTable->puIndex[i] != 0; i = (i + 1) & uMask)
+      ;
+   oSymTable->puIndex[i] = u + 1;
+}
+
+/* Takes in an indexed SymTable_T oSymTable and the size_t i of a
+full slot and empties it, shifting back the slots after it whose
+probe sequence would otherwise be cut, so the index needs no
+deleted markers. Returns nothing*/
+static void SymTable_unindexSlot(SymTable_T oSymTable, size_t i)
+{
+   size_t uMask = oSymTable->uSlotCount - 1;
+   size_t j = i;
+   size_t k;
+
+   for (;;){
+      j = (j + 1) & uMask;
+      if (oSymTable->puIndex[j] == 0)
+         break;
+      k = SymTable_start(
+         oSymTable->psEntries[oSymTable->puIndex[j] - 1].uHash,
+         oSymTable->uSlotCount);
+      /* The entry of slot j may move back to slot i unless its
+      probe sequence starts after i, up to j*/
+      if (((j - k) & uMask) >= ((j - i) & uMask)){
+         oSymTable->puIndex[i] = oSymTable->puIndex[j];
+         i = j;
+      }
+   }
+   oSymTable->puIndex[i] = 0;
+}
+
+/* Resize is a helper function that takes in SymTable_T oSymTable
+and moves its entries into room for uCapacity of them, the array
+inside the table if uCapacity is at most SYMTABLE_SMALL_CAPACITY,
+otherwise a new array with a new index. Entries keep their order.
+Returns 1 on success, 0 if there is not enough memory in which
+case oSymTable is unchanged*/
+static int SymTable_Resize(SymTable_T oSymTable, size_t uCapacity)
+{
+   struct Entry *psEntries;
+   size_t *puIndex;
+   size_t u;
+   clock_t iStart = STATS_CLOCK();
+
+   assert(uCapacity >= oSymTable->length);
+
+   if (uCapacity <= SYMTABLE_SMALL_CAPACITY){
+      if (oSymTable->psEntries != oSymTable->asSmall){
+         memcpy(oSymTable->asSmall, oSymTable->psEntries,
+            oSymTable->length * sizeof(struct Entry));
+         free(oSymTable->psEntries);
+         free(oSymTable->puIndex);
+      }
+      oSymTable->psEntries = oSymTable->asSmall;
+      oSymTable->puIndex = NULL;
+      oSymTable->uSlotCount = 0;
+      oSymTable->uCapacity = SYMTABLE_SMALL_CAPACITY;
+   }
+   else {
+      psEntries = malloc(uCapacity * sizeof(struct Entry));
+      if (psEntries == NULL)
+         return 0;
+      puIndex = calloc(uCapacity * 2, sizeof(size_t));
+      if (puIndex == NULL){
+         free(psEntries);
+         return 0;
+      }
+      memcpy(psEntries, oSymTable->psEntries,
+         oSymTable->length * sizeof(struct Entry));
+
+      /* A small table never hashed its keys*/
+      if (oSymTable->puIndex == NULL)
+         for (u = 0; u < oSymTable->length; u++)
+            psEntries[u].uHash = SymTable_hash(oSymTable,
+               psEntries[u].pcKey, psEntries[u].uLength);
+
+      if (oSymTable->psEntries != oSymTable->asSmall)
+         free(oSymTable->psEntries);
+      free(oSymTable->puIndex);
+      oSymTable->psEntries = psEntries;
+      oSymTable->puIndex = puIndex;
+      oSymTable->uSlotCount = uCapacity * 2;
+      oSymTable->uCapacity = uCapacity;
+      for (u = 0; u < oSymTable->length; u++)
+         SymTable_indexEntry(oSymTable, u);
+   }
+
+   STATS_ADD(oSymTable, ulResizes, 1);
+   STATS_ADD(oSymTable, dResizeSeconds, STATS_SECONDS(iStart));
+   return 1;
+}
+
+/* Takes in SymTable_T oSymTable and halves its capacity, going
+back to the array inside the table at the end, once fewer than a
+quarter of its entries are used, never below uCapacityMin. A failed
+shrink leaves the table as it was, still valid. Returns nothing*/
+static void SymTable_shrinkIfSparse(SymTable_T oSymTable)
+{
+   if (oSymTable->uCapacity > oSymTable->uCapacityMin &&
+       oSymTable->length * 4 <= oSymTable->uCapacity)
+      (void)SymTable_Resize(oSymTable, oSymTable->uCapacity / 2);
+}
+
+SymTable_T SymTable_new(void)
+{
+   SymTable_T oSymTable;
+   oSymTable = malloc(sizeof(struct SymTable));
+   if (oSymTable == NULL)
+      return NULL;
+
+   oSymTable->length = 0;
+   oSymTable->uCapacity = SYMTABLE_SMALL_CAPACITY;
+   oSymTable->uCapacityMin = SYMTABLE_SMALL_CAPACITY;
+   oSymTable->psEntries = oSymTable->asSmall;
+   oSymTable->puIndex = NULL;
+   oSymTable->uSlotCount = 0;
+   oSymTable->oArena = NULL;
+   oSymTable->oIntern = NULL;
+   oSymTable->pfHash = StrHash_hash;
+#ifdef SYMTABLE_STATS
+   memset(&oSymTable->sStats, 0, sizeof(struct SymTableStats));
+#endif
+   return oSymTable;
+}
+
+SymTable_T SymTable_newWithArena(size_t uHint)
+{
+   SymTable_T oSymTable;
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+      return NULL;
+
+   oSymTable->oArena = Arena_new(0, uHint);
+   if (oSymTable->oArena == NULL){
+      SymTable_free(oSymTable);
+      return NULL;
+   }
+   return oSymTable;
+}
+
+SymTable_T SymTable_newWithCapacity(size_t uExpected)
+{
+   SymTable_T oSymTable;
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+      return NULL;
+
+   if (!SymTable_reserve(oSymTable, uExpected)){
+      SymTable_free(oSymTable);
+      return NULL;
+   }
+   return oSymTable;
+}
+
+SymTable_T SymTable_newWithHash(
+    size_t (*pfHash)(const char *pcKey, size_t uLength))
+{
+   SymTable_T oSymTable;
+   assert(pfHash != NULL);
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+      return NULL;
+   oSymTable->pfHash = pfHash;
+   return oSymTable;
+}
+
+SymTable_T SymTable_newWithIntern(Intern_T oIntern)
+{
+   SymTable_T oSymTable;
+   assert(oIntern != NULL);
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+      return NULL;
+   oSymTable->oIntern = oIntern;
+   return oSymTable;
+}
+
+void SymTable_free(SymTable_T oSymTable)
+{
+   size_t u;
+   assert(oSymTable != NULL);
+
+   /* Frees the key of every entry, or all of them at once with
+   the arena, and then the arrays*/
+   if (oSymTable->oArena != NULL)
+      Arena_free(oSymTable->oArena);
+   else
+      for (u = 0; u < oSymTable->length; u++)
+         SymTable_freeKey(oSymTable, &oSymTable->psEntries[u]);
+   if (oSymTable->psEntries != oSymTable->asSmall)
+      free(oSymTable->psEntries);
+   free(oSymTable->puIndex);
+   free(oSymTable);
+}
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+   assert(oSymTable != NULL);
+   return oSymTable->length;
+}
+
+/* Takes in SymTable_T oSymTable and the key const char *pcKey of
+size_t uLength characters and returns the hash SymTable_find needs
+for it: the real one if oSymTable is indexed, 0 otherwise*/
+static size_t SymTable_findHash(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength)
+{
+   if (oSymTable->puIndex == NULL)
+      return 0;
+   return SymTable_hash(oSymTable, pcKey, uLength);
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+   return SymTable_containsN(oSymTable, pcKey, strlen(pcKey));
+}
+
+int SymTable_containsN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength)
+{
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+   STATS_ADD_ATOMIC(oSymTable, ulContains, 1);
+   return SymTable_find(oSymTable, pcKey, uLength,
+      SymTable_findHash(oSymTable, pcKey, uLength), NULL)
+      != oSymTable->length;
+}
+
+/* Takes in SymTable_T oSymTable, the key const char *pcKey of
+size_t uLength characters, its size_t uHash as SymTable_findHash
+gives it and const void *pvValue and looks pcKey up once:
+if it is present
+the existing value is stored in *ppvValue and 0 is returned,
+otherwise the pair is appended to the entries, growing them (and
+promoting a small table) if they are full, pvValue is stored in
+*ppvValue and 1 is returned. Returns -1 if there is not enough
+memory*/
+static int SymTable_insert(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength, size_t uHash, const void *pvValue, void **ppvValue)
+{
+   struct Entry *psEntry;
+   size_t u;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+   assert(ppvValue != NULL);
+
+   STATS_ADD(oSymTable, ulPuts, 1);
+   u = SymTable_find(oSymTable, pcKey, uLength, uHash, NULL);
+   if (u != oSymTable->length){
+      *ppvValue = oSymTable->psEntries[u].pvValue;
+      return 0;
+   }
+
+   if (oSymTable->length == oSymTable->uCapacity){
+      if (oSymTable->uCapacity > (size_t)-1 / sizeof(struct Entry) / 4
+          || !SymTable_Resize(oSymTable, oSymTable->uCapacity * 2))
+         return -1;
+      /* Promoting a small table is what gives keys a hash*/
+      uHash = SymTable_hash(oSymTable, pcKey, uLength);
+   }
+
+   psEntry = &oSymTable->psEntries[oSymTable->length];
+   if (!SymTable_copyKey(oSymTable, psEntry, pcKey, uLength))
+      return -1;
+   psEntry->pvValue = (void *)pvValue;
+   psEntry->uHash = uHash;
+   if (oSymTable->puIndex != NULL)
+      SymTable_indexEntry(oSymTable, oSymTable->length);
+   oSymTable->length++;
+   *ppvValue = (void *)pvValue;
+   return 1;
+}
+
+int SymTable_put(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue)
+{
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+   return SymTable_putN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+int SymTable_putN(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, const void *pvValue)
+{
+   void *pvFound;
+   assert(oSymTable != NULL);
+   return SymTable_insert(oSymTable, pcKey, uLength,
+      SymTable_findHash(oSymTable, pcKey, uLength), pvValue,
+      &pvFound) == 1;
+}
+
+int SymTable_putOrGet(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue, void **ppvValue)
+{
+   void *pvFound;
+   size_t uLength;
+   int iResult;
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   uLength = strlen(pcKey);
+   iResult = SymTable_insert(oSymTable, pcKey, uLength,
+      SymTable_findHash(oSymTable, pcKey, uLength), pvValue,
+      &pvFound);
+   if (iResult != -1 && ppvValue != NULL)
+      *ppvValue = pvFound;
+   return iResult;
+}
+
+void *SymTable_replace(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue)
+{
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+   return SymTable_replaceN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+void *SymTable_replaceN(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, const void *pvValue)
+{
+   size_t u;
+   void *OldValue;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   STATS_ADD(oSymTable, ulReplaces, 1);
+   u = SymTable_find(oSymTable, pcKey, uLength,
+      SymTable_findHash(oSymTable, pcKey, uLength), NULL);
+   if (u == oSymTable->length)
+      return NULL;
+   OldValue = oSymTable->psEntries[u].pvValue;
+   oSymTable->psEntries[u].pvValue = (void *)pvValue;
+   return OldValue;
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+   return SymTable_getN(oSymTable, pcKey, strlen(pcKey));
+}
+
+void *SymTable_getN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength)
+{
+   size_t u;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   STATS_ADD_ATOMIC(oSymTable, ulGets, 1);
+   u = SymTable_find(oSymTable, pcKey, uLength,
+      SymTable_findHash(oSymTable, pcKey, uLength), NULL);
+   if (u == oSymTable->length)
+      return NULL;
+   return oSymTable->psEntries[u].pvValue;
+}
+
+/* Takes in SymTable_T oSymTable, the size_t u of one of its entries
+and, if oSymTable is indexed, the size_t i of the slot leading to
+it, removes that binding and returns its value. The last entry
+moves into the hole so the entries stay packed. Never resizes*/
+static void *SymTable_removeEntry(SymTable_T oSymTable, size_t u,
+    size_t i)
+{
+   struct Entry *psEntries = oSymTable->psEntries;
+   void *value;
+   size_t uLast;
+
+   value = psEntries[u].pvValue;
+   SymTable_freeKey(oSymTable, &psEntries[u]);
+   if (oSymTable->puIndex != NULL)
+      SymTable_unindexSlot(oSymTable, i);
+
+   uLast = --oSymTable->length;
+   if (u != uLast){
+      if (oSymTable->puIndex != NULL)
+         oSymTable->puIndex[SymTable_slotOf(oSymTable, uLast)] = u + 1;
+      psEntries[u] = psEntries[uLast];
+   }
+   return value;
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+   return SymTable_removeN(oSymTable, pcKey, strlen(pcKey));
+}
+
+void *SymTable_removeN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength)
+{
+   size_t u;
+   size_t i = 0;
+   void *value;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   STATS_ADD(oSymTable, ulRemoves, 1);
+   u = SymTable_find(oSymTable, pcKey, uLength,
+      SymTable_findHash(oSymTable, pcKey, uLength), &i);
+   if (u == oSymTable->length)
+      return NULL;
+   value = SymTable_removeEntry(oSymTable, u, i);
+   SymTable_shrinkIfSparse(oSymTable);
+   return value;
+}
+
+void SymTable_getBatch(SymTable_T oSymTable, const char **ppcKeys,
+    size_t uCount, void **ppvValues)
+{
+   size_t auHash[BATCH_SIZE];
+   size_t auLength[BATCH_SIZE];
+   size_t uDone;
+   size_t uBatch;
+   size_t u;
+   size_t j;
+
+   assert(oSymTable != NULL);
+   assert(ppcKeys != NULL || uCount == 0);
+   assert(ppvValues != NULL || uCount == 0);
+
+   STATS_ADD_ATOMIC(oSymTable, ulGets, uCount);
+   for (uDone = 0; uDone < uCount; uDone += uBatch){
+      uBatch = uCount - uDone;
+      if (uBatch > BATCH_SIZE)
+         uBatch = BATCH_SIZE;
+
+      /* A small table is already in the cache line or two of the
+      table itself*/
+      for (j = 0; j < uBatch; j++){
+         auLength[j] = strlen(ppcKeys[uDone + j]);
+         auHash[j] = SymTable_findHash(oSymTable, ppcKeys[uDone + j],
+            auLength[j]);
+         if (oSymTable->puIndex != NULL)
+            PREFETCH(&oSymTable->puIndex[SymTable_start(auHash[j],
+               oSymTable->uSlotCount)]);
+      }
+      for (j = 0; j < uBatch; j++){
+         u = SymTable_find(oSymTable, ppcKeys[uDone + j],
+            auLength[j], auHash[j], NULL);
+         ppvValues[uDone + j] = (u == oSymTable->length) ?
+            NULL : oSymTable->psEntries[u].pvValue;
+      }
+   }
+}
+
+size_t SymTable_putBatch(SymTable_T oSymTable, const char **ppcKeys,
+    void **ppvValues, size_t uCount)
+{
+   size_t auHash[BATCH_SIZE];
+   size_t auLength[BATCH_SIZE];
+   void *pvFound;
+   size_t uInserted = 0;
+   size_t uDone;
+   size_t uBatch;
+   size_t uSlotCount;
+   size_t j;
+
+   assert(oSymTable != NULL);
+   assert(ppcKeys != NULL || uCount == 0);
+   assert(ppvValues != NULL || uCount == 0);
+
+   for (uDone = 0; uDone < uCount; uDone += uBatch){
+      uBatch = uCount - uDone;
+      if (uBatch > BATCH_SIZE)
+         uBatch = BATCH_SIZE;
+
+      for (j = 0; j < uBatch; j++){
+         auLength[j] = strlen(ppcKeys[uDone + j]);
+         auHash[j] = SymTable_findHash(oSymTable, ppcKeys[uDone + j],
+            auLength[j]);
+         if (oSymTable->puIndex != NULL)
+            PREFETCH(&oSymTable->puIndex[SymTable_start(auHash[j],
+               oSymTable->uSlotCount)]);
+      }
+
+      /* A put that promotes the table changes what hash the
+      rest need, so they are taken again from then on*/
+      uSlotCount = oSymTable->uSlotCount;
+      for (j = 0; j < uBatch; j++){
+         if (uSlotCount == 0 && oSymTable->puIndex != NULL)
+            auHash[j] = SymTable_findHash(oSymTable,
+               ppcKeys[uDone + j], auLength[j]);
+         if (SymTable_insert(oSymTable, ppcKeys[uDone + j],
+               auLength[j], auHash[j], ppvValues[uDone + j],
+               &pvFound) == 1)
+            uInserted++;
+      }
+   }
+   return uInserted;
+}
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCount)
+{
+   size_t uCapacity = SYMTABLE_SMALL_CAPACITY;
+
+   assert(oSymTable != NULL);
+
+   /* The fewest entries that take uCount bindings without the
+   insert of the last one growing the table*/
+   while (uCapacity < uCount){
+      if (uCapacity > (size_t)-1 / sizeof(struct Entry) / 4)
+         return 0;
+      uCapacity *= 2;
+   }
+   if (uCapacity > oSymTable->uCapacity &&
+       !SymTable_Resize(oSymTable, uCapacity))
+      return 0;
+   if (uCapacity > oSymTable->uCapacityMin)
+      oSymTable->uCapacityMin = uCapacity;
+   return 1;
+}
+
+void SymTable_setReorder(SymTable_T oSymTable,
+    enum SymTableReorder eReorder)
+{
+   /* A binding is found through its slot in the index, and a
+   table small enough to have none has too few entries for their
+   order to matter*/
+   assert(oSymTable != NULL);
+   (void)oSymTable;
+   (void)eReorder;
+}
+
+int SymTable_setFilter(SymTable_T oSymTable, int iEnabled)
+{
+   /* A miss ends at the first empty slot of the index, usually
+   within the cache line the hash leads to*/
+   assert(oSymTable != NULL);
+   (void)oSymTable;
+   (void)iEnabled;
+   return 1;
+}
+
+void SymTable_compact(SymTable_T oSymTable)
+{
+   size_t uCapacity = SYMTABLE_SMALL_CAPACITY;
+
+   assert(oSymTable != NULL);
+   oSymTable->uCapacityMin = SYMTABLE_SMALL_CAPACITY;
+
+   /* The fewest entries that hold every binding, which puts a
+   table that fits back in its own array*/
+   while (uCapacity < oSymTable->length)
+      uCapacity *= 2;
+   if (uCapacity < oSymTable->uCapacity)
+      (void)SymTable_Resize(oSymTable, uCapacity);
+}
+
+void SymTable_getStats(SymTable_T oSymTable,
+    struct SymTableStats *psStats)
+{
+   size_t uMask;
+   size_t uChain;
+   size_t u;
+   size_t i;
+
+   assert(oSymTable != NULL);
+   assert(psStats != NULL);
+
+#ifdef SYMTABLE_STATS
+   *psStats = oSymTable->sStats;
+#else
+   memset(psStats, 0, sizeof(struct SymTableStats));
+#endif
+   psStats->uLength = oSymTable->length;
+   psStats->uLongestChain = 0;
+   memset(psStats->auChainLengths, 0, sizeof(psStats->auChainLengths));
+   psStats->uKeyBytes = 0;
+   for (u = 0; u < oSymTable->length; u++)
+      psStats->uKeyBytes += oSymTable->psEntries[u].uLength + 1;
+
+   /* A small table is a single chain like the linked list*/
+   if (oSymTable->puIndex == NULL){
+      psStats->uBucketCount = 1;
+      psStats->dLoadFactor = (double)oSymTable->length;
+      psStats->uLongestChain = oSymTable->length;
+      uChain = oSymTable->length;
+      if (uChain >= SYMTABLE_STATS_CHAIN_LENGTHS)
+         uChain = SYMTABLE_STATS_CHAIN_LENGTHS - 1;
+      psStats->auChainLengths[uChain] = 1;
+      psStats->uBindingBytes = sizeof(struct SymTable);
+      return;
+   }
+
+   /* Otherwise the chain of a binding is the run of slots from the
+   start of its probe sequence to its own slot, as for open
+   addressing*/
+   psStats->uBucketCount = oSymTable->uSlotCount;
+   psStats->dLoadFactor =
+      (double)oSymTable->length / (double)oSymTable->uSlotCount;
+   uMask = oSymTable->uSlotCount - 1;
+   for (i = 0; i < oSymTable->uSlotCount; i++){
+      if (oSymTable->puIndex[i] == 0)
+         continue;
+      uChain = ((i - SymTable_start(
+         oSymTable->psEntries[oSymTable->puIndex[i] - 1].uHash,
+         oSymTable->uSlotCount)) & uMask) + 1;
+      if (uChain > psStats->uLongestChain)
+         psStats->uLongestChain = uChain;
+      if (uChain >= SYMTABLE_STATS_CHAIN_LENGTHS)
+         uChain = SYMTABLE_STATS_CHAIN_LENGTHS - 1;
+      psStats->auChainLengths[uChain]++;
+   }
+   psStats->uBindingBytes = sizeof(struct SymTable)
+      + oSymTable->uCapacity * sizeof(struct Entry)
+      + oSymTable->uSlotCount * sizeof(size_t);
+}
+
+void SymTable_map(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+   size_t u;
+
+   assert(oSymTable != NULL);
+   assert(pfApply != NULL);
+
+   /* The entries are packed, so there is nothing to skip*/
+   for (u = 0; u < oSymTable->length; u++)
+      (*pfApply)(oSymTable->psEntries[u].pcKey,
+         oSymTable->psEntries[u].pvValue, (void *)pvExtra);
+}
+
+/* Takes in size_t uStart, size_t uEnd and the struct MapTask
+*pvTask and applies its function to entries uStart to uEnd - 1.
+Returns nothing*/
+static void SymTable_mapTask(size_t uStart, size_t uEnd, void *pvTask)
+{
+   struct MapTask *psTask = pvTask;
+   struct Entry *psEntries = psTask->oSymTable->psEntries;
+   size_t u;
+
+   for (u = uStart; u < uEnd; u++)
+      (*psTask->pfApply)(psEntries[u].pcKey, psEntries[u].pvValue,
+         psTask->pvExtra);
+}
+
+void SymTable_mapParallel(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra, int iThreads)
+{
+   struct MapTask sTask;
+
+   assert(oSymTable != NULL);
+   assert(pfApply != NULL);
+
+   sTask.oSymTable = oSymTable;
+   sTask.pfApply = pfApply;
+   sTask.pvExtra = (void *)pvExtra;
+   Parallel_run(oSymTable->length, MAP_GRAIN, iThreads,
+      SymTable_mapTask, &sTask);
+}
+
+SymTableIter_T SymTable_iterBegin(SymTable_T oSymTable)
+{
+   SymTableIter_T oIter;
+
+   assert(oSymTable != NULL);
+
+   oIter = malloc(sizeof(struct SymTableIter));
+   if (oIter == NULL)
+      return NULL;
+   oIter->oSymTable = oSymTable;
+   oIter->uCurrent = 0;
+   oIter->iHasCurrent = 0;
+   oIter->uNext = 0;
+   return oIter;
+}
+
+int SymTable_iterNext(SymTableIter_T oIter, const char **ppcKey,
+    void **ppvValue)
+{
+   struct Entry *psEntry;
+
+   assert(oIter != NULL);
+
+   if (oIter->uNext >= oIter->oSymTable->length){
+      oIter->iHasCurrent = 0;
+      return 0;
+   }
+   oIter->uCurrent = oIter->uNext++;
+   oIter->iHasCurrent = 1;
+   psEntry = &oIter->oSymTable->psEntries[oIter->uCurrent];
+   if (ppcKey != NULL)
+      *ppcKey = psEntry->pcKey;
+   if (ppvValue != NULL)
+      *ppvValue = psEntry->pvValue;
+   return 1;
+}
+
+void *SymTable_iterRemove(SymTableIter_T oIter)
+{
+   SymTable_T oSymTable;
+   size_t i = 0;
+   void *value;
+
+   assert(oIter != NULL);
+
+   if (!oIter->iHasCurrent)
+      return NULL;
+   oSymTable = oIter->oSymTable;
+   STATS_ADD(oSymTable, ulRemoves, 1);
+   if (oSymTable->puIndex != NULL)
+      i = SymTable_slotOf(oSymTable, oIter->uCurrent);
+   value = SymTable_removeEntry(oSymTable, oIter->uCurrent, i);
+
+   /* The last entry, not visited yet, moved into the hole, which is
+   visited next. Shrinking keeps the entries in order so it may
+   happen here too*/
+   oIter->uNext = oIter->uCurrent;
+   oIter->iHasCurrent = 0;
+   SymTable_shrinkIfSparse(oSymTable);
+   return value;
+}
+
+void SymTable_iterEnd(SymTableIter_T oIter)
+{
+   assert(oIter != NULL);
+   free(oIter);
+}
@@ -2,8 +2,20 @@
 #include <assert.h>
 #include <stdlib.h>
 #include "symtable.h"
+#include "arena.h"
+#include "filter.h"
+#include "strhash.h"
+#include "parallel.h"
+#include "symtablestats.h"
 #include <string.h>
 
+/* Keys of fewer than SYMTABLE_INLINE_KEY_SIZE characters are stored
+inside their binding instead of in a copy of their own, can be
+overridden at compile time with -D*/
+#ifndef SYMTABLE_INLINE_KEY_SIZE
+#define SYMTABLE_INLINE_KEY_SIZE 16
+#endif
+
 /* Structure of Binding*/
 struct Binding
 {
@@ -15,6 +27,15 @@ struct Binding
 
    /* The address of the next Binding. */
    struct Binding *psNextBinding;
+
+   /* The number of characters of the key, compared first so keys
+   of another length never reach memcmp */
+   size_t uLength;
+
+   /* A short key is copied here and pcKey points at it, so it
+   takes no allocation of its own and comparing it touches no
+   memory beyond the binding */
+   char acKey[SYMTABLE_INLINE_KEY_SIZE];
 };
 
 /* How Symbol Table is set up*/
@@ -25,8 +46,275 @@ struct SymTable
 
    /* The address of the first Binding. */
    struct Binding *psFirstBinding;
+
+   /* Arena the bindings and keys are allocated from, NULL when
+   each one is malloc'd and freed on its own */
+   Arena_T oArena;
+
+   /* Without an arena, the pool SymTable_reserve preallocates
+   bindings in, NULL until it is first called. Keys are still
+   malloc'd one by one */
+   Arena_T oPool;
+
+   /* The pool every key is interned in, NULL when the table
+   copies its own keys */
+   Intern_T oIntern;
+
+   /* How SymTable_getN reorders the list as it finds keys */
+   enum SymTableReorder eReorder;
+
+   /* The filter of the hashes of every key, asked before the list
+   is walked, NULL unless SymTable_setFilter enabled it. The list
+   hashes keys only for it */
+   Filter_T oFilter;
+
+#ifdef SYMTABLE_STATS
+   /* The counters reported by SymTable_getStats */
+   struct SymTableStats sStats;
+#endif
+};
+
+/* SymTable_mapParallel hands out this many bindings at a time*/
+enum {MAP_GRAIN = 1024};
+
+/* What every thread of SymTable_mapParallel is given*/
+struct MapTask
+{
+   /* The bindings, gathered from the list beforehand */
+   struct Binding **ppsBindings;
+
+   /* The function applied to each binding and its extra
+   parameter */
+   void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra);
+   void *pvExtra;
+};
+
+/* A cursor over the list*/
+struct SymTableIter
+{
+   /* The table walked */
+   SymTable_T oSymTable;
+
+   /* The link to the binding the cursor is at, or to the one the
+   next SymTable_iterNext returns if the cursor is at none */
+   struct Binding **ppsLink;
+
+   /* The binding the cursor is at, NULL before the first one and
+   after it was removed */
+   struct Binding *psCurrent;
 };
 
+/* Takes in SymTable_T oSymTable and struct Binding *psBinding,
+taken without an arena, and frees psBinding but not its key, or
+gives it back to the pool of oSymTable. Returns nothing*/
+static void SymTable_freeBindingOnly(SymTable_T oSymTable,
+    struct Binding *psBinding)
+{
+   if (oSymTable->oPool != NULL)
+      Arena_freeObject(oSymTable->oPool, psBinding);
+   else
+      free(psBinding);
+}
+
+/* Takes in SymTable_T oSymTable and the key const char *pcKey of
+size_t uLength characters and returns a new binding holding a copy
+of pcKey, inline if it is short, taken from the arena of oSymTable
+if it has one, or the interned pcKey if oSymTable interns its keys.
+Returns NULL if there is not enough memory*/
+static struct Binding *SymTable_newBinding(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength)
+{
+   struct Binding *psNewBinding;
+   char *pcKeyCopy;
+
+   if (oSymTable->oArena != NULL){
+      psNewBinding =
+         (struct Binding *) Arena_allocObject(oSymTable->oArena);
+      if (psNewBinding == NULL)
+         return NULL;
+      if (uLength < SYMTABLE_INLINE_KEY_SIZE)
+         pcKeyCopy = psNewBinding->acKey;
+      else
+         pcKeyCopy = Arena_copyStringN(oSymTable->oArena, pcKey, uLength);
+      if (pcKeyCopy == NULL){
+         Arena_freeObject(oSymTable->oArena, psNewBinding);
+         return NULL;
+      }
+   }
+   else {
+      if (oSymTable->oPool != NULL)
+         psNewBinding =
+            (struct Binding *) Arena_allocObject(oSymTable->oPool);
+      else
+         psNewBinding =
+            (struct Binding *) malloc(sizeof(struct Binding));
+      if (psNewBinding == NULL)
+         return NULL;
+      if (oSymTable->oIntern != NULL){
+         psNewBinding->pcKey =
+            Intern_addN(oSymTable->oIntern, pcKey, uLength);
+         if (psNewBinding->pcKey == NULL){
+            SymTable_freeBindingOnly(oSymTable, psNewBinding);
+            return NULL;
+         }
+         psNewBinding->uLength = uLength;
+         return psNewBinding;
+      }
+      /* Short keys go inline, only longer ones need room of
+      their own*/
+      if (uLength < SYMTABLE_INLINE_KEY_SIZE)
+         pcKeyCopy = psNewBinding->acKey;
+      else {
+         pcKeyCopy = (char *) malloc(uLength + 1);
+         if (pcKeyCopy == NULL){
+            SymTable_freeBindingOnly(oSymTable, psNewBinding);
+            return NULL;
+         }
+      }
+   }
+   memcpy(pcKeyCopy, pcKey, uLength);
+   pcKeyCopy[uLength] = '\0';
+   psNewBinding->pcKey = pcKeyCopy;
+   psNewBinding->uLength = uLength;
+   return psNewBinding;
+}
+
+/* Takes in struct Binding *psBinding and the key const char *pcKey
+of size_t uLength characters and returns 1 if psBinding holds that
+key, 0 otherwise. An interned key passed in is the very pointer
+stored*/
+static int SymTable_matches(struct Binding *psBinding,
+    const char *pcKey, size_t uLength)
+{
+   return psBinding->uLength == uLength
+      && (psBinding->pcKey == pcKey
+         || memcmp(psBinding->pcKey, pcKey, uLength) == 0);
+}
+
+/* Takes in SymTable_T oSymTable and struct Binding *psBinding,
+whose key was malloc'd unless it is inline or interned, and frees
+that key copy or releases it. Returns nothing*/
+static void SymTable_freeKey(SymTable_T oSymTable,
+    struct Binding *psBinding)
+{
+   if (oSymTable->oIntern != NULL)
+      Intern_release(oSymTable->oIntern, psBinding->pcKey);
+   else if (psBinding->pcKey != psBinding->acKey)
+      free((void *)(psBinding->pcKey));
+}
+
+/* Takes in SymTable_T oSymTable and struct Binding *psBinding
+and frees psBinding and its key, or gives the binding back to
+the arena of oSymTable (arena keys are only released with the
+arena). Returns nothing*/
+static void SymTable_freeBinding(SymTable_T oSymTable,
+    struct Binding *psBinding)
+{
+   if (oSymTable->oArena != NULL){
+      Arena_freeObject(oSymTable->oArena, psBinding);
+      return;
+   }
+   SymTable_freeKey(oSymTable, psBinding);
+   SymTable_freeBindingOnly(oSymTable, psBinding);
+}
+
+/* Takes in enum SymTableReorder eReorder and, for a binding just
+found in a chain, the link struct Binding **ppsFirst to the first
+binding of that chain, the link **ppsPreviousLink to the binding
+before the one found (NULL if it is the first) and the link
+**ppsLink to the one found, and moves it to the front of the chain
+or swaps it with the binding before it as eReorder says. Returns
+nothing*/
+static void SymTable_reorder(enum SymTableReorder eReorder,
+    struct Binding **ppsFirst, struct Binding **ppsPreviousLink,
+    struct Binding **ppsLink)
+{
+   struct Binding *psBinding = *ppsLink;
+   struct Binding *psPrevious;
+
+   if (ppsPreviousLink == NULL)
+      return;
+   switch (eReorder){
+   case SYMTABLE_REORDER_MOVE_TO_FRONT:
+      *ppsLink = psBinding->psNextBinding;
+      psBinding->psNextBinding = *ppsFirst;
+      *ppsFirst = psBinding;
+      break;
+   case SYMTABLE_REORDER_TRANSPOSE:
+      psPrevious = *ppsPreviousLink;
+      psPrevious->psNextBinding = psBinding->psNextBinding;
+      psBinding->psNextBinding = psPrevious;
+      *ppsPreviousLink = psBinding;
+      break;
+   default:
+      break;
+   }
+}
+
+/* Takes in SymTable_T oSymTable and a size_t uExpected and replaces
+the filter of oSymTable with a new one sized for uExpected bindings
+holding the hash of each key. Returns 1, or 0 if there is not
+enough memory in which case the filter is left as it was*/
+static int SymTable_buildFilter(SymTable_T oSymTable,
+    size_t uExpected)
+{
+   Filter_T oFilter;
+   struct Binding *psCurrentBinding;
+
+   oFilter = Filter_new(uExpected);
+   if (oFilter == NULL)
+      return 0;
+   for (psCurrentBinding = oSymTable->psFirstBinding;
+         psCurrentBinding != NULL;
+         psCurrentBinding = psCurrentBinding->psNextBinding)
+      Filter_add(oFilter, StrHash_hash(psCurrentBinding->pcKey,
+         psCurrentBinding->uLength));
+   if (oSymTable->oFilter != NULL)
+      Filter_free(oSymTable->oFilter);
+   oSymTable->oFilter = oFilter;
+   return 1;
+}
+
+/* Takes in SymTable_T oSymTable, which has just counted a new
+binding with the key const char *pcKey of size_t uLength
+characters, and adds the hash of pcKey to its filter if it has one,
+rebuilding the filter twice as large once the bindings outgrow it.
+Returns nothing*/
+static void SymTable_filterAdd(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength)
+{
+   if (oSymTable->oFilter == NULL)
+      return;
+   Filter_add(oSymTable->oFilter, StrHash_hash(pcKey, uLength));
+   if (oSymTable->length > Filter_getCapacity(oSymTable->oFilter))
+      (void)SymTable_buildFilter(oSymTable, oSymTable->length);
+}
+
+/* Takes in SymTable_T oSymTable and struct Binding *psBinding, which
+is being removed, and removes the hash of its key from the filter
+of oSymTable if it has one. Returns nothing*/
+static void SymTable_filterRemove(SymTable_T oSymTable,
+    struct Binding *psBinding)
+{
+   if (oSymTable->oFilter != NULL)
+      Filter_remove(oSymTable->oFilter,
+         StrHash_hash(psBinding->pcKey, psBinding->uLength));
+}
+
+/* Takes in SymTable_T oSymTable and the key const char *pcKey of
+size_t uLength characters and returns 1 if the filter of oSymTable
+shows that pcKey is not in oSymTable, 0 if it has no filter or
+pcKey may be there*/
+static int SymTable_filterRejects(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength)
+{
+   if (oSymTable->oFilter == NULL || Filter_mayContain(
+         oSymTable->oFilter, StrHash_hash(pcKey, uLength)))
+      return 0;
+   STATS_ADD_ATOMIC(oSymTable, ulFilterRejects, 1);
+   return 1;
+}
+
 SymTable_T SymTable_new(void)
 {
    SymTable_T oSymTable;
@@ -36,6 +324,64 @@ SymTable_T SymTable_new(void)
    
    oSymTable->psFirstBinding = NULL;
    oSymTable->length = 0;
+   oSymTable->oArena = NULL;
+   oSymTable->oPool = NULL;
+   oSymTable->oIntern = NULL;
+   oSymTable->eReorder = SYMTABLE_REORDER_NONE;
+   oSymTable->oFilter = NULL;
+#ifdef SYMTABLE_STATS
+   memset(&oSymTable->sStats, 0, sizeof(struct SymTableStats));
+#endif
+   return oSymTable;
+}
+
+SymTable_T SymTable_newWithArena(size_t uHint)
+{
+   SymTable_T oSymTable;
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+      return NULL;
+
+   oSymTable->oArena = Arena_new(sizeof(struct Binding), uHint);
+   if (oSymTable->oArena == NULL){
+      free(oSymTable);
+      return NULL;
+   }
+   return oSymTable;
+}
+
+SymTable_T SymTable_newWithCapacity(size_t uExpected)
+{
+   SymTable_T oSymTable;
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+      return NULL;
+
+   if (! SymTable_reserve(oSymTable, uExpected)){
+      SymTable_free(oSymTable);
+      return NULL;
+   }
+   return oSymTable;
+}
+
+SymTable_T SymTable_newWithHash(
+    size_t (*pfHash)(const char *pcKey, size_t uLength))
+{
+   /* The linked list never hashes a key so pfHash goes unused*/
+   assert(pfHash != NULL);
+   (void)pfHash;
+   return SymTable_new();
+}
+
+SymTable_T SymTable_newWithIntern(Intern_T oIntern)
+{
+   SymTable_T oSymTable;
+   assert(oIntern != NULL);
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+      return NULL;
+   oSymTable->oIntern = oIntern;
    return oSymTable;
 }
 
@@ -46,6 +392,16 @@ void SymTable_free(SymTable_T oSymTable)
 
    assert(oSymTable != NULL);
 
+   if (oSymTable->oFilter != NULL)
+      Filter_free(oSymTable->oFilter);
+
+   /* With an arena every binding and key goes at once*/
+   if (oSymTable->oArena != NULL){
+      Arena_free(oSymTable->oArena);
+      free(oSymTable);
+      return;
+   }
+
    /* Runs through the entire linked list 
    and frees all the dynamically allocated keys and 
    the binding object*/
@@ -54,10 +410,14 @@ void SymTable_free(SymTable_T oSymTable)
         psCurrentBinding = psNextBinding)
    {
       psNextBinding = psCurrentBinding->psNextBinding;
-      free((void *)(psCurrentBinding->pcKey));
-      free(psCurrentBinding);
+      SymTable_freeKey(oSymTable, psCurrentBinding);
+      if (oSymTable->oPool == NULL)
+         free(psCurrentBinding);
    }
 
+   /* Pooled bindings all go with the pool*/
+   if (oSymTable->oPool != NULL)
+      Arena_free(oSymTable->oPool);
    free(oSymTable);
 }
 
@@ -68,11 +428,21 @@ size_t SymTable_getLength(SymTable_T oSymTable)
 }
 
 int SymTable_contains(SymTable_T oSymTable, const char *pcKey){
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    return SymTable_containsN(oSymTable, pcKey, strlen(pcKey));
+}
+
+int SymTable_containsN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength){
     struct Binding *psCurrentBinding;
     struct Binding *psNextBinding;
 
     assert(oSymTable != NULL);
     assert(pcKey != NULL);
+    STATS_ADD_ATOMIC(oSymTable, ulContains, 1);
+    if (SymTable_filterRejects(oSymTable, pcKey, uLength))
+        return 0;
     /* Loops through the entire linked list and checks
     if any of the keys match the key passed in
     */
@@ -80,7 +450,8 @@ int SymTable_contains(SymTable_T oSymTable, const char *pcKey){
             psCurrentBinding != NULL;
             psCurrentBinding = psNextBinding)
     {
-        if (strcmp(psCurrentBinding->pcKey,pcKey)==0){
+        STATS_ADD_ATOMIC(oSymTable, ulProbes, 1);
+        if (SymTable_matches(psCurrentBinding, pcKey, uLength)){
             return 1;
         }
         psNextBinding = psCurrentBinding->psNextBinding;
@@ -88,46 +459,106 @@ int SymTable_contains(SymTable_T oSymTable, const char *pcKey){
     return 0; 
 }
 
-int SymTable_put(SymTable_T oSymTable,
-    const char *pcKey, const void *pvValue){
+/* Takes in SymTable_T oSymTable, the key const char *pcKey of
+size_t uLength characters and const void *pvValue and walks the
+linked list once: if pcKey is
+present it stores the existing value in *ppvValue and returns 0,
+otherwise it adds the new binding to the beginning of the linked
+list, stores pvValue in *ppvValue and returns 1. Returns -1 if
+there is not enough memory for the new binding*/
+static int SymTable_insert(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength, const void *pvValue, void **ppvValue){
+        struct Binding *psCurrentBinding;
         struct Binding *psNewBinding;
+
         assert(oSymTable != NULL);
+        assert(pcKey != NULL);
+        assert(ppvValue != NULL);
+
+        STATS_ADD(oSymTable, ulPuts, 1);
+        /* Makes sure not to add a binding with the same key, which
+        a key the filter rejects cannot be*/
+        for (psCurrentBinding = SymTable_filterRejects(oSymTable,
+                    pcKey, uLength) ? NULL : oSymTable->psFirstBinding;
+                psCurrentBinding != NULL;
+                psCurrentBinding = psCurrentBinding->psNextBinding)
+        {
+            STATS_ADD_ATOMIC(oSymTable, ulProbes, 1);
+            if (SymTable_matches(psCurrentBinding, pcKey, uLength)){
+                *ppvValue = psCurrentBinding->pvValue;
+                return 0;
+            }
+        }
 
-        /* Makes sure not to add a binding with the same key*/
-        if (SymTable_contains(oSymTable, pcKey)==1)
-            return 0;
-        psNewBinding = (struct Binding *) malloc(sizeof(struct Binding));
+        psNewBinding = SymTable_newBinding(oSymTable, pcKey, uLength);
         if (psNewBinding == NULL)
-            return 0;
+            return -1;
 
         /* Creates a new binding and moves the new binding to the beginning
         of the linked list*/
-        psNewBinding->pcKey=strcpy(malloc(strlen(pcKey)+1),pcKey);
-        /* Makes sure that we have enough room to allocate a new key*/
-        if (psNewBinding->pcKey==NULL){
-            free(psNewBinding);
-            return 0;
-        }
         psNewBinding->pvValue= (void *) pvValue;
         psNewBinding->psNextBinding=oSymTable->psFirstBinding;
         oSymTable->psFirstBinding=psNewBinding;
         oSymTable->length=oSymTable->length+1;
-        return 1; 
+        SymTable_filterAdd(oSymTable, pcKey, uLength);
+        *ppvValue = (void *) pvValue;
+        return 1;
+    }
+
+int SymTable_put(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue){
+        assert(oSymTable != NULL);
+        assert(pcKey != NULL);
+        return SymTable_putN(oSymTable, pcKey, strlen(pcKey), pvValue);
+    }
+
+int SymTable_putN(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, const void *pvValue){
+        void *pvFound;
+        assert(oSymTable != NULL);
+        return SymTable_insert(oSymTable, pcKey, uLength, pvValue,
+            &pvFound) == 1;
+    }
+
+int SymTable_putOrGet(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue, void **ppvValue){
+        void *pvFound;
+        int iResult;
+        assert(oSymTable != NULL);
+        assert(pcKey != NULL);
+
+        iResult = SymTable_insert(oSymTable, pcKey, strlen(pcKey),
+            pvValue, &pvFound);
+        if (iResult != -1 && ppvValue != NULL)
+            *ppvValue = pvFound;
+        return iResult;
     }
 
 void *SymTable_replace(SymTable_T oSymTable,
     const char *pcKey, const void *pvValue){
+        assert(oSymTable != NULL);
+        assert(pcKey != NULL);
+        return SymTable_replaceN(oSymTable, pcKey, strlen(pcKey),
+            pvValue);
+    }
+
+void *SymTable_replaceN(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, const void *pvValue){
         struct Binding *psCurrentBinding;
         struct Binding *psNextBinding;
 
         assert(oSymTable != NULL);
+        STATS_ADD(oSymTable, ulReplaces, 1);
+        if (SymTable_filterRejects(oSymTable, pcKey, uLength))
+            return NULL;
         /* Loop through the linked list until we find the key 
         and replace its value with the new value and return the old value*/
         for (psCurrentBinding = oSymTable->psFirstBinding;
                 psCurrentBinding != NULL;
                 psCurrentBinding = psNextBinding)
         {
-            if (strcmp(psCurrentBinding->pcKey,pcKey)==0){
+            STATS_ADD_ATOMIC(oSymTable, ulProbes, 1);
+            if (SymTable_matches(psCurrentBinding, pcKey, uLength)){
                 void * OldValue = psCurrentBinding->pvValue;
                 psCurrentBinding->pvValue= (void *) pvValue;
                 return OldValue; 
@@ -138,34 +569,60 @@ void *SymTable_replace(SymTable_T oSymTable,
     }
 
 void *SymTable_get(SymTable_T oSymTable, const char *pcKey){
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    return SymTable_getN(oSymTable, pcKey, strlen(pcKey));
+}
+
+void *SymTable_getN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength){
     struct Binding *psCurrentBinding;
-    struct Binding *psNextBinding;
+    struct Binding **ppsLink;
+    struct Binding **ppsPreviousLink = NULL;
 
     assert(oSymTable != NULL);
+    STATS_ADD_ATOMIC(oSymTable, ulGets, 1);
+    if (SymTable_filterRejects(oSymTable, pcKey, uLength))
+        return NULL;
     /* Same gist as SymTable_replace but this time we do not
-    replace anything*/
-    for (psCurrentBinding = oSymTable->psFirstBinding;
-            psCurrentBinding != NULL;
-            psCurrentBinding = psNextBinding)
+    replace anything, only follows the links so that the binding
+    found can be moved forward*/
+    for (ppsLink = &oSymTable->psFirstBinding;
+            (psCurrentBinding = *ppsLink) != NULL;
+            ppsLink = &psCurrentBinding->psNextBinding)
     {
-        if (strcmp(psCurrentBinding->pcKey,pcKey)==0){
+        STATS_ADD_ATOMIC(oSymTable, ulProbes, 1);
+        if (SymTable_matches(psCurrentBinding, pcKey, uLength)){
+            SymTable_reorder(oSymTable->eReorder,
+                &oSymTable->psFirstBinding, ppsPreviousLink, ppsLink);
             return psCurrentBinding->pvValue;
         }
-            psNextBinding = psCurrentBinding->psNextBinding;
+        ppsPreviousLink = ppsLink;
     }
     return NULL;
 }
 
 void *SymTable_remove(SymTable_T oSymTable, const char *pcKey){
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    return SymTable_removeN(oSymTable, pcKey, strlen(pcKey));
+}
+
+void *SymTable_removeN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength){
     struct Binding *psCurrentBinding;
     struct Binding *psPreviousBinding;
     struct Binding *psNextBinding;
     
     assert(oSymTable != NULL);
+    STATS_ADD(oSymTable, ulRemoves, 1);
+    if (SymTable_filterRejects(oSymTable, pcKey, uLength))
+        return NULL;
 
     psCurrentBinding=oSymTable->psFirstBinding;
     if(psCurrentBinding==NULL)
         return NULL;
+    STATS_ADD_ATOMIC(oSymTable, ulProbes, 1);
     /* Did it by casework since first case is linked
     to oSymTable whereas the others we can just call
     psNextBinding */
@@ -173,11 +630,11 @@ void *SymTable_remove(SymTable_T oSymTable, const char *pcKey){
     has the same key as the key passed in we remove it 
     and make the second binding the first one 
     and free the corresponding key and binding*/
-    if (strcmp(psCurrentBinding->pcKey,pcKey)==0){
+    if (SymTable_matches(psCurrentBinding, pcKey, uLength)){
         void * value = psCurrentBinding->pvValue;
         psNextBinding=psCurrentBinding->psNextBinding;
-        free((void *)(psCurrentBinding->pcKey));
-        free( psCurrentBinding);
+        SymTable_filterRemove(oSymTable, psCurrentBinding);
+        SymTable_freeBinding(oSymTable, psCurrentBinding);
         oSymTable->psFirstBinding = psNextBinding;
         oSymTable->length=oSymTable->length-1;
         return value;
@@ -191,11 +648,12 @@ void *SymTable_remove(SymTable_T oSymTable, const char *pcKey){
         psCurrentBinding = psCurrentBinding->psNextBinding;
         if (psCurrentBinding==NULL)
             return NULL;
-        if (strcmp(psCurrentBinding->pcKey,pcKey)==0){
+        STATS_ADD_ATOMIC(oSymTable, ulProbes, 1);
+        if (SymTable_matches(psCurrentBinding, pcKey, uLength)){
             void * value = psCurrentBinding->pvValue;
             psNextBinding=psCurrentBinding->psNextBinding;
-            free((void *) (psCurrentBinding->pcKey));
-            free(psCurrentBinding);
+            SymTable_filterRemove(oSymTable, psCurrentBinding);
+            SymTable_freeBinding(oSymTable, psCurrentBinding);
             psPreviousBinding->psNextBinding=psNextBinding;
             oSymTable->length=oSymTable->length-1;
             return value; 
@@ -204,6 +662,143 @@ void *SymTable_remove(SymTable_T oSymTable, const char *pcKey){
     return NULL;
 }
 
+void SymTable_getBatch(SymTable_T oSymTable, const char **ppcKeys,
+    size_t uCount, void **ppvValues){
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(ppcKeys != NULL || uCount == 0);
+    assert(ppvValues != NULL || uCount == 0);
+
+    /* Nothing to overlap in a single list, one get per key*/
+    for (i = 0; i < uCount; i++)
+        ppvValues[i] = SymTable_get(oSymTable, ppcKeys[i]);
+}
+
+size_t SymTable_putBatch(SymTable_T oSymTable, const char **ppcKeys,
+    void **ppvValues, size_t uCount){
+    size_t uInserted = 0;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(ppcKeys != NULL || uCount == 0);
+    assert(ppvValues != NULL || uCount == 0);
+
+    for (i = 0; i < uCount; i++)
+        if (SymTable_put(oSymTable, ppcKeys[i], ppvValues[i]))
+            uInserted++;
+    return uInserted;
+}
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCount){
+    struct Binding *psCurrentBinding;
+    struct Binding *psCopy;
+    struct Binding **ppsLink;
+    Arena_T oPool;
+
+    assert(oSymTable != NULL);
+
+    if (oSymTable->oFilter != NULL &&
+            uCount > Filter_getCapacity(oSymTable->oFilter) &&
+            ! SymTable_buildFilter(oSymTable, uCount))
+        return 0;
+    if (uCount <= oSymTable->length)
+        return 1;
+    if (oSymTable->oArena != NULL)
+        return Arena_reserveObjects(oSymTable->oArena,
+            uCount - oSymTable->length);
+    if (oSymTable->oPool != NULL)
+        return Arena_reserveObjects(oSymTable->oPool,
+            uCount - oSymTable->length);
+
+    /* The first call sets up the pool, one chunk holding every
+    binding, and moves the bindings so far into it so that every
+    binding can be given back to the pool*/
+    oPool = Arena_new(sizeof(struct Binding), uCount);
+    if (oPool == NULL)
+        return 0;
+    if (! Arena_reserveObjects(oPool, uCount)){
+        Arena_free(oPool);
+        return 0;
+    }
+    for (ppsLink = &oSymTable->psFirstBinding; *ppsLink != NULL;
+            ppsLink = &psCopy->psNextBinding){
+        psCurrentBinding = *ppsLink;
+        psCopy = (struct Binding *) Arena_allocObject(oPool);
+        *psCopy = *psCurrentBinding;
+        if (psCurrentBinding->pcKey == psCurrentBinding->acKey)
+            psCopy->pcKey = psCopy->acKey;
+        *ppsLink = psCopy;
+        free(psCurrentBinding);
+    }
+    oSymTable->oPool = oPool;
+    return 1;
+}
+
+void SymTable_setReorder(SymTable_T oSymTable,
+    enum SymTableReorder eReorder){
+    assert(oSymTable != NULL);
+    oSymTable->eReorder = eReorder;
+}
+
+int SymTable_setFilter(SymTable_T oSymTable, int iEnabled){
+    assert(oSymTable != NULL);
+
+    if (! iEnabled){
+        if (oSymTable->oFilter != NULL)
+            Filter_free(oSymTable->oFilter);
+        oSymTable->oFilter = NULL;
+        return 1;
+    }
+    if (oSymTable->oFilter != NULL)
+        return 1;
+    return SymTable_buildFilter(oSymTable, oSymTable->length);
+}
+
+void SymTable_compact(SymTable_T oSymTable){
+    assert(oSymTable != NULL);
+
+    /* A list only holds its bindings, each freed as it is
+    removed (into the pool, if reserved, which SymTable_free
+    releases), so there is nothing to shrink but the filter,
+    rebuilt to fit the bindings left */
+    if (oSymTable->oFilter != NULL)
+        (void)SymTable_buildFilter(oSymTable, oSymTable->length);
+}
+
+void SymTable_getStats(SymTable_T oSymTable,
+    struct SymTableStats *psStats){
+    struct Binding *psCurrentBinding;
+    size_t uChain;
+
+    assert(oSymTable != NULL);
+    assert(psStats != NULL);
+
+#ifdef SYMTABLE_STATS
+    *psStats = oSymTable->sStats;
+#else
+    memset(psStats, 0, sizeof(struct SymTableStats));
+#endif
+    /* The list is a single bucket holding every binding*/
+    psStats->uLength = oSymTable->length;
+    psStats->uBucketCount = 1;
+    psStats->dLoadFactor = (double)oSymTable->length;
+    psStats->uLongestChain = oSymTable->length;
+    memset(psStats->auChainLengths, 0, sizeof(psStats->auChainLengths));
+    uChain = oSymTable->length;
+    if (uChain >= SYMTABLE_STATS_CHAIN_LENGTHS)
+        uChain = SYMTABLE_STATS_CHAIN_LENGTHS - 1;
+    psStats->auChainLengths[uChain] = 1;
+    psStats->uKeyBytes = 0;
+    for (psCurrentBinding = oSymTable->psFirstBinding;
+            psCurrentBinding != NULL;
+            psCurrentBinding = psCurrentBinding->psNextBinding)
+        psStats->uKeyBytes += psCurrentBinding->uLength + 1;
+    psStats->uBindingBytes = oSymTable->length * sizeof(struct Binding);
+    if (oSymTable->oFilter != NULL)
+        psStats->uBindingBytes += Filter_getBytes(oSymTable->oFilter);
+}
+
 void SymTable_map(SymTable_T oSymTable,
     void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
     const void *pvExtra){
@@ -241,3 +836,108 @@ void SymTable_map(SymTable_T oSymTable,
 
 
 
+
+/* Takes in size_t uStart, size_t uEnd and the struct MapTask
+*pvTask and applies its function to the bindings uStart to uEnd - 1
+of it. Returns nothing*/
+static void SymTable_mapTask(size_t uStart, size_t uEnd, void *pvTask)
+{
+    struct MapTask *psTask = pvTask;
+    size_t i;
+
+    for (i = uStart; i < uEnd; i++)
+        (*psTask->pfApply)(psTask->ppsBindings[i]->pcKey,
+            psTask->ppsBindings[i]->pvValue, psTask->pvExtra);
+}
+
+void SymTable_mapParallel(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra, int iThreads){
+    struct MapTask sTask;
+    struct Binding *psCurrentBinding;
+    size_t i = 0;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    if (iThreads <= 1){
+        SymTable_map(oSymTable, pfApply, pvExtra);
+        return;
+    }
+
+    /* A list cannot be split without walking it, so it is walked
+    once up front and the threads split the array of bindings*/
+    sTask.ppsBindings = malloc(oSymTable->length
+        * sizeof(struct Binding *));
+    if (sTask.ppsBindings == NULL){
+        SymTable_map(oSymTable, pfApply, pvExtra);
+        return;
+    }
+    for (psCurrentBinding = oSymTable->psFirstBinding;
+            psCurrentBinding != NULL;
+            psCurrentBinding = psCurrentBinding->psNextBinding)
+        sTask.ppsBindings[i++] = psCurrentBinding;
+    sTask.pfApply = pfApply;
+    sTask.pvExtra = (void *)pvExtra;
+    Parallel_run(oSymTable->length, MAP_GRAIN, iThreads,
+        SymTable_mapTask, &sTask);
+    free(sTask.ppsBindings);
+}
+
+SymTableIter_T SymTable_iterBegin(SymTable_T oSymTable){
+    SymTableIter_T oIter;
+
+    assert(oSymTable != NULL);
+
+    oIter = (SymTableIter_T)malloc(sizeof(struct SymTableIter));
+    if (oIter == NULL)
+        return NULL;
+    oIter->oSymTable = oSymTable;
+    oIter->ppsLink = &oSymTable->psFirstBinding;
+    oIter->psCurrent = NULL;
+    return oIter;
+}
+
+int SymTable_iterNext(SymTableIter_T oIter, const char **ppcKey,
+    void **ppvValue){
+    assert(oIter != NULL);
+
+    /* Steps past the current binding, unless it was removed and
+    the link already leads to the one after it*/
+    if (oIter->psCurrent != NULL)
+        oIter->ppsLink = &oIter->psCurrent->psNextBinding;
+    oIter->psCurrent = *oIter->ppsLink;
+    if (oIter->psCurrent == NULL)
+        return 0;
+    if (ppcKey != NULL)
+        *ppcKey = oIter->psCurrent->pcKey;
+    if (ppvValue != NULL)
+        *ppvValue = oIter->psCurrent->pvValue;
+    return 1;
+}
+
+void *SymTable_iterRemove(SymTableIter_T oIter){
+    struct Binding *psCurrentBinding;
+    void *value;
+
+    assert(oIter != NULL);
+
+    /* The link into the binding is at hand, so it is unlinked
+    without walking the list again*/
+    psCurrentBinding = oIter->psCurrent;
+    if (psCurrentBinding == NULL)
+        return NULL;
+    STATS_ADD(oIter->oSymTable, ulRemoves, 1);
+    value = psCurrentBinding->pvValue;
+    *oIter->ppsLink = psCurrentBinding->psNextBinding;
+    SymTable_filterRemove(oIter->oSymTable, psCurrentBinding);
+    SymTable_freeBinding(oIter->oSymTable, psCurrentBinding);
+    oIter->oSymTable->length--;
+    oIter->psCurrent = NULL;
+    return value;
+}
+
+void SymTable_iterEnd(SymTableIter_T oIter){
+    assert(oIter != NULL);
+    free(oIter);
+}
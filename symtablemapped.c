@@ -0,0 +1,433 @@
+/* Symbol table snapshot implementation*/
+/* A snapshot is one file holding a header, the values, the keys,
+the entries and the bucket index, in that order, each section
+aligned for any type. The entries are sorted by bucket, so the
+index needs a single entry number per bucket: bucket i holds the
+entries auBuckets[i] to auBuckets[i + 1] - 1, and a lookup reads
+one run of neighbouring entries. Every other position is an offset
+from the start of the file*/
+#define _POSIX_C_SOURCE 200112L
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "symtablemapped.h"
+#include "strhash.h"
+#include <string.h>
+
+/* Every section and every value starts at a multiple of the size
+of this union, so it is aligned for any of these*/
+union Align
+{
+   void *pv;
+   long l;
+   double d;
+   size_t u;
+};
+
+/* The first bytes of every snapshot, including the null
+character*/
+static const char acMagic[8] = "SYMTAB1";
+
+/* Stored right after the magic. A machine with another size_t or
+byte order reads it back as another number*/
+#define MAPPED_CHECK ((size_t)0x01020304UL + sizeof(size_t))
+
+/* The start of a snapshot*/
+struct Header
+{
+   /* acMagic*/
+   char acMagic[8];
+
+   /* MAPPED_CHECK*/
+   size_t uCheck;
+
+   /* The size of the file in bytes*/
+   size_t uSize;
+
+   /* The number of bindings, and so of entries*/
+   size_t uLength;
+
+   /* The number of buckets, a power of two*/
+   size_t uBucketCount;
+
+   /* The offsets of the entries and of the bucket index*/
+   size_t uEntries;
+   size_t uBuckets;
+};
+
+/* A binding of a snapshot*/
+struct Entry
+{
+   /* The StrHash_hash of the key, compared before the key*/
+   size_t uHash;
+
+   /* The offset of the key, null-terminated, and its number of
+   characters*/
+   size_t uKey;
+   size_t uLength;
+
+   /* The offset of the bytes of the value and their number*/
+   size_t uValue;
+   size_t uSize;
+};
+
+/* A mapped snapshot, everything but this struct being in the
+file*/
+struct SymTableMapped
+{
+   /* The file image and its size*/
+   const char *pcImage;
+   size_t uSize;
+
+   /* Its header, entries and bucket index*/
+   const struct Header *psHeader;
+   const struct Entry *asEntries;
+   const size_t *auBuckets;
+};
+
+/* The bindings of the table being saved, gathered by SymTable_map*/
+struct Save
+{
+   /* The keys, values and entries, uCount of them so far out of
+   uCapacity*/
+   const char **ppcKeys;
+   void **ppvValues;
+   struct Entry *asEntries;
+   size_t uCount;
+   size_t uCapacity;
+};
+
+/* Takes in a binding const char *pcKey, void *pvValue and the
+struct Save *pvSave and adds the binding to it. Returns nothing*/
+static void SymTable_gather(const char *pcKey, void *pvValue,
+    void *pvSave)
+{
+   struct Save *psSave = pvSave;
+
+   if (psSave->uCount == psSave->uCapacity)
+      return;
+   psSave->ppcKeys[psSave->uCount] = pcKey;
+   psSave->ppvValues[psSave->uCount] = pvValue;
+   psSave->uCount++;
+}
+
+/* Takes in FILE *psFile, const void *pvBytes, size_t uSize and
+size_t *puOffset, the offset psFile is at, writes the uSize bytes
+and moves *puOffset past them. Returns 1, or 0 if they could not
+all be written*/
+static int SymTable_write(FILE *psFile, const void *pvBytes,
+    size_t uSize, size_t *puOffset)
+{
+   if (uSize == 0)
+      return 1;
+   *puOffset += uSize;
+   return fwrite(pvBytes, 1, uSize, psFile) == uSize;
+}
+
+/* Takes in FILE *psFile and size_t *puOffset, the offset psFile is
+at, and writes zeros up to the next multiple of
+sizeof(union Align). Returns 1, or 0 if they could not be written*/
+static int SymTable_pad(FILE *psFile, size_t *puOffset)
+{
+   static const union Align uZero;
+   size_t uPad;
+
+   uPad = (sizeof(union Align) - *puOffset % sizeof(union Align))
+      % sizeof(union Align);
+   return SymTable_write(psFile, &uZero, uPad, puOffset);
+}
+
+/* Takes in FILE *psFile, struct Save *psSave with its keys, values
+and hashes gathered, and the pfSerialize and pvExtra of
+SymTable_save, and writes every section after the header, filling
+*psHeader. Returns 1, or 0 if there is not enough memory or the
+file cannot be written*/
+static int SymTable_writeSections(FILE *psFile, struct Save *psSave,
+    const void *(*pfSerialize)(const void *pvValue, size_t *puSize,
+        void *pvExtra),
+    void *pvExtra, struct Header *psHeader)
+{
+   struct Entry *asSorted;
+   size_t *auBuckets;
+   const void *pvBytes;
+   size_t uOffset = sizeof(struct Header);
+   size_t uBucket;
+   size_t i;
+   int iOk;
+
+   /* The values first, as pfSerialize hands them out*/
+   iOk = SymTable_pad(psFile, &uOffset);
+   for (i = 0; i < psSave->uCount && iOk; i++){
+      pvBytes = NULL;
+      psSave->asEntries[i].uSize = 0;
+      if (pfSerialize != NULL)
+         pvBytes = (*pfSerialize)(psSave->ppvValues[i],
+            &psSave->asEntries[i].uSize, pvExtra);
+      assert(pvBytes != NULL || psSave->asEntries[i].uSize == 0);
+      psSave->asEntries[i].uValue = uOffset;
+      iOk = SymTable_write(psFile, pvBytes,
+         psSave->asEntries[i].uSize, &uOffset)
+         && SymTable_pad(psFile, &uOffset);
+   }
+
+   /* Then the keys, one after the other*/
+   for (i = 0; i < psSave->uCount && iOk; i++){
+      psSave->asEntries[i].uKey = uOffset;
+      iOk = SymTable_write(psFile, psSave->ppcKeys[i],
+         psSave->asEntries[i].uLength + 1, &uOffset);
+   }
+   iOk = iOk && SymTable_pad(psFile, &uOffset);
+   if (! iOk)
+      return 0;
+
+   /* Then the entries, sorted by bucket by counting them first*/
+   auBuckets = calloc(psHeader->uBucketCount + 1, sizeof(size_t));
+   asSorted = malloc((psSave->uCount + 1) * sizeof(struct Entry));
+   if (auBuckets == NULL || asSorted == NULL){
+      free(auBuckets);
+      free(asSorted);
+      return 0;
+   }
+   for (i = 0; i < psSave->uCount; i++)
+      auBuckets[(psSave->asEntries[i].uHash
+         & (psHeader->uBucketCount - 1)) + 1]++;
+   for (i = 0; i < psHeader->uBucketCount; i++)
+      auBuckets[i + 1] += auBuckets[i];
+   for (i = 0; i < psSave->uCount; i++){
+      uBucket = psSave->asEntries[i].uHash
+         & (psHeader->uBucketCount - 1);
+      asSorted[auBuckets[uBucket]++] = psSave->asEntries[i];
+   }
+   /* Placing the entries moved each start to the next bucket's*/
+   for (i = psHeader->uBucketCount; i > 0; i--)
+      auBuckets[i] = auBuckets[i - 1];
+   auBuckets[0] = 0;
+
+   psHeader->uEntries = uOffset;
+   iOk = SymTable_write(psFile, asSorted,
+      psSave->uCount * sizeof(struct Entry), &uOffset);
+   psHeader->uBuckets = uOffset;
+   iOk = iOk && SymTable_write(psFile, auBuckets,
+      (psHeader->uBucketCount + 1) * sizeof(size_t), &uOffset);
+   psHeader->uSize = uOffset;
+   free(auBuckets);
+   free(asSorted);
+   return iOk;
+}
+
+int SymTable_save(SymTable_T oSymTable, const char *pcPath,
+    const void *(*pfSerialize)(const void *pvValue, size_t *puSize,
+        void *pvExtra),
+    void *pvExtra)
+{
+   struct Header sHeader;
+   struct Save sSave;
+   FILE *psFile;
+   size_t i;
+   int iOk;
+
+   assert(oSymTable != NULL);
+   assert(pcPath != NULL);
+
+   /* The + 1 keeps an empty table from asking malloc for 0 bytes*/
+   sSave.uCount = 0;
+   sSave.uCapacity = SymTable_getLength(oSymTable);
+   sSave.ppcKeys = malloc((sSave.uCapacity + 1) * sizeof(char *));
+   sSave.ppvValues = malloc((sSave.uCapacity + 1) * sizeof(void *));
+   sSave.asEntries = malloc((sSave.uCapacity + 1)
+      * sizeof(struct Entry));
+   iOk = sSave.ppcKeys != NULL && sSave.ppvValues != NULL
+      && sSave.asEntries != NULL;
+   if (iOk){
+      SymTable_map(oSymTable, SymTable_gather, &sSave);
+      for (i = 0; i < sSave.uCount; i++){
+         sSave.asEntries[i].uLength = strlen(sSave.ppcKeys[i]);
+         sSave.asEntries[i].uHash = StrHash_hash(sSave.ppcKeys[i],
+            sSave.asEntries[i].uLength);
+      }
+   }
+
+   /* At most one binding per bucket on average*/
+   memset(&sHeader, 0, sizeof(sHeader));
+   memcpy(sHeader.acMagic, acMagic, sizeof(acMagic));
+   sHeader.uCheck = MAPPED_CHECK;
+   sHeader.uLength = sSave.uCount;
+   sHeader.uBucketCount = 1;
+   while (sHeader.uBucketCount < sSave.uCount)
+      sHeader.uBucketCount *= 2;
+
+   /* The header goes first, rewritten once the sections after it
+   are placed*/
+   psFile = iOk ? fopen(pcPath, "wb") : NULL;
+   iOk = psFile != NULL
+      && fwrite(&sHeader, sizeof(sHeader), 1, psFile) == 1
+      && SymTable_writeSections(psFile, &sSave, pfSerialize, pvExtra,
+         &sHeader)
+      && fseek(psFile, 0L, SEEK_SET) == 0
+      && fwrite(&sHeader, sizeof(sHeader), 1, psFile) == 1;
+   if (psFile != NULL && fclose(psFile) != 0)
+      iOk = 0;
+   free(sSave.ppcKeys);
+   free(sSave.ppvValues);
+   free(sSave.asEntries);
+   return iOk;
+}
+
+/* Takes in const struct Header *psHeader and size_t uSize, the
+size of the file it starts, and returns 1 if it is the header of a
+snapshot of that size written on a machine like this one, with
+every section within the file, 0 otherwise*/
+static int SymTable_checkHeader(const struct Header *psHeader,
+    size_t uSize)
+{
+   size_t uEntriesEnd;
+
+   if (memcmp(psHeader->acMagic, acMagic, sizeof(acMagic)) != 0 ||
+         psHeader->uCheck != MAPPED_CHECK ||
+         psHeader->uSize != uSize)
+      return 0;
+   if (psHeader->uBucketCount == 0 ||
+         (psHeader->uBucketCount & (psHeader->uBucketCount - 1)) != 0 ||
+         psHeader->uBucketCount > uSize / sizeof(size_t))
+      return 0;
+   if (psHeader->uLength > uSize / sizeof(struct Entry) ||
+         psHeader->uEntries % sizeof(union Align) != 0 ||
+         psHeader->uEntries < sizeof(struct Header) ||
+         psHeader->uEntries > uSize)
+      return 0;
+   uEntriesEnd = psHeader->uEntries
+      + psHeader->uLength * sizeof(struct Entry);
+   return uEntriesEnd >= psHeader->uEntries &&
+      psHeader->uBuckets == uEntriesEnd &&
+      uSize - uEntriesEnd ==
+         (psHeader->uBucketCount + 1) * sizeof(size_t);
+}
+
+SymTableMapped_T SymTable_openMapped(const char *pcPath)
+{
+   SymTableMapped_T oMapped;
+   struct stat sStat;
+   void *pvImage;
+   size_t uSize;
+   int iFile;
+
+   assert(pcPath != NULL);
+
+   iFile = open(pcPath, O_RDONLY);
+   if (iFile < 0)
+      return NULL;
+   if (fstat(iFile, &sStat) != 0 ||
+         (size_t)sStat.st_size < sizeof(struct Header)){
+      close(iFile);
+      return NULL;
+   }
+
+   /* The mapping outlives the descriptor*/
+   uSize = (size_t)sStat.st_size;
+   pvImage = mmap(NULL, uSize, PROT_READ, MAP_SHARED, iFile, 0);
+   close(iFile);
+   if (pvImage == MAP_FAILED)
+      return NULL;
+
+   oMapped = malloc(sizeof(struct SymTableMapped));
+   if (oMapped == NULL ||
+         ! SymTable_checkHeader((const struct Header *)pvImage, uSize)){
+      free(oMapped);
+      munmap(pvImage, uSize);
+      return NULL;
+   }
+   oMapped->pcImage = pvImage;
+   oMapped->uSize = uSize;
+   oMapped->psHeader = (const struct Header *)pvImage;
+   oMapped->asEntries = (const struct Entry *)(void *)
+      (oMapped->pcImage + oMapped->psHeader->uEntries);
+   oMapped->auBuckets = (const size_t *)(void *)
+      (oMapped->pcImage + oMapped->psHeader->uBuckets);
+   return oMapped;
+}
+
+void SymTableMapped_free(SymTableMapped_T oMapped)
+{
+   assert(oMapped != NULL);
+
+   munmap((void *)oMapped->pcImage, oMapped->uSize);
+   free(oMapped);
+}
+
+size_t SymTableMapped_getLength(SymTableMapped_T oMapped)
+{
+   assert(oMapped != NULL);
+   return oMapped->psHeader->uLength;
+}
+
+/* Takes in SymTableMapped_T oMapped and a key const char *pcKey
+and returns the entry of pcKey, or NULL if there is none*/
+static const struct Entry *SymTableMapped_find(
+    SymTableMapped_T oMapped, const char *pcKey)
+{
+   const struct Entry *psEntry;
+   size_t uLength;
+   size_t uHash;
+   size_t uBucket;
+   size_t i;
+
+   uLength = strlen(pcKey);
+   uHash = StrHash_hash(pcKey, uLength);
+   uBucket = uHash & (oMapped->psHeader->uBucketCount - 1);
+   for (i = oMapped->auBuckets[uBucket];
+         i < oMapped->auBuckets[uBucket + 1]; i++){
+      psEntry = &oMapped->asEntries[i];
+      if (psEntry->uHash == uHash && psEntry->uLength == uLength &&
+            memcmp(oMapped->pcImage + psEntry->uKey, pcKey,
+               uLength) == 0)
+         return psEntry;
+   }
+   return NULL;
+}
+
+int SymTableMapped_contains(SymTableMapped_T oMapped,
+    const char *pcKey)
+{
+   assert(oMapped != NULL);
+   assert(pcKey != NULL);
+   return SymTableMapped_find(oMapped, pcKey) != NULL;
+}
+
+const void *SymTableMapped_get(SymTableMapped_T oMapped,
+    const char *pcKey, size_t *puSize)
+{
+   const struct Entry *psEntry;
+
+   assert(oMapped != NULL);
+   assert(pcKey != NULL);
+
+   psEntry = SymTableMapped_find(oMapped, pcKey);
+   if (psEntry == NULL)
+      return NULL;
+   if (puSize != NULL)
+      *puSize = psEntry->uSize;
+   return oMapped->pcImage + psEntry->uValue;
+}
+
+void SymTableMapped_map(SymTableMapped_T oMapped,
+    void (*pfApply)(const char *pcKey, const void *pvValue,
+        size_t uSize, void *pvExtra),
+    void *pvExtra)
+{
+   const struct Entry *psEntry;
+   size_t i;
+
+   assert(oMapped != NULL);
+   assert(pfApply != NULL);
+
+   for (i = 0; i < oMapped->psHeader->uLength; i++){
+      psEntry = &oMapped->asEntries[i];
+      (*pfApply)(oMapped->pcImage + psEntry->uKey,
+         oMapped->pcImage + psEntry->uValue, psEntry->uSize,
+         pvExtra);
+   }
+}
@@ -0,0 +1,73 @@
+/* Interface of the snapshots of symtablemapped.c: SymTable_save
+writes the bindings of any symbol table to a file, and
+SymTable_openMapped maps such a file back as a read-only table
+whose lookups run on the file image itself, with nothing to
+rebuild. The image holds offsets instead of pointers, so it can be
+mapped at any address, but it is only meant to be read on a machine
+with the same size_t and byte order as the one that wrote it*/
+#ifndef SYMTABLEMAPPED_INCLUDED
+#define SYMTABLEMAPPED_INCLUDED
+#include <stddef.h>
+#include "symtable.h"
+
+/* For concision SymTableMapped_T is defined to be a pointer to a
+struct SymTableMapped, a read-only table mapped from a file*/
+typedef struct SymTableMapped *SymTableMapped_T;
+
+/* SymTable_save takes in a SymTable_T oSymTable, a const char
+*pcPath, function *pfSerialize(const void *pvValue, size_t *puSize,
+void *pvExtra) and a void *pvExtra, and writes every binding of
+oSymTable to the file pcPath, replacing it, each key up to its
+first null character. pfSerialize returns the
+bytes to save for a value and stores their number in *puSize, the
+bytes only needing to stay valid until its next call. If pfSerialize
+is NULL each value is saved as 0 bytes. Returns 1, or 0 if there is
+not enough memory or the file cannot be written, in which case the
+file may be left incomplete*/
+int SymTable_save(SymTable_T oSymTable, const char *pcPath,
+    const void *(*pfSerialize)(const void *pvValue, size_t *puSize,
+        void *pvExtra),
+    void *pvExtra);
+
+/* SymTable_openMapped takes in a const char *pcPath, a file written
+by SymTable_save, and returns a SymTableMapped_T that reads it in
+place, or NULL if it cannot be opened or mapped, or is not such a
+file. Only the header is checked, the rest is trusted. Opening takes
+the same time whatever the size of the file, pages being read as
+lookups first touch them*/
+SymTableMapped_T SymTable_openMapped(const char *pcPath);
+
+/* SymTableMapped_free takes in a SymTableMapped_T oMapped and
+unmaps it, after which no key or value it returned may be used.
+Returns nothing (void)*/
+void SymTableMapped_free(SymTableMapped_T oMapped);
+
+/* SymTableMapped_getLength takes in a SymTableMapped_T oMapped and
+returns its size_t number of bindings*/
+size_t SymTableMapped_getLength(SymTableMapped_T oMapped);
+
+/* SymTableMapped_contains takes in a SymTableMapped_T oMapped and a
+key const char *pcKey and returns an int 1 if oMapped holds pcKey,
+0 otherwise*/
+int SymTableMapped_contains(SymTableMapped_T oMapped,
+    const char *pcKey);
+
+/* SymTableMapped_get takes in a SymTableMapped_T oMapped, a key
+const char *pcKey and a size_t *puSize and returns the saved bytes
+of the value of pcKey, in the mapped file, storing their number in
+*puSize unless puSize is NULL. The bytes are aligned for any type.
+Returns NULL, leaving *puSize untouched, if pcKey is not there*/
+const void *SymTableMapped_get(SymTableMapped_T oMapped,
+    const char *pcKey, size_t *puSize);
+
+/* SymTableMapped_map takes in a SymTableMapped_T oMapped, function
+*pfApply(const char *pcKey, const void *pvValue, size_t uSize,
+void *pvExtra) and a void *pvExtra, and applies pfApply to each
+binding, with the saved bytes of its value and their number, in no
+particular order. Returns nothing (void)*/
+void SymTableMapped_map(SymTableMapped_T oMapped,
+    void (*pfApply)(const char *pcKey, const void *pvValue,
+        size_t uSize, void *pvExtra),
+    void *pvExtra);
+
+#endif
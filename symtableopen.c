@@ -0,0 +1,1063 @@
+/* Symbol table open addressing implementation*/
+#include <assert.h>
+#include <stdlib.h>
+#include "symtable.h"
+#include "arena.h"
+#include "strhash.h"
+#include "prefetch.h"
+#include "parallel.h"
+#include "symtablestats.h"
+#include <string.h>
+
+/* SSE2, which every x86-64 processor has, compares a window of
+control bytes at once. Elsewhere, or with -DSYMTABLE_NO_SIMD, the
+window is a single byte and probing goes slot by slot*/
+#if defined(__SSE2__) && !defined(SYMTABLE_NO_SIMD)
+#define SYMTABLE_SSE2
+#include <emmintrin.h>
+#endif
+
+/* Control byte values. A full slot stores the low 7 bits of its
+hash (a tag in 0x00-0x7F), so a single byte comparison filters out
+almost every non-matching slot before the key is ever touched */
+enum {CTRL_EMPTY = 0x80, CTRL_DELETED = 0xFE};
+
+/* Probes look at the control bytes of GROUP_WIDTH slots in a row
+at once, starting from any slot. The control array carries a copy
+of its first GROUP_WIDTH - 1 bytes after its end so that a window
+near the end wraps around without a second load*/
+#ifdef SYMTABLE_SSE2
+enum {GROUP_WIDTH = 16};
+#else
+enum {GROUP_WIDTH = 1};
+#endif
+
+/* The number of slots a new table starts with, always a power
+of two so that the probe position can be masked instead of
+taken modulo, and at least GROUP_WIDTH*/
+enum {INITIAL_SLOT_COUNT = 16};
+
+/* The table grows once full plus deleted slots would exceed
+MAX_LOAD_NUM/MAX_LOAD_DEN of the slots, which also guarantees
+that every probe sequence ends at an empty slot*/
+enum {MAX_LOAD_NUM = 7, MAX_LOAD_DEN = 8};
+
+/* The table is shrunk to half its slots, never below
+INITIAL_SLOT_COUNT, once fewer than MIN_LOAD_NUM/MIN_LOAD_DEN of
+them are full. A quarter of the maximum, so a resized table is
+far from both limits and never resizes back and forth*/
+enum {MIN_LOAD_NUM = 7, MIN_LOAD_DEN = 32};
+
+/* The batch functions work through the keys this many at a time:
+hash them all and prefetch the control byte and slot where each
+probe starts (and for lookups the key in that slot) before
+probing any of them*/
+enum {BATCH_SIZE = 16};
+
+/* SymTable_mapParallel hands out this many slots at a time*/
+enum {MAP_GRAIN = 4096};
+
+/* Keys of fewer than SYMTABLE_INLINE_KEY_SIZE characters are stored
+inside their slot instead of in a copy of their own, can be
+overridden at compile time with -D*/
+#ifndef SYMTABLE_INLINE_KEY_SIZE
+#define SYMTABLE_INLINE_KEY_SIZE 16
+#endif
+
+/* A slot of the flat binding array*/
+struct Slot
+{
+   /* Key*/
+   const char *pcKey;
+
+   /* Value*/
+   void *pvValue;
+
+   /* Full hash of the key, kept so growing never rehashes
+   a key string*/
+   size_t uHash;
+
+   /* The number of characters of the key, compared right after
+   the hash so keys of another length never reach memcmp*/
+   size_t uLength;
+
+   /* A short key is copied here and pcKey points at it, so it
+   takes no allocation of its own and a lookup that reaches the
+   slot already has the key. Moving the slot moves pcKey along*/
+   char acKey[SYMTABLE_INLINE_KEY_SIZE];
+};
+
+/* SymTable keeps the bindings in one flat array of slots with a
+parallel array of control bytes*/
+struct SymTable
+{
+   /* The number of bindings*/
+   size_t length;
+
+   /* The number of slots marked CTRL_DELETED*/
+   size_t uDeleted;
+
+   /* The number of slots, a power of two*/
+   size_t SlotCount;
+
+   /* The fewest slots the table shrinks back to on its own,
+   INITIAL_SLOT_COUNT unless raised by SymTable_reserve*/
+   size_t SlotCountMin;
+
+   /* One control byte per slot*/
+   unsigned char *ctrl;
+
+   /* Array of SlotCount slots*/
+   struct Slot *slots;
+
+   /* Arena the keys are packed into, NULL when each key is
+   malloc'd on its own. The slots are already one flat array
+   so only the keys need it*/
+   Arena_T oArena;
+
+   /* The pool every key is interned in, NULL when the table
+   copies its own keys*/
+   Intern_T oIntern;
+
+   /* Hash function applied to the keys*/
+   size_t (*pfHash)(const char *pcKey, size_t uLength);
+
+#ifdef SYMTABLE_STATS
+   /* The counters reported by SymTable_getStats*/
+   struct SymTableStats sStats;
+#endif
+};
+
+/* What every thread of SymTable_mapParallel is given*/
+struct MapTask
+{
+   /* The table mapped*/
+   SymTable_T oSymTable;
+
+   /* The function applied to each binding and its extra
+   parameter*/
+   void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra);
+   void *pvExtra;
+};
+
+/* A cursor over the slots in array order*/
+struct SymTableIter
+{
+   /* The table walked*/
+   SymTable_T oSymTable;
+
+   /* The slot of the binding the cursor is at, SlotCount before
+   the first one and after it was removed*/
+   size_t uCurrent;
+
+   /* The slot the search for the next full one starts from*/
+   size_t uNext;
+};
+
+/* Hash Function takes in SymTable_T oSymTable and the key const
+char *pcKey of size_t uLength characters and returns the full
+size_t hash given by the hash function of oSymTable. Both the low
+7 bits (the tag) and the higher bits (the position) are used, so
+it has to mix well*/
+static size_t SymTable_hash(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength)
+{
+   assert(pcKey != NULL);
+   return (*oSymTable->pfHash)(pcKey, uLength);
+}
+
+/* Returns the control byte tag that a full slot holding
+a key with hash uHash carries*/
+static unsigned char SymTable_tag(size_t uHash)
+{
+   return (unsigned char)(uHash & 0x7F);
+}
+
+/* Returns the first slot that the probe sequence for
+hash uHash visits in a table of uSlotCount slots*/
+static size_t SymTable_start(size_t uHash, size_t uSlotCount)
+{
+   return (uHash >> 7) & (uSlotCount - 1);
+}
+
+/* Takes in the GROUP_WIDTH control bytes const unsigned char
+*pucWindow and an unsigned char c and returns a mask with bit j set
+if control byte j of the window is c*/
+static unsigned int SymTable_matchByte(const unsigned char *pucWindow,
+    unsigned char c)
+{
+#ifdef SYMTABLE_SSE2
+   __m128i window;
+
+   window = _mm_loadu_si128((const __m128i *)(const void *)pucWindow);
+   return (unsigned int)_mm_movemask_epi8(
+      _mm_cmpeq_epi8(window, _mm_set1_epi8((char)c)));
+#else
+   unsigned int uMask = 0;
+   int j;
+
+   for (j = GROUP_WIDTH - 1; j >= 0; j--)
+      uMask = (uMask << 1) | (pucWindow[j] == c);
+   return uMask;
+#endif
+}
+
+/* Takes in the GROUP_WIDTH control bytes const unsigned char
+*pucWindow and returns a mask with bit j set if slot j of the
+window is empty or deleted, which are the control bytes with the
+high bit set*/
+static unsigned int SymTable_matchFree(const unsigned char *pucWindow)
+{
+#ifdef SYMTABLE_SSE2
+   return (unsigned int)_mm_movemask_epi8(
+      _mm_loadu_si128((const __m128i *)(const void *)pucWindow));
+#else
+   unsigned int uMask = 0;
+   int j;
+
+   for (j = GROUP_WIDTH - 1; j >= 0; j--)
+      uMask = (uMask << 1) | (pucWindow[j] >> 7);
+   return uMask;
+#endif
+}
+
+/* Takes in a mask uEmpty of the empty slots of a window and
+returns the mask of the slots before the first of them, which are
+all the window has of the probe sequence. A window of one slot
+that matches a tag is not empty, so it needs no mask*/
+static unsigned int SymTable_beforeEmpty(unsigned int uEmpty)
+{
+   if (GROUP_WIDTH == 1 || uEmpty == 0)
+      return (1U << GROUP_WIDTH) - 1;
+   return (uEmpty & (0U - uEmpty)) - 1;
+}
+
+/* Returns the index of the lowest bit set in uMask, which must not
+be 0*/
+static size_t SymTable_lowestBit(unsigned int uMask)
+{
+#ifdef __GNUC__
+   return (size_t)__builtin_ctz(uMask);
+#else
+   size_t j = 0;
+
+   assert(uMask != 0);
+   while (!(uMask & 1)){
+      uMask >>= 1;
+      j++;
+   }
+   return j;
+#endif
+}
+
+/* Takes in SymTable_T oSymTable, a size_t i and an unsigned char c
+and sets the control byte of slot i to c, along with its copy past
+the end of the array if it has one. Returns nothing*/
+static void SymTable_setCtrl(SymTable_T oSymTable, size_t i,
+    unsigned char c)
+{
+   oSymTable->ctrl[i] = c;
+   if (i + 1 < GROUP_WIDTH)
+      oSymTable->ctrl[oSymTable->SlotCount + i] = c;
+}
+
+/* Allocates the control and slot arrays of oSymTable for
+uSlotCount slots, all empty. Returns 1 on success and 0
+(leaving oSymTable untouched) if there is not enough memory*/
+static int SymTable_allocSlots(SymTable_T oSymTable, size_t uSlotCount)
+{
+   unsigned char *ctrl;
+   struct Slot *slots;
+
+   ctrl = malloc(uSlotCount + GROUP_WIDTH - 1);
+   if (ctrl == NULL)
+      return 0;
+   slots = malloc(uSlotCount * sizeof(struct Slot));
+   if (slots == NULL){
+      free(ctrl);
+      return 0;
+   }
+   memset(ctrl, CTRL_EMPTY, uSlotCount + GROUP_WIDTH - 1);
+   oSymTable->ctrl = ctrl;
+   oSymTable->slots = slots;
+   oSymTable->SlotCount = uSlotCount;
+   oSymTable->uDeleted = 0;
+   return 1;
+}
+
+/* Takes in SymTable_T oSymTable, struct Slot *psSlot and the key
+const char *pcKey of size_t uLength characters and sets the key of
+psSlot to a copy of pcKey owned by oSymTable, inline in psSlot if
+it is short, or to the interned pcKey if oSymTable interns its
+keys. Returns 1, or 0 if there is not enough memory*/
+static int SymTable_copyKey(SymTable_T oSymTable, struct Slot *psSlot,
+    const char *pcKey, size_t uLength)
+{
+   char *pcKeyCopy;
+
+   if (oSymTable->oIntern != NULL){
+      psSlot->pcKey = Intern_addN(oSymTable->oIntern, pcKey, uLength);
+      psSlot->uLength = uLength;
+      return psSlot->pcKey != NULL;
+   }
+   if (uLength < SYMTABLE_INLINE_KEY_SIZE)
+      pcKeyCopy = psSlot->acKey;
+   else if (oSymTable->oArena != NULL)
+      pcKeyCopy = Arena_copyStringN(oSymTable->oArena, pcKey, uLength);
+   else
+      pcKeyCopy = malloc(uLength + 1);
+   if (pcKeyCopy == NULL)
+      return 0;
+   memcpy(pcKeyCopy, pcKey, uLength);
+   pcKeyCopy[uLength] = '\0';
+   psSlot->pcKey = pcKeyCopy;
+   psSlot->uLength = uLength;
+   return 1;
+}
+
+/* Takes in SymTable_T oSymTable and struct Slot *psSlot, whose key
+was set by SymTable_copyKey, and frees that key, inline keys need
+nothing, arena keys are only released with the arena and interned
+keys are released to the pool. Returns nothing*/
+static void SymTable_freeKey(SymTable_T oSymTable, struct Slot *psSlot)
+{
+   if (oSymTable->oIntern != NULL)
+      Intern_release(oSymTable->oIntern, psSlot->pcKey);
+   else if (oSymTable->oArena == NULL
+      && psSlot->pcKey != psSlot->acKey)
+      free((void *)psSlot->pcKey);
+}
+
+/* Takes in struct Slot *psSlot, a full slot, and the key const char
+*pcKey of size_t uLength characters whose hash is uHash and returns
+1 if psSlot holds that key, 0 otherwise. An interned key passed in
+is the very pointer stored*/
+static int SymTable_matches(struct Slot *psSlot, const char *pcKey,
+    size_t uLength, size_t uHash)
+{
+    return psSlot->uHash == uHash && psSlot->uLength == uLength
+        && (psSlot->pcKey == pcKey
+            || memcmp(psSlot->pcKey, pcKey, uLength) == 0);
+}
+
+/* Looks up the key pcKey of uLength characters whose hash is
+uHash and returns the index of its slot, or SlotCount if pcKey is
+not in oSymTable*/
+static size_t SymTable_find(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, size_t uHash)
+{
+    size_t uMask = oSymTable->SlotCount - 1;
+    size_t i = SymTable_start(uHash, oSymTable->SlotCount);
+    unsigned char tag = SymTable_tag(uHash);
+    unsigned int uEmpty;
+    unsigned int uMatch;
+    size_t j;
+
+    /* Walks the probe sequence a window at a time until an empty
+    slot, only comparing keys whose tag and full hash both
+    match*/
+    for (;;){
+        STATS_ADD_ATOMIC(oSymTable, ulProbes, 1);
+        uEmpty = SymTable_matchByte(&oSymTable->ctrl[i], CTRL_EMPTY);
+        for (uMatch = SymTable_matchByte(&oSymTable->ctrl[i], tag)
+                & SymTable_beforeEmpty(uEmpty);
+             uMatch != 0; uMatch &= uMatch - 1){
+            j = (i + SymTable_lowestBit(uMatch)) & uMask;
+            if (SymTable_matches(&oSymTable->slots[j], pcKey, uLength,
+                    uHash))
+                return j;
+        }
+        if (uEmpty != 0)
+            return oSymTable->SlotCount;
+        i = (i + GROUP_WIDTH) & uMask;
+    }
+}
+
+/* Resize is a helper function that takes in SymTable_T
+oSymTable and rebuilds its slot arrays with uSlotCount slots,
+moving every binding with its cached hash and dropping all
+deleted markers. Returns 1 on success, 0 if there is not
+enough memory in which case oSymTable is unchanged*/
+static int SymTable_Resize(SymTable_T oSymTable, size_t uSlotCount)
+{
+    unsigned char *ctrlOld = oSymTable->ctrl;
+    struct Slot *slotsOld = oSymTable->slots;
+    size_t uSlotCountOld = oSymTable->SlotCount;
+    size_t uMask = uSlotCount - 1;
+    unsigned int uEmpty;
+    size_t i;
+    size_t j;
+    clock_t iStart = STATS_CLOCK();
+
+    if (!SymTable_allocSlots(oSymTable, uSlotCount))
+        return 0;
+
+    /* Every key is known to be unique so each one simply
+    goes into the first empty slot of its probe sequence*/
+    for (i = 0; i < uSlotCountOld; i++){
+        if (ctrlOld[i] & CTRL_EMPTY)
+            continue;
+        j = SymTable_start(slotsOld[i].uHash, uSlotCount);
+        while ((uEmpty = SymTable_matchByte(&oSymTable->ctrl[j],
+                CTRL_EMPTY)) == 0)
+            j = (j + GROUP_WIDTH) & uMask;
+        j = (j + SymTable_lowestBit(uEmpty)) & uMask;
+        SymTable_setCtrl(oSymTable, j, ctrlOld[i]);
+        oSymTable->slots[j] = slotsOld[i];
+        if (slotsOld[i].pcKey == slotsOld[i].acKey)
+            oSymTable->slots[j].pcKey = oSymTable->slots[j].acKey;
+    }
+
+    free(ctrlOld);
+    free(slotsOld);
+    STATS_ADD(oSymTable, ulResizes, 1);
+    STATS_ADD(oSymTable, dResizeSeconds, STATS_SECONDS(iStart));
+    return 1;
+}
+
+SymTable_T SymTable_new(void)
+{
+   SymTable_T oSymTable;
+   oSymTable = malloc(sizeof(struct SymTable));
+   if (oSymTable == NULL)
+      return NULL;
+
+   oSymTable->length = 0;
+   oSymTable->oArena = NULL;
+   oSymTable->oIntern = NULL;
+   oSymTable->pfHash = StrHash_hash;
+   oSymTable->SlotCountMin = INITIAL_SLOT_COUNT;
+   if (!SymTable_allocSlots(oSymTable, INITIAL_SLOT_COUNT)){
+      free(oSymTable);
+      return NULL;
+   }
+#ifdef SYMTABLE_STATS
+   memset(&oSymTable->sStats, 0, sizeof(struct SymTableStats));
+#endif
+   return oSymTable;
+}
+
+SymTable_T SymTable_newWithArena(size_t uHint)
+{
+   SymTable_T oSymTable;
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+      return NULL;
+
+   oSymTable->oArena = Arena_new(0, uHint);
+   if (oSymTable->oArena == NULL){
+      SymTable_free(oSymTable);
+      return NULL;
+   }
+   return oSymTable;
+}
+
+SymTable_T SymTable_newWithCapacity(size_t uExpected)
+{
+   SymTable_T oSymTable;
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+      return NULL;
+
+   if (!SymTable_reserve(oSymTable, uExpected)){
+      SymTable_free(oSymTable);
+      return NULL;
+   }
+   return oSymTable;
+}
+
+SymTable_T SymTable_newWithHash(
+    size_t (*pfHash)(const char *pcKey, size_t uLength))
+{
+   SymTable_T oSymTable;
+   assert(pfHash != NULL);
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+      return NULL;
+   oSymTable->pfHash = pfHash;
+   return oSymTable;
+}
+
+SymTable_T SymTable_newWithIntern(Intern_T oIntern)
+{
+   SymTable_T oSymTable;
+   assert(oIntern != NULL);
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+      return NULL;
+   oSymTable->oIntern = oIntern;
+   return oSymTable;
+}
+
+void SymTable_free(SymTable_T oSymTable)
+{
+   size_t i;
+   assert(oSymTable != NULL);
+
+   /* Frees the key of every full slot, or all of them at once
+   with the arena, and then the arrays*/
+   if (oSymTable->oArena != NULL)
+      Arena_free(oSymTable->oArena);
+   else
+      for (i = 0; i < oSymTable->SlotCount; i++)
+         if (!(oSymTable->ctrl[i] & CTRL_EMPTY))
+            SymTable_freeKey(oSymTable, &oSymTable->slots[i]);
+   free(oSymTable->ctrl);
+   free(oSymTable->slots);
+   free(oSymTable);
+}
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+    return oSymTable->length;
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    return SymTable_containsN(oSymTable, pcKey, strlen(pcKey));
+}
+
+int SymTable_containsN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    STATS_ADD_ATOMIC(oSymTable, ulContains, 1);
+    return SymTable_find(oSymTable, pcKey, uLength,
+        SymTable_hash(oSymTable, pcKey, uLength)) != oSymTable->SlotCount;
+}
+
+/* Takes in SymTable_T oSymTable, the key const char *pcKey of
+size_t uLength characters, its size_t uHash and const void
+*pvValue and probes for pcKey once:
+if it is present
+the existing value is stored in *ppvValue and 0 is returned,
+otherwise the pair goes into the first reusable slot seen by that
+same probe, pvValue is stored in *ppvValue and 1 is returned.
+Returns -1 if there is not enough memory*/
+static int SymTable_insert(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength, size_t uHash, const void *pvValue, void **ppvValue)
+{
+    size_t uMask;
+    size_t uSlotCount;
+    size_t i;
+    size_t j;
+    size_t iInsert;
+    unsigned char tag;
+    unsigned int uEmpty;
+    unsigned int uMatch;
+    unsigned int uFree;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    assert(ppvValue != NULL);
+
+    STATS_ADD(oSymTable, ulPuts, 1);
+    /* Grows (or just clears out deleted markers) before the
+    insert would push the table past its maximum load*/
+    if ((oSymTable->length + oSymTable->uDeleted + 1) * MAX_LOAD_DEN
+        > oSymTable->SlotCount * MAX_LOAD_NUM){
+        uSlotCount = oSymTable->SlotCount;
+        if ((oSymTable->length + 1) * 2 * MAX_LOAD_DEN
+            > uSlotCount * MAX_LOAD_NUM)
+            uSlotCount *= 2;
+        if (!SymTable_Resize(oSymTable, uSlotCount))
+            return -1;
+    }
+
+    /* One probe both rejects a duplicate key and remembers
+    the first reusable slot on the way*/
+    tag = SymTable_tag(uHash);
+    uMask = oSymTable->SlotCount - 1;
+    iInsert = oSymTable->SlotCount;
+    for (i = SymTable_start(uHash, oSymTable->SlotCount); ;
+         i = (i + GROUP_WIDTH) & uMask){
+        STATS_ADD_ATOMIC(oSymTable, ulProbes, 1);
+        uEmpty = SymTable_matchByte(&oSymTable->ctrl[i], CTRL_EMPTY);
+        for (uMatch = SymTable_matchByte(&oSymTable->ctrl[i], tag)
+                & SymTable_beforeEmpty(uEmpty);
+             uMatch != 0; uMatch &= uMatch - 1){
+            j = (i + SymTable_lowestBit(uMatch)) & uMask;
+            if (SymTable_matches(&oSymTable->slots[j], pcKey, uLength,
+                    uHash)){
+                *ppvValue = oSymTable->slots[j].pvValue;
+                return 0;
+            }
+        }
+
+        /* The first free slot comes no later than the first empty
+        one, which ends the probe*/
+        uFree = SymTable_matchFree(&oSymTable->ctrl[i]);
+        if (iInsert == oSymTable->SlotCount && uFree != 0)
+            iInsert = (i + SymTable_lowestBit(uFree)) & uMask;
+        if (uEmpty != 0)
+            break;
+    }
+
+    if (!SymTable_copyKey(oSymTable, &oSymTable->slots[iInsert], pcKey,
+            uLength))
+        return -1;
+
+    if (oSymTable->ctrl[iInsert] == CTRL_DELETED)
+        oSymTable->uDeleted--;
+    SymTable_setCtrl(oSymTable, iInsert, tag);
+    oSymTable->slots[iInsert].pvValue = (void *)pvValue;
+    oSymTable->slots[iInsert].uHash = uHash;
+    oSymTable->length++;
+    *ppvValue = (void *)pvValue;
+    return 1;
+}
+
+int SymTable_put(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    return SymTable_putN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+int SymTable_putN(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, const void *pvValue)
+{
+    void *pvFound;
+    assert(oSymTable != NULL);
+    return SymTable_insert(oSymTable, pcKey, uLength,
+            SymTable_hash(oSymTable, pcKey, uLength), pvValue,
+            &pvFound) == 1;
+}
+
+int SymTable_putOrGet(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue, void **ppvValue)
+{
+    void *pvFound;
+    size_t uLength;
+    int iResult;
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uLength = strlen(pcKey);
+    iResult = SymTable_insert(oSymTable, pcKey, uLength,
+            SymTable_hash(oSymTable, pcKey, uLength), pvValue, &pvFound);
+    if (iResult != -1 && ppvValue != NULL)
+        *ppvValue = pvFound;
+    return iResult;
+}
+
+void *SymTable_replace(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    return SymTable_replaceN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+void *SymTable_replaceN(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, const void *pvValue)
+{
+    size_t i;
+    void *OldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    STATS_ADD(oSymTable, ulReplaces, 1);
+    i = SymTable_find(oSymTable, pcKey, uLength,
+        SymTable_hash(oSymTable, pcKey, uLength));
+    if (i == oSymTable->SlotCount)
+        return NULL;
+    OldValue = oSymTable->slots[i].pvValue;
+    oSymTable->slots[i].pvValue = (void *)pvValue;
+    return OldValue;
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    return SymTable_getN(oSymTable, pcKey, strlen(pcKey));
+}
+
+void *SymTable_getN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength)
+{
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    STATS_ADD_ATOMIC(oSymTable, ulGets, 1);
+    i = SymTable_find(oSymTable, pcKey, uLength,
+        SymTable_hash(oSymTable, pcKey, uLength));
+    if (i == oSymTable->SlotCount)
+        return NULL;
+    return oSymTable->slots[i].pvValue;
+}
+
+/* Takes in SymTable_T oSymTable and the size_t i of a full slot,
+empties the slot and returns the value of its binding. Moves no
+other slot and never resizes*/
+static void *SymTable_clearSlot(SymTable_T oSymTable, size_t i)
+{
+    void *value;
+
+    value = oSymTable->slots[i].pvValue;
+    SymTable_freeKey(oSymTable, &oSymTable->slots[i]);
+
+    /* A slot followed by an empty one ends no other probe
+    sequence, so it can go straight back to empty instead of
+    leaving a deleted marker behind*/
+    if (oSymTable->ctrl[(i + 1) & (oSymTable->SlotCount - 1)]
+        == CTRL_EMPTY)
+        SymTable_setCtrl(oSymTable, i, CTRL_EMPTY);
+    else {
+        SymTable_setCtrl(oSymTable, i, CTRL_DELETED);
+        oSymTable->uDeleted++;
+    }
+    oSymTable->length--;
+    return value;
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    return SymTable_removeN(oSymTable, pcKey, strlen(pcKey));
+}
+
+void *SymTable_removeN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength)
+{
+    size_t i;
+    void *value;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    STATS_ADD(oSymTable, ulRemoves, 1);
+    i = SymTable_find(oSymTable, pcKey, uLength,
+        SymTable_hash(oSymTable, pcKey, uLength));
+    if (i == oSymTable->SlotCount)
+        return NULL;
+    value = SymTable_clearSlot(oSymTable, i);
+
+    /* A failed shrink leaves the table as it was, still valid*/
+    if (oSymTable->SlotCount > oSymTable->SlotCountMin &&
+        oSymTable->length * MIN_LOAD_DEN
+        < oSymTable->SlotCount * MIN_LOAD_NUM)
+        (void)SymTable_Resize(oSymTable, oSymTable->SlotCount / 2);
+    return value;
+}
+
+void SymTable_getBatch(SymTable_T oSymTable, const char **ppcKeys,
+    size_t uCount, void **ppvValues)
+{
+    size_t auHash[BATCH_SIZE];
+    size_t auLength[BATCH_SIZE];
+    unsigned int uMatch;
+    size_t uDone;
+    size_t uBatch;
+    size_t uStart;
+    size_t i;
+    size_t j;
+
+    assert(oSymTable != NULL);
+    assert(ppcKeys != NULL || uCount == 0);
+    assert(ppvValues != NULL || uCount == 0);
+
+    STATS_ADD_ATOMIC(oSymTable, ulGets, uCount);
+    for (uDone = 0; uDone < uCount; uDone += uBatch){
+        uBatch = uCount - uDone;
+        if (uBatch > BATCH_SIZE)
+            uBatch = BATCH_SIZE;
+
+        for (j = 0; j < uBatch; j++){
+            auLength[j] = strlen(ppcKeys[uDone + j]);
+            auHash[j] = SymTable_hash(oSymTable, ppcKeys[uDone + j],
+                auLength[j]);
+            uStart = SymTable_start(auHash[j], oSymTable->SlotCount);
+            PREFETCH(&oSymTable->ctrl[uStart]);
+            PREFETCH(&oSymTable->slots[uStart]);
+        }
+
+        /* Starts loading the key of the first slot of every
+        window whose tag matches, the one miss left before the key
+        compare*/
+        for (j = 0; j < uBatch; j++){
+            uStart = SymTable_start(auHash[j], oSymTable->SlotCount);
+            uMatch = SymTable_matchByte(&oSymTable->ctrl[uStart],
+                SymTable_tag(auHash[j]));
+            if (uMatch != 0)
+                PREFETCH(oSymTable->slots[(uStart
+                    + SymTable_lowestBit(uMatch))
+                    & (oSymTable->SlotCount - 1)].pcKey);
+        }
+        for (j = 0; j < uBatch; j++){
+            i = SymTable_find(oSymTable, ppcKeys[uDone + j],
+                auLength[j], auHash[j]);
+            ppvValues[uDone + j] = (i == oSymTable->SlotCount) ?
+                NULL : oSymTable->slots[i].pvValue;
+        }
+    }
+}
+
+size_t SymTable_putBatch(SymTable_T oSymTable, const char **ppcKeys,
+    void **ppvValues, size_t uCount)
+{
+    size_t auHash[BATCH_SIZE];
+    size_t auLength[BATCH_SIZE];
+    void *pvFound;
+    size_t uInserted = 0;
+    size_t uDone;
+    size_t uBatch;
+    size_t uStart;
+    size_t j;
+
+    assert(oSymTable != NULL);
+    assert(ppcKeys != NULL || uCount == 0);
+    assert(ppvValues != NULL || uCount == 0);
+
+    for (uDone = 0; uDone < uCount; uDone += uBatch){
+        uBatch = uCount - uDone;
+        if (uBatch > BATCH_SIZE)
+            uBatch = BATCH_SIZE;
+
+        for (j = 0; j < uBatch; j++){
+            auLength[j] = strlen(ppcKeys[uDone + j]);
+            auHash[j] = SymTable_hash(oSymTable, ppcKeys[uDone + j],
+                auLength[j]);
+            uStart = SymTable_start(auHash[j], oSymTable->SlotCount);
+            PREFETCH(&oSymTable->ctrl[uStart]);
+            PREFETCH(&oSymTable->slots[uStart]);
+        }
+        for (j = 0; j < uBatch; j++)
+            if (SymTable_insert(oSymTable, ppcKeys[uDone + j],
+                    auLength[j], auHash[j], ppvValues[uDone + j],
+                    &pvFound) == 1)
+                uInserted++;
+    }
+    return uInserted;
+}
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCount)
+{
+    size_t uSlotCount = INITIAL_SLOT_COUNT;
+
+    assert(oSymTable != NULL);
+
+    /* The fewest slots that take uCount bindings without the
+    insert of the last one growing the table*/
+    if (uCount > (size_t)-1 / MAX_LOAD_DEN)
+        return 0;
+    while (uCount * MAX_LOAD_DEN > uSlotCount * MAX_LOAD_NUM){
+        if (uSlotCount > (size_t)-1 / sizeof(struct Slot) / 2)
+            return 0;
+        uSlotCount *= 2;
+    }
+    if (uSlotCount > oSymTable->SlotCount &&
+        !SymTable_Resize(oSymTable, uSlotCount))
+        return 0;
+    if (uSlotCount > oSymTable->SlotCountMin)
+        oSymTable->SlotCountMin = uSlotCount;
+    return 1;
+}
+
+void SymTable_setReorder(SymTable_T oSymTable,
+    enum SymTableReorder eReorder)
+{
+   /* Probing visits slots where the keys hashed, a binding cannot
+   be moved closer to the start of its run without breaking it*/
+   assert(oSymTable != NULL);
+   (void)oSymTable;
+   (void)eReorder;
+}
+
+int SymTable_setFilter(SymTable_T oSymTable, int iEnabled)
+{
+   /* A miss already ends at the first window holding an empty
+   slot, after comparing 16 control bytes at once, which is about
+   what the filter would cost*/
+   assert(oSymTable != NULL);
+   (void)oSymTable;
+   (void)iEnabled;
+   return 1;
+}
+
+void SymTable_compact(SymTable_T oSymTable)
+{
+    size_t uSlotCount = INITIAL_SLOT_COUNT;
+
+    assert(oSymTable != NULL);
+    oSymTable->SlotCountMin = INITIAL_SLOT_COUNT;
+
+    /* The fewest slots that still leave room for one more insert
+    without growing, rebuilt even at the same size when there are
+    deleted markers to drop*/
+    while ((oSymTable->length + 1) * MAX_LOAD_DEN
+        > uSlotCount * MAX_LOAD_NUM)
+        uSlotCount *= 2;
+    if (uSlotCount < oSymTable->SlotCount || oSymTable->uDeleted > 0)
+        (void)SymTable_Resize(oSymTable, uSlotCount);
+}
+
+void SymTable_getStats(SymTable_T oSymTable,
+    struct SymTableStats *psStats)
+{
+    size_t uMask;
+    size_t uChain;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(psStats != NULL);
+
+#ifdef SYMTABLE_STATS
+    *psStats = oSymTable->sStats;
+#else
+    memset(psStats, 0, sizeof(struct SymTableStats));
+#endif
+    psStats->uLength = oSymTable->length;
+    psStats->uBucketCount = oSymTable->SlotCount;
+    psStats->dLoadFactor =
+        (double)oSymTable->length / (double)oSymTable->SlotCount;
+    psStats->uLongestChain = 0;
+    memset(psStats->auChainLengths, 0, sizeof(psStats->auChainLengths));
+    psStats->uKeyBytes = 0;
+
+    /* The chain of a binding is the run of slots from the start of
+    its probe sequence to its own slot*/
+    uMask = oSymTable->SlotCount - 1;
+    for (i = 0; i < oSymTable->SlotCount; i++){
+        if (oSymTable->ctrl[i] & CTRL_EMPTY)
+            continue;
+        uChain = ((i - SymTable_start(oSymTable->slots[i].uHash,
+            oSymTable->SlotCount)) & uMask) + 1;
+        if (uChain > psStats->uLongestChain)
+            psStats->uLongestChain = uChain;
+        if (uChain >= SYMTABLE_STATS_CHAIN_LENGTHS)
+            uChain = SYMTABLE_STATS_CHAIN_LENGTHS - 1;
+        psStats->auChainLengths[uChain]++;
+        psStats->uKeyBytes += oSymTable->slots[i].uLength + 1;
+    }
+    psStats->uBindingBytes =
+        oSymTable->SlotCount * (sizeof(struct Slot) + 1)
+        + GROUP_WIDTH - 1;
+}
+
+void SymTable_map(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    /* Applies the function to each full slot*/
+    for (i = 0; i < oSymTable->SlotCount; i++)
+        if (!(oSymTable->ctrl[i] & CTRL_EMPTY))
+            (*pfApply)(oSymTable->slots[i].pcKey,
+                oSymTable->slots[i].pvValue, (void *)pvExtra);
+}
+
+/* Takes in size_t uStart, size_t uEnd and the struct MapTask
+*pvTask and applies its function to the full slots among slots
+uStart to uEnd - 1. Returns nothing*/
+static void SymTable_mapTask(size_t uStart, size_t uEnd, void *pvTask)
+{
+    struct MapTask *psTask = pvTask;
+    SymTable_T oSymTable = psTask->oSymTable;
+    size_t i;
+
+    for (i = uStart; i < uEnd; i++)
+        if (!(oSymTable->ctrl[i] & CTRL_EMPTY))
+            (*psTask->pfApply)(oSymTable->slots[i].pcKey,
+                oSymTable->slots[i].pvValue, psTask->pvExtra);
+}
+
+void SymTable_mapParallel(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra, int iThreads)
+{
+    struct MapTask sTask;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    sTask.oSymTable = oSymTable;
+    sTask.pfApply = pfApply;
+    sTask.pvExtra = (void *)pvExtra;
+    Parallel_run(oSymTable->SlotCount, MAP_GRAIN, iThreads,
+        SymTable_mapTask, &sTask);
+}
+
+SymTableIter_T SymTable_iterBegin(SymTable_T oSymTable)
+{
+    SymTableIter_T oIter;
+
+    assert(oSymTable != NULL);
+
+    oIter = malloc(sizeof(struct SymTableIter));
+    if (oIter == NULL)
+        return NULL;
+    oIter->oSymTable = oSymTable;
+    oIter->uCurrent = oSymTable->SlotCount;
+    oIter->uNext = 0;
+    return oIter;
+}
+
+int SymTable_iterNext(SymTableIter_T oIter, const char **ppcKey,
+    void **ppvValue)
+{
+    SymTable_T oSymTable;
+    size_t i;
+
+    assert(oIter != NULL);
+
+    /* The control bytes alone tell the full slots apart*/
+    oSymTable = oIter->oSymTable;
+    for (i = oIter->uNext; i < oSymTable->SlotCount; i++)
+        if (!(oSymTable->ctrl[i] & CTRL_EMPTY))
+            break;
+    oIter->uCurrent = i;
+    if (i == oSymTable->SlotCount)
+    {
+        oIter->uNext = i;
+        return 0;
+    }
+    oIter->uNext = i + 1;
+    if (ppcKey != NULL)
+        *ppcKey = oSymTable->slots[i].pcKey;
+    if (ppvValue != NULL)
+        *ppvValue = oSymTable->slots[i].pvValue;
+    return 1;
+}
+
+void *SymTable_iterRemove(SymTableIter_T oIter)
+{
+    SymTable_T oSymTable;
+    void *value;
+
+    assert(oIter != NULL);
+
+    oSymTable = oIter->oSymTable;
+    if (oIter->uCurrent == oSymTable->SlotCount)
+        return NULL;
+
+    /* Shrinking would move the slots not visited yet, so the
+    table keeps its size until the next SymTable_remove or
+    SymTable_compact*/
+    STATS_ADD(oSymTable, ulRemoves, 1);
+    value = SymTable_clearSlot(oSymTable, oIter->uCurrent);
+    oIter->uCurrent = oSymTable->SlotCount;
+    return value;
+}
+
+void SymTable_iterEnd(SymTableIter_T oIter)
+{
+    assert(oIter != NULL);
+    free(oIter);
+}
@@ -0,0 +1,1480 @@
+/* Symbol table B-tree implementation, which keeps the bindings
+sorted by key so they can be visited in order, by range or by
+prefix*/
+#include <assert.h>
+#include <limits.h>
+#include <stdlib.h>
+#include "symtableordered.h"
+#include "arena.h"
+#include "parallel.h"
+#include "symtablestats.h"
+#include <string.h>
+
+/* Every node but the root holds MIN_KEYS to MAX_KEYS bindings. A
+node is split in two once full and merged with a sibling once it
+would fall below half full, so the tree stays at most about
+log_16(n) nodes deep and every node at least half used*/
+enum {MIN_KEYS = 15, MAX_KEYS = 2 * MIN_KEYS + 1};
+
+/* The most levels an iterator keeps track of. Every node below
+the root has at least MIN_KEYS + 1 children, so a deeper tree
+would need more than 16^18 bindings*/
+enum {MAX_DEPTH = 20};
+
+/* SymTable_mapParallel goes down the tree until a level has this
+many nodes per thread, or it reaches the leaves, and hands out
+their subtrees one at a time*/
+enum {SUBTREES_PER_THREAD = 8};
+
+/* A binding, stored in the node that holds it*/
+struct Binding
+{
+   /* Key, a copy owned by the table*/
+   const char *pcKey;
+
+   /* Value*/
+   void *pvValue;
+
+   /* The number of characters of the key*/
+   size_t uLength;
+};
+
+/* A node of the B-tree. Bindings move between nodes as they split
+and merge, so unlike the other implementations no key is stored
+inline: pcKey would have to follow every move*/
+struct Node
+{
+   /* The number of bindings in the node*/
+   size_t uCount;
+
+   /* 1 if the node is a leaf, which has no children*/
+   int iLeaf;
+
+   /* aulPrefixes[i] holds the first characters of the key of
+   asBindings[i] packed so that comparing them as integers orders
+   them like memcmp. A search through the node reads this array
+   and follows a key pointer only on a tie*/
+   unsigned long aulPrefixes[MAX_KEYS];
+
+   /* The bindings, in increasing order of key*/
+   struct Binding asBindings[MAX_KEYS];
+
+   /* apsChildren[i] holds the keys between asBindings[i - 1] and
+   asBindings[i], unused in a leaf*/
+   struct Node *apsChildren[MAX_KEYS + 1];
+};
+
+/* SymTable is the root of the B-tree*/
+struct SymTable
+{
+   /* The number of bindings*/
+   size_t length;
+
+   /* The root node, NULL or an empty leaf when there are no
+   bindings*/
+   struct Node *psRoot;
+
+   /* The number of nodes in the tree*/
+   size_t uNodeCount;
+
+   /* The number of nodes given back to, or reserved in, the arena
+   or the pool and not handed out again*/
+   size_t uSpareNodes;
+
+   /* Arena the nodes and keys are allocated from, NULL when each
+   one is malloc'd and freed on its own*/
+   Arena_T oArena;
+
+   /* The pool every key is interned in, NULL when the table
+   copies its own keys*/
+   Intern_T oIntern;
+
+   /* Without an arena, the pool SymTable_reserve preallocates
+   nodes in, NULL until it is first called and again after
+   SymTable_compact. Keys are still malloc'd one by one*/
+   Arena_T oPool;
+
+#ifdef SYMTABLE_STATS
+   /* The counters reported by SymTable_getStats*/
+   struct SymTableStats sStats;
+#endif
+};
+
+/* A key being looked up, with its prefix computed once*/
+struct Key
+{
+   /* The characters of the key*/
+   const char *pcKey;
+
+   /* The number of characters of the key*/
+   size_t uLength;
+
+   /* Its first characters as packed by SymTable_prefix*/
+   unsigned long ulPrefix;
+};
+
+/* The bindings a range scan visits and what it applies to them*/
+struct Range
+{
+   /* The scan starts at the first key not before sLow, or at the
+   first key if iHasLow is 0*/
+   struct Key sLow;
+   int iHasLow;
+
+   /* The scan stops at the first key not before sHigh or, if
+   iPrefix is 1, at the first key not starting with the
+   characters of sHigh. It runs to the end if iHasHigh is 0*/
+   struct Key sHigh;
+   int iHasHigh;
+   int iPrefix;
+
+   /* The function applied to each binding and its extra
+   parameter*/
+   void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra);
+   void *pvExtra;
+};
+
+/* What every thread of SymTable_mapParallel is given*/
+struct MapTask
+{
+   /* The table mapped*/
+   SymTable_T oSymTable;
+
+   /* The nodes handed out. The first uUpper of them are above the
+   level the tree was split at and only their own bindings are
+   theirs to map, the others are mapped with their whole subtree*/
+   struct Node **apsNodes;
+   size_t uUpper;
+
+   /* The whole range of keys, with the function applied to each
+   binding*/
+   struct Range sRange;
+};
+
+/* A cursor over the bindings in order, the path from the root to
+the next binding to visit*/
+struct SymTableIter
+{
+   /* The table walked*/
+   SymTable_T oSymTable;
+
+   /* The nodes of the path, the first uDepth of them, with the
+   index in each of the next binding to visit there, visited once
+   the subtrees further down the path are done*/
+   struct Node *apsPath[MAX_DEPTH];
+   size_t auIndex[MAX_DEPTH];
+   size_t uDepth;
+
+   /* The binding the cursor is at, NULL before the first one and
+   after it was removed*/
+   struct Binding *psCurrent;
+};
+
+/* Takes in the key const char *pcKey of size_t uLength characters
+and returns its first characters packed into an unsigned long, the
+first one highest. Missing characters count as 0, which sorts
+before every character a key can hold*/
+static unsigned long SymTable_prefix(const char *pcKey, size_t uLength)
+{
+   unsigned long ulPrefix = 0;
+   size_t i;
+
+   for (i = 0; i < sizeof(unsigned long); i++){
+      ulPrefix <<= CHAR_BIT;
+      if (i < uLength)
+         ulPrefix |= (unsigned char)pcKey[i];
+   }
+   return ulPrefix;
+}
+
+/* Takes in struct Key *psKey and the key const char *pcKey of
+size_t uLength characters and fills *psKey to look it up. Returns
+nothing*/
+static void SymTable_makeKey(struct Key *psKey, const char *pcKey,
+    size_t uLength)
+{
+   assert(pcKey != NULL);
+   psKey->pcKey = pcKey;
+   psKey->uLength = uLength;
+   psKey->ulPrefix = SymTable_prefix(pcKey, uLength);
+}
+
+/* Takes in the keys const char *pcKey1 of size_t uLength1 and
+const char *pcKey2 of size_t uLength2 characters and returns an
+int less than, equal to or greater than 0 as the first sorts
+before, the same as or after the second, as strcmp would*/
+static int SymTable_compare(const char *pcKey1, size_t uLength1,
+    const char *pcKey2, size_t uLength2)
+{
+   int iResult;
+
+   iResult = memcmp(pcKey1, pcKey2,
+      uLength1 < uLength2 ? uLength1 : uLength2);
+   if (iResult != 0 || uLength1 == uLength2)
+      return iResult;
+   return uLength1 < uLength2 ? -1 : 1;
+}
+
+/* Takes in struct Node *psNode, size_t i and const struct Key
+*psKey and compares binding i of psNode with *psKey like
+SymTable_compare, by prefix first. An interned key passed in is
+the very pointer stored, equal only if it is as long as well*/
+static int SymTable_compareAt(struct Node *psNode, size_t i,
+    const struct Key *psKey)
+{
+   struct Binding *psBinding = &psNode->asBindings[i];
+
+   if (psNode->aulPrefixes[i] != psKey->ulPrefix)
+      return psNode->aulPrefixes[i] < psKey->ulPrefix ? -1 : 1;
+   if (psBinding->pcKey == psKey->pcKey
+         && psBinding->uLength == psKey->uLength)
+      return 0;
+   return SymTable_compare(psBinding->pcKey, psBinding->uLength,
+      psKey->pcKey, psKey->uLength);
+}
+
+/* Takes in SymTable_T oSymTable, struct Node *psNode, const struct
+Key *psKey and int *piFound and binary searches psNode for
+*psKey. Returns the index of the first binding of psNode not
+before *psKey and sets *piFound to 1 if that binding holds *psKey,
+0 otherwise*/
+static size_t SymTable_search(SymTable_T oSymTable,
+    struct Node *psNode, const struct Key *psKey, int *piFound)
+{
+   size_t uLow = 0;
+   size_t uHigh = psNode->uCount;
+   size_t uMiddle;
+   int iCompare;
+
+   /* oSymTable is only used to count the comparisons*/
+   (void)oSymTable;
+   while (uLow < uHigh){
+      uMiddle = uLow + (uHigh - uLow) / 2;
+      STATS_ADD_ATOMIC(oSymTable, ulProbes, 1);
+      iCompare = SymTable_compareAt(psNode, uMiddle, psKey);
+      if (iCompare < 0)
+         uLow = uMiddle + 1;
+      else if (iCompare > 0)
+         uHigh = uMiddle;
+      else {
+         *piFound = 1;
+         return uMiddle;
+      }
+   }
+   *piFound = 0;
+   return uLow;
+}
+
+/* Takes in SymTable_T oSymTable and const struct Key *psKey and
+returns the binding holding *psKey, or NULL if there is none*/
+static struct Binding *SymTable_find(SymTable_T oSymTable,
+    const struct Key *psKey)
+{
+   struct Node *psNode;
+   size_t i;
+   int iFound;
+
+   for (psNode = oSymTable->psRoot; psNode != NULL;
+         psNode = psNode->apsChildren[i]){
+      i = SymTable_search(oSymTable, psNode, psKey, &iFound);
+      if (iFound)
+         return &psNode->asBindings[i];
+      if (psNode->iLeaf)
+         return NULL;
+   }
+   return NULL;
+}
+
+/* Takes in struct Node *psDest, size_t uDest, struct Node
+*psSource, size_t uSource and size_t uCount and moves uCount
+bindings, with their prefixes, from index uSource of psSource to
+index uDest of psDest. The ranges may overlap. Returns nothing*/
+static void SymTable_moveBindings(struct Node *psDest, size_t uDest,
+    struct Node *psSource, size_t uSource, size_t uCount)
+{
+   memmove(&psDest->asBindings[uDest], &psSource->asBindings[uSource],
+      uCount * sizeof(struct Binding));
+   memmove(&psDest->aulPrefixes[uDest], &psSource->aulPrefixes[uSource],
+      uCount * sizeof(unsigned long));
+}
+
+/* Takes in struct Node *psDest, size_t uDest, struct Node
+*psSource, size_t uSource and size_t uCount and moves uCount
+children from index uSource of psSource to index uDest of psDest.
+The ranges may overlap. Returns nothing*/
+static void SymTable_moveChildren(struct Node *psDest, size_t uDest,
+    struct Node *psSource, size_t uSource, size_t uCount)
+{
+   memmove(&psDest->apsChildren[uDest],
+      &psSource->apsChildren[uSource],
+      uCount * sizeof(struct Node *));
+}
+
+/* Takes in SymTable_T oSymTable and int iLeaf and returns a new
+empty node, a leaf if iLeaf is 1, taken from the arena or the pool
+of oSymTable if it has one, or NULL if there is not enough
+memory*/
+static struct Node *SymTable_newNode(SymTable_T oSymTable, int iLeaf)
+{
+   struct Node *psNode;
+
+   if (oSymTable->oArena != NULL)
+      psNode = (struct Node *) Arena_allocObject(oSymTable->oArena);
+   else if (oSymTable->oPool != NULL)
+      psNode = (struct Node *) Arena_allocObject(oSymTable->oPool);
+   else
+      psNode = (struct Node *) malloc(sizeof(struct Node));
+   if (psNode == NULL)
+      return NULL;
+
+   if (oSymTable->uSpareNodes > 0)
+      oSymTable->uSpareNodes--;
+   oSymTable->uNodeCount++;
+   psNode->uCount = 0;
+   psNode->iLeaf = iLeaf;
+   return psNode;
+}
+
+/* Takes in SymTable_T oSymTable and struct Node *psNode, no longer
+in the tree, and frees it or gives it back to the arena or the
+pool of oSymTable. Returns nothing*/
+static void SymTable_freeNode(SymTable_T oSymTable,
+    struct Node *psNode)
+{
+   oSymTable->uNodeCount--;
+   if (oSymTable->oArena != NULL || oSymTable->oPool != NULL){
+      Arena_freeObject(oSymTable->oArena != NULL ?
+         oSymTable->oArena : oSymTable->oPool, psNode);
+      oSymTable->uSpareNodes++;
+   }
+   else
+      free(psNode);
+}
+
+/* Takes in SymTable_T oSymTable and the key const char *pcKey of
+size_t uLength characters and returns a copy of it, taken from the
+arena of oSymTable if it has one, or the interned pcKey if
+oSymTable interns its keys. Returns NULL if there is not enough
+memory*/
+static char *SymTable_copyKey(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength)
+{
+   char *pcKeyCopy;
+
+   /* The pool's copy is never written through*/
+   if (oSymTable->oIntern != NULL)
+      return (char *) Intern_addN(oSymTable->oIntern, pcKey, uLength);
+   if (oSymTable->oArena != NULL)
+      return Arena_copyStringN(oSymTable->oArena, pcKey, uLength);
+   pcKeyCopy = (char *) malloc(uLength + 1);
+   if (pcKeyCopy == NULL)
+      return NULL;
+   memcpy(pcKeyCopy, pcKey, uLength);
+   pcKeyCopy[uLength] = '\0';
+   return pcKeyCopy;
+}
+
+/* Takes in SymTable_T oSymTable and struct Binding *psBinding and
+frees the key copy of psBinding, which an arena only releases with
+itself, or releases it to the pool it was interned in. Returns
+nothing*/
+static void SymTable_freeKey(SymTable_T oSymTable,
+    struct Binding *psBinding)
+{
+   if (oSymTable->oIntern != NULL)
+      Intern_release(oSymTable->oIntern, psBinding->pcKey);
+   else if (oSymTable->oArena == NULL)
+      free((void *)(psBinding->pcKey));
+}
+
+/* Takes in struct Node *psNode, the root of a subtree of nodes
+malloc'd one by one, and frees those nodes but not their keys.
+Returns nothing*/
+static void SymTable_freeNodes(struct Node *psNode)
+{
+   size_t i;
+
+   if (! psNode->iLeaf)
+      for (i = 0; i <= psNode->uCount; i++)
+         SymTable_freeNodes(psNode->apsChildren[i]);
+   free(psNode);
+}
+
+/* Takes in struct Node *psNode and Arena_T oTo and returns a copy
+of the subtree of psNode whose nodes are taken from oTo, or
+malloc'd one by one if oTo is NULL. The keys are shared, not
+copied. Returns NULL if there is not enough memory, having freed
+whatever nodes it took unless they came from oTo*/
+static struct Node *SymTable_copyNodes(struct Node *psNode,
+    Arena_T oTo)
+{
+   struct Node *psCopy;
+   size_t i;
+
+   if (oTo != NULL)
+      psCopy = (struct Node *) Arena_allocObject(oTo);
+   else
+      psCopy = (struct Node *) malloc(sizeof(struct Node));
+   if (psCopy == NULL)
+      return NULL;
+   *psCopy = *psNode;
+   if (psNode->iLeaf)
+      return psCopy;
+
+   for (i = 0; i <= psNode->uCount; i++){
+      psCopy->apsChildren[i] =
+         SymTable_copyNodes(psNode->apsChildren[i], oTo);
+      if (psCopy->apsChildren[i] == NULL){
+         if (oTo == NULL){
+            while (i > 0)
+               SymTable_freeNodes(psCopy->apsChildren[--i]);
+            free(psCopy);
+         }
+         return NULL;
+      }
+   }
+   return psCopy;
+}
+
+/* Takes in SymTable_T oSymTable, struct Node *psParent and size_t
+i, where child i of psParent is full and psParent is not, and
+splits that child in two around its middle binding, which moves up
+into psParent at index i. Returns 1, or 0 leaving the tree
+unchanged if there is not enough memory*/
+static int SymTable_splitChild(SymTable_T oSymTable,
+    struct Node *psParent, size_t i)
+{
+   struct Node *psChild = psParent->apsChildren[i];
+   struct Node *psRight;
+
+   assert(psChild->uCount == MAX_KEYS);
+   assert(psParent->uCount < MAX_KEYS);
+
+   psRight = SymTable_newNode(oSymTable, psChild->iLeaf);
+   if (psRight == NULL)
+      return 0;
+   SymTable_moveBindings(psRight, 0, psChild, MIN_KEYS + 1, MIN_KEYS);
+   if (! psChild->iLeaf)
+      SymTable_moveChildren(psRight, 0, psChild, MIN_KEYS + 1,
+         MIN_KEYS + 1);
+   psRight->uCount = MIN_KEYS;
+   psChild->uCount = MIN_KEYS;
+
+   SymTable_moveBindings(psParent, i + 1, psParent, i,
+      psParent->uCount - i);
+   SymTable_moveChildren(psParent, i + 2, psParent, i + 1,
+      psParent->uCount - i);
+   SymTable_moveBindings(psParent, i, psChild, MIN_KEYS, 1);
+   psParent->apsChildren[i + 1] = psRight;
+   psParent->uCount++;
+   return 1;
+}
+
+/* Takes in SymTable_T oSymTable, struct Node *psParent and size_t
+i, where children i and i + 1 of psParent hold MIN_KEYS bindings
+each, and merges child i + 1 and binding i of psParent into child
+i, freeing child i + 1. Returns nothing*/
+static void SymTable_mergeChildren(SymTable_T oSymTable,
+    struct Node *psParent, size_t i)
+{
+   struct Node *psLeft = psParent->apsChildren[i];
+   struct Node *psRight = psParent->apsChildren[i + 1];
+
+   SymTable_moveBindings(psLeft, psLeft->uCount, psParent, i, 1);
+   SymTable_moveBindings(psLeft, psLeft->uCount + 1, psRight, 0,
+      psRight->uCount);
+   if (! psLeft->iLeaf)
+      SymTable_moveChildren(psLeft, psLeft->uCount + 1, psRight, 0,
+         psRight->uCount + 1);
+   psLeft->uCount += psRight->uCount + 1;
+
+   SymTable_moveBindings(psParent, i, psParent, i + 1,
+      psParent->uCount - i - 1);
+   SymTable_moveChildren(psParent, i + 1, psParent, i + 2,
+      psParent->uCount - i - 1);
+   psParent->uCount--;
+   SymTable_freeNode(oSymTable, psRight);
+}
+
+/* Takes in SymTable_T oSymTable, struct Node *psParent and size_t
+i, where child i of psParent holds only MIN_KEYS bindings, and
+gives that child one more before a removal goes down into it:
+through psParent from a sibling that can spare one, or else by
+merging it with a sibling. Returns the index of the child that now
+holds the keys child i held*/
+static size_t SymTable_fillChild(SymTable_T oSymTable,
+    struct Node *psParent, size_t i)
+{
+   struct Node *psChild = psParent->apsChildren[i];
+   struct Node *psSibling;
+
+   if (i > 0 && psParent->apsChildren[i - 1]->uCount > MIN_KEYS){
+      /* The separating binding comes down in front of the child
+      and the last binding of the left sibling takes its place*/
+      psSibling = psParent->apsChildren[i - 1];
+      SymTable_moveBindings(psChild, 1, psChild, 0, psChild->uCount);
+      SymTable_moveBindings(psChild, 0, psParent, i - 1, 1);
+      SymTable_moveBindings(psParent, i - 1, psSibling,
+         psSibling->uCount - 1, 1);
+      if (! psChild->iLeaf){
+         SymTable_moveChildren(psChild, 1, psChild, 0,
+            psChild->uCount + 1);
+         psChild->apsChildren[0] =
+            psSibling->apsChildren[psSibling->uCount];
+      }
+      psSibling->uCount--;
+      psChild->uCount++;
+      return i;
+   }
+
+   if (i < psParent->uCount &&
+         psParent->apsChildren[i + 1]->uCount > MIN_KEYS){
+      /* The same from the right sibling*/
+      psSibling = psParent->apsChildren[i + 1];
+      SymTable_moveBindings(psChild, psChild->uCount, psParent, i, 1);
+      SymTable_moveBindings(psParent, i, psSibling, 0, 1);
+      SymTable_moveBindings(psSibling, 0, psSibling, 1,
+         psSibling->uCount - 1);
+      if (! psChild->iLeaf){
+         psChild->apsChildren[psChild->uCount + 1] =
+            psSibling->apsChildren[0];
+         SymTable_moveChildren(psSibling, 0, psSibling, 1,
+            psSibling->uCount);
+      }
+      psSibling->uCount--;
+      psChild->uCount++;
+      return i;
+   }
+
+   if (i == psParent->uCount)
+      i--;
+   SymTable_mergeChildren(oSymTable, psParent, i);
+   return i;
+}
+
+/* Takes in struct Node *psNode and struct Key *psKey and fills
+*psKey with the last key of the subtree of psNode. Returns
+nothing*/
+static void SymTable_lastKey(struct Node *psNode, struct Key *psKey)
+{
+   while (! psNode->iLeaf)
+      psNode = psNode->apsChildren[psNode->uCount];
+   psKey->pcKey = psNode->asBindings[psNode->uCount - 1].pcKey;
+   psKey->uLength = psNode->asBindings[psNode->uCount - 1].uLength;
+   psKey->ulPrefix = psNode->aulPrefixes[psNode->uCount - 1];
+}
+
+/* Takes in struct Node *psNode and struct Key *psKey and fills
+*psKey with the first key of the subtree of psNode. Returns
+nothing*/
+static void SymTable_firstKey(struct Node *psNode, struct Key *psKey)
+{
+   while (! psNode->iLeaf)
+      psNode = psNode->apsChildren[0];
+   psKey->pcKey = psNode->asBindings[0].pcKey;
+   psKey->uLength = psNode->asBindings[0].uLength;
+   psKey->ulPrefix = psNode->aulPrefixes[0];
+}
+
+/* Takes in SymTable_T oSymTable, struct Node *psNode, which holds
+more than MIN_KEYS bindings unless it is the root, const struct
+Key *psKey and struct Binding *psRemoved, and removes the binding
+of *psKey from the subtree of psNode in one pass down, filling
+every node it goes down into first so that none falls below
+MIN_KEYS. The binding is stored in *psRemoved, its key not freed.
+Returns 1, or 0 if *psKey is not there*/
+static int SymTable_extract(SymTable_T oSymTable, struct Node *psNode,
+    const struct Key *psKey, struct Binding *psRemoved)
+{
+   struct Key sReplacement;
+   size_t i;
+   int iFound;
+
+   for (;;){
+      i = SymTable_search(oSymTable, psNode, psKey, &iFound);
+      if (psNode->iLeaf){
+         if (! iFound)
+            return 0;
+         *psRemoved = psNode->asBindings[i];
+         SymTable_moveBindings(psNode, i, psNode, i + 1,
+            psNode->uCount - i - 1);
+         psNode->uCount--;
+         return 1;
+      }
+
+      if (iFound){
+         /* The binding is replaced by the one just before or just
+         after it, taken from a leaf, or else comes down into the
+         merge of the children around it*/
+         *psRemoved = psNode->asBindings[i];
+         if (psNode->apsChildren[i]->uCount > MIN_KEYS){
+            SymTable_lastKey(psNode->apsChildren[i], &sReplacement);
+            (void)SymTable_extract(oSymTable, psNode->apsChildren[i],
+               &sReplacement, &psNode->asBindings[i]);
+            psNode->aulPrefixes[i] = sReplacement.ulPrefix;
+            return 1;
+         }
+         if (psNode->apsChildren[i + 1]->uCount > MIN_KEYS){
+            SymTable_firstKey(psNode->apsChildren[i + 1],
+               &sReplacement);
+            (void)SymTable_extract(oSymTable,
+               psNode->apsChildren[i + 1], &sReplacement,
+               &psNode->asBindings[i]);
+            psNode->aulPrefixes[i] = sReplacement.ulPrefix;
+            return 1;
+         }
+         SymTable_mergeChildren(oSymTable, psNode, i);
+      }
+      else if (psNode->apsChildren[i]->uCount == MIN_KEYS)
+         i = SymTable_fillChild(oSymTable, psNode, i);
+      psNode = psNode->apsChildren[i];
+   }
+}
+
+/* Takes in SymTable_T oSymTable and struct Node *psNode and frees
+the subtree of psNode with its keys, leaving nodes from the pool to
+it. Returns nothing*/
+static void SymTable_freeSubtree(SymTable_T oSymTable,
+    struct Node *psNode)
+{
+   size_t i;
+
+   for (i = 0; i < psNode->uCount; i++)
+      SymTable_freeKey(oSymTable, &psNode->asBindings[i]);
+   if (! psNode->iLeaf)
+      for (i = 0; i <= psNode->uCount; i++)
+         SymTable_freeSubtree(oSymTable, psNode->apsChildren[i]);
+   if (oSymTable->oPool == NULL)
+      free(psNode);
+}
+
+/* Takes in const struct Binding *psBinding and const struct Range
+*psRange and returns 1 if the key of psBinding comes before the end
+of *psRange, 0 otherwise*/
+static int SymTable_beforeEnd(const struct Binding *psBinding,
+    const struct Range *psRange)
+{
+   const struct Key *psHigh = &psRange->sHigh;
+
+   if (! psRange->iHasHigh)
+      return 1;
+   if (psRange->iPrefix)
+      return psBinding->uLength >= psHigh->uLength &&
+         memcmp(psBinding->pcKey, psHigh->pcKey, psHigh->uLength) == 0;
+   return SymTable_compare(psBinding->pcKey, psBinding->uLength,
+      psHigh->pcKey, psHigh->uLength) < 0;
+}
+
+/* Takes in SymTable_T oSymTable, struct Node *psNode, const struct
+Range *psRange and int iCheckLow, and applies psRange->pfApply in
+order to the bindings of the subtree of psNode within *psRange.
+The start of the range is only searched for if iCheckLow is 1, the
+subtrees after it are known to be past it. Returns 0 once a key
+past the end of the range is reached, 1 otherwise*/
+static int SymTable_mapSubtree(SymTable_T oSymTable,
+    struct Node *psNode, const struct Range *psRange, int iCheckLow)
+{
+   struct Binding *psBinding;
+   size_t uStart = 0;
+   size_t i;
+   int iFound = 0;
+
+   if (iCheckLow)
+      uStart = SymTable_search(oSymTable, psNode, &psRange->sLow,
+         &iFound);
+   for (i = uStart; ; i++){
+      /* A child before a binding equal to the start is all before
+      the start*/
+      if (! psNode->iLeaf && ! (i == uStart && iFound) &&
+            ! SymTable_mapSubtree(oSymTable, psNode->apsChildren[i],
+               psRange, iCheckLow && i == uStart))
+         return 0;
+      if (i == psNode->uCount)
+         return 1;
+      psBinding = &psNode->asBindings[i];
+      if (! SymTable_beforeEnd(psBinding, psRange))
+         return 0;
+      (*psRange->pfApply)(psBinding->pcKey, psBinding->pvValue,
+         psRange->pvExtra);
+   }
+}
+
+/* Takes in SymTable_T oSymTable and struct Range *psRange and
+applies psRange->pfApply in order to every binding of oSymTable
+within *psRange. Returns nothing*/
+static void SymTable_mapWithin(SymTable_T oSymTable,
+    const struct Range *psRange)
+{
+   if (oSymTable->psRoot != NULL)
+      (void)SymTable_mapSubtree(oSymTable, oSymTable->psRoot, psRange,
+         psRange->iHasLow);
+}
+
+/* Takes in struct Node *psNode and struct SymTableStats *psStats
+and adds the nodes of the subtree of psNode and their keys to
+*psStats. Returns nothing*/
+static void SymTable_statsSubtree(struct Node *psNode,
+    struct SymTableStats *psStats)
+{
+   size_t uCount = psNode->uCount;
+   size_t i;
+
+   if (uCount > psStats->uLongestChain)
+      psStats->uLongestChain = uCount;
+   if (uCount >= SYMTABLE_STATS_CHAIN_LENGTHS)
+      uCount = SYMTABLE_STATS_CHAIN_LENGTHS - 1;
+   psStats->auChainLengths[uCount]++;
+   for (i = 0; i < psNode->uCount; i++)
+      psStats->uKeyBytes += psNode->asBindings[i].uLength + 1;
+   if (! psNode->iLeaf)
+      for (i = 0; i <= psNode->uCount; i++)
+         SymTable_statsSubtree(psNode->apsChildren[i], psStats);
+}
+
+SymTable_T SymTable_new(void)
+{
+   SymTable_T oSymTable;
+
+   oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+   if (oSymTable == NULL)
+      return NULL;
+
+   oSymTable->length = 0;
+   oSymTable->psRoot = NULL;
+   oSymTable->uNodeCount = 0;
+   oSymTable->uSpareNodes = 0;
+   oSymTable->oArena = NULL;
+   oSymTable->oIntern = NULL;
+   oSymTable->oPool = NULL;
+#ifdef SYMTABLE_STATS
+   memset(&oSymTable->sStats, 0, sizeof(struct SymTableStats));
+#endif
+   return oSymTable;
+}
+
+SymTable_T SymTable_newWithArena(size_t uHint)
+{
+   SymTable_T oSymTable;
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+      return NULL;
+
+   oSymTable->oArena =
+      Arena_new(sizeof(struct Node), uHint / MIN_KEYS + 1);
+   if (oSymTable->oArena == NULL){
+      free(oSymTable);
+      return NULL;
+   }
+   return oSymTable;
+}
+
+SymTable_T SymTable_newWithCapacity(size_t uExpected)
+{
+   SymTable_T oSymTable;
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+      return NULL;
+
+   if (! SymTable_reserve(oSymTable, uExpected)){
+      SymTable_free(oSymTable);
+      return NULL;
+   }
+   return oSymTable;
+}
+
+SymTable_T SymTable_newWithHash(
+    size_t (*pfHash)(const char *pcKey, size_t uLength))
+{
+   /* The B-tree compares keys and never hashes one so pfHash goes
+   unused*/
+   assert(pfHash != NULL);
+   (void)pfHash;
+   return SymTable_new();
+}
+
+SymTable_T SymTable_newWithIntern(Intern_T oIntern)
+{
+   SymTable_T oSymTable;
+   assert(oIntern != NULL);
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+      return NULL;
+   oSymTable->oIntern = oIntern;
+   return oSymTable;
+}
+
+void SymTable_free(SymTable_T oSymTable)
+{
+   assert(oSymTable != NULL);
+
+   /* With an arena every node and key goes at once*/
+   if (oSymTable->oArena != NULL)
+      Arena_free(oSymTable->oArena);
+   else {
+      if (oSymTable->psRoot != NULL)
+         SymTable_freeSubtree(oSymTable, oSymTable->psRoot);
+      if (oSymTable->oPool != NULL)
+         Arena_free(oSymTable->oPool);
+   }
+   free(oSymTable);
+}
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+   assert(oSymTable != NULL);
+   return oSymTable->length;
+}
+
+/* Takes in SymTable_T oSymTable, the key const char *pcKey of
+size_t uLength characters and const void *pvValue and goes down
+the tree once, splitting every full node on the way so the leaf
+reached has room: if pcKey is present it stores the existing value
+in *ppvValue and returns 0, otherwise it adds the new binding to
+that leaf, stores pvValue in *ppvValue and returns 1. Returns -1
+if there is not enough memory, the splits done so far kept*/
+static int SymTable_insert(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength, const void *pvValue, void **ppvValue)
+{
+   struct Key sKey;
+   struct Node *psNode;
+   struct Node *psRoot;
+   char *pcKeyCopy;
+   size_t i;
+   int iFound;
+   int iCompare;
+
+   assert(oSymTable != NULL);
+   assert(ppvValue != NULL);
+
+   STATS_ADD(oSymTable, ulPuts, 1);
+   SymTable_makeKey(&sKey, pcKey, uLength);
+
+   if (oSymTable->psRoot == NULL){
+      oSymTable->psRoot = SymTable_newNode(oSymTable, 1);
+      if (oSymTable->psRoot == NULL)
+         return -1;
+   }
+   else if (oSymTable->psRoot->uCount == MAX_KEYS){
+      /* The tree grows at the root, by one level*/
+      psRoot = SymTable_newNode(oSymTable, 0);
+      if (psRoot == NULL)
+         return -1;
+      psRoot->apsChildren[0] = oSymTable->psRoot;
+      if (! SymTable_splitChild(oSymTable, psRoot, 0)){
+         SymTable_freeNode(oSymTable, psRoot);
+         return -1;
+      }
+      oSymTable->psRoot = psRoot;
+   }
+
+   psNode = oSymTable->psRoot;
+   for (;;){
+      i = SymTable_search(oSymTable, psNode, &sKey, &iFound);
+      if (iFound){
+         *ppvValue = psNode->asBindings[i].pvValue;
+         return 0;
+      }
+      if (psNode->iLeaf)
+         break;
+      if (psNode->apsChildren[i]->uCount == MAX_KEYS){
+         if (! SymTable_splitChild(oSymTable, psNode, i))
+            return -1;
+         /* The binding that came up decides which half to take*/
+         STATS_ADD_ATOMIC(oSymTable, ulProbes, 1);
+         iCompare = SymTable_compareAt(psNode, i, &sKey);
+         if (iCompare == 0){
+            *ppvValue = psNode->asBindings[i].pvValue;
+            return 0;
+         }
+         if (iCompare < 0)
+            i++;
+      }
+      psNode = psNode->apsChildren[i];
+   }
+
+   pcKeyCopy = SymTable_copyKey(oSymTable, pcKey, uLength);
+   if (pcKeyCopy == NULL)
+      return -1;
+   SymTable_moveBindings(psNode, i + 1, psNode, i, psNode->uCount - i);
+   psNode->asBindings[i].pcKey = pcKeyCopy;
+   psNode->asBindings[i].uLength = uLength;
+   psNode->asBindings[i].pvValue = (void *) pvValue;
+   psNode->aulPrefixes[i] = sKey.ulPrefix;
+   psNode->uCount++;
+   oSymTable->length++;
+   *ppvValue = (void *) pvValue;
+   return 1;
+}
+
+int SymTable_put(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue)
+{
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+   return SymTable_putN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+int SymTable_putN(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, const void *pvValue)
+{
+   void *pvFound;
+   assert(oSymTable != NULL);
+   return SymTable_insert(oSymTable, pcKey, uLength, pvValue,
+      &pvFound) == 1;
+}
+
+int SymTable_putOrGet(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue, void **ppvValue)
+{
+   void *pvFound;
+   int iResult;
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   iResult = SymTable_insert(oSymTable, pcKey, strlen(pcKey), pvValue,
+      &pvFound);
+   if (iResult != -1 && ppvValue != NULL)
+      *ppvValue = pvFound;
+   return iResult;
+}
+
+void *SymTable_replace(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue)
+{
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+   return SymTable_replaceN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+void *SymTable_replaceN(SymTable_T oSymTable,
+    const char *pcKey, size_t uLength, const void *pvValue)
+{
+   struct Binding *psBinding;
+   struct Key sKey;
+   void *pvOldValue;
+
+   assert(oSymTable != NULL);
+   STATS_ADD(oSymTable, ulReplaces, 1);
+   SymTable_makeKey(&sKey, pcKey, uLength);
+   psBinding = SymTable_find(oSymTable, &sKey);
+   if (psBinding == NULL)
+      return NULL;
+   pvOldValue = psBinding->pvValue;
+   psBinding->pvValue = (void *) pvValue;
+   return pvOldValue;
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+   return SymTable_containsN(oSymTable, pcKey, strlen(pcKey));
+}
+
+int SymTable_containsN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength)
+{
+   struct Key sKey;
+
+   assert(oSymTable != NULL);
+   STATS_ADD_ATOMIC(oSymTable, ulContains, 1);
+   SymTable_makeKey(&sKey, pcKey, uLength);
+   return SymTable_find(oSymTable, &sKey) != NULL;
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+   return SymTable_getN(oSymTable, pcKey, strlen(pcKey));
+}
+
+void *SymTable_getN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength)
+{
+   struct Binding *psBinding;
+   struct Key sKey;
+
+   assert(oSymTable != NULL);
+   STATS_ADD_ATOMIC(oSymTable, ulGets, 1);
+   SymTable_makeKey(&sKey, pcKey, uLength);
+   psBinding = SymTable_find(oSymTable, &sKey);
+   if (psBinding == NULL)
+      return NULL;
+   return psBinding->pvValue;
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+   return SymTable_removeN(oSymTable, pcKey, strlen(pcKey));
+}
+
+void *SymTable_removeN(SymTable_T oSymTable, const char *pcKey,
+    size_t uLength)
+{
+   struct Binding sRemoved;
+   struct Key sKey;
+   struct Node *psRoot;
+   int iFound;
+
+   assert(oSymTable != NULL);
+   STATS_ADD(oSymTable, ulRemoves, 1);
+
+   psRoot = oSymTable->psRoot;
+   if (psRoot == NULL)
+      return NULL;
+   SymTable_makeKey(&sKey, pcKey, uLength);
+   iFound = SymTable_extract(oSymTable, psRoot, &sKey, &sRemoved);
+
+   /* A root left empty by the last removal, or by merging its only
+   two children, gives way to its child, the tree losing a level*/
+   if (psRoot->uCount == 0){
+      oSymTable->psRoot = psRoot->iLeaf ? NULL : psRoot->apsChildren[0];
+      SymTable_freeNode(oSymTable, psRoot);
+   }
+   if (! iFound)
+      return NULL;
+
+   SymTable_freeKey(oSymTable, &sRemoved);
+   oSymTable->length--;
+   return sRemoved.pvValue;
+}
+
+void SymTable_getBatch(SymTable_T oSymTable, const char **ppcKeys,
+    size_t uCount, void **ppvValues)
+{
+   size_t i;
+
+   assert(oSymTable != NULL);
+   assert(ppcKeys != NULL || uCount == 0);
+   assert(ppvValues != NULL || uCount == 0);
+
+   /* Each lookup goes down a path decided by comparisons along the
+   way, so there is no address to prefetch ahead of it*/
+   for (i = 0; i < uCount; i++)
+      ppvValues[i] = SymTable_get(oSymTable, ppcKeys[i]);
+}
+
+size_t SymTable_putBatch(SymTable_T oSymTable, const char **ppcKeys,
+    void **ppvValues, size_t uCount)
+{
+   size_t uInserted = 0;
+   size_t i;
+
+   assert(oSymTable != NULL);
+   assert(ppcKeys != NULL || uCount == 0);
+   assert(ppvValues != NULL || uCount == 0);
+
+   for (i = 0; i < uCount; i++)
+      if (SymTable_put(oSymTable, ppcKeys[i], ppvValues[i]))
+         uInserted++;
+   return uInserted;
+}
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCount)
+{
+   struct Node *psRoot = NULL;
+   size_t uNodes;
+   Arena_T oPool;
+
+   assert(oSymTable != NULL);
+
+   if (uCount <= oSymTable->length)
+      return 1;
+
+   /* Every node but the root holds at least MIN_KEYS bindings, so
+   uCount bindings never take more nodes than this*/
+   uNodes = uCount / MIN_KEYS + 1;
+   if (uNodes <= oSymTable->uNodeCount + oSymTable->uSpareNodes)
+      return 1;
+   uNodes -= oSymTable->uNodeCount + oSymTable->uSpareNodes;
+
+   if (oSymTable->oArena != NULL){
+      if (! Arena_reserveObjects(oSymTable->oArena, uNodes))
+         return 0;
+   }
+   else if (oSymTable->oPool != NULL){
+      if (! Arena_reserveObjects(oSymTable->oPool, uNodes))
+         return 0;
+   }
+   else {
+      /* The first call sets up the pool, one chunk holding every
+      node, and moves the nodes so far into it so that every node
+      can be given back to the pool*/
+      oPool = Arena_new(sizeof(struct Node),
+         oSymTable->uNodeCount + uNodes);
+      if (oPool == NULL)
+         return 0;
+      if (! Arena_reserveObjects(oPool,
+            oSymTable->uNodeCount + uNodes)){
+         Arena_free(oPool);
+         return 0;
+      }
+      if (oSymTable->psRoot != NULL){
+         psRoot = SymTable_copyNodes(oSymTable->psRoot, oPool);
+         assert(psRoot != NULL);
+         SymTable_freeNodes(oSymTable->psRoot);
+      }
+      oSymTable->psRoot = psRoot;
+      oSymTable->oPool = oPool;
+   }
+   oSymTable->uSpareNodes += uNodes;
+   return 1;
+}
+
+void SymTable_setReorder(SymTable_T oSymTable,
+    enum SymTableReorder eReorder)
+{
+   /* The B-tree keeps its keys sorted and finds each one in
+   logarithmic time, there is no chain to reorder*/
+   assert(oSymTable != NULL);
+   (void)oSymTable;
+   (void)eReorder;
+}
+
+int SymTable_setFilter(SymTable_T oSymTable, int iEnabled)
+{
+   /* The B-tree never hashes its keys, it finds them by comparing
+   them along a single path from the root*/
+   assert(oSymTable != NULL);
+   (void)oSymTable;
+   (void)iEnabled;
+   return 1;
+}
+
+void SymTable_compact(SymTable_T oSymTable)
+{
+   struct Node *psRoot = NULL;
+
+   assert(oSymTable != NULL);
+
+   /* Removals already merge nodes, keeping all but the root at
+   least half full, so only the nodes reserved in the pool and not
+   in use are left to give back: the tree moves out into nodes of
+   its own and the pool goes. An arena only gives back memory with
+   SymTable_free*/
+   if (oSymTable->oPool == NULL)
+      return;
+   if (oSymTable->psRoot != NULL){
+      psRoot = SymTable_copyNodes(oSymTable->psRoot, NULL);
+      if (psRoot == NULL)
+         return;
+   }
+   Arena_free(oSymTable->oPool);
+   oSymTable->oPool = NULL;
+   oSymTable->psRoot = psRoot;
+   oSymTable->uSpareNodes = 0;
+}
+
+void SymTable_getStats(SymTable_T oSymTable,
+    struct SymTableStats *psStats)
+{
+   assert(oSymTable != NULL);
+   assert(psStats != NULL);
+
+#ifdef SYMTABLE_STATS
+   *psStats = oSymTable->sStats;
+#else
+   memset(psStats, 0, sizeof(struct SymTableStats));
+#endif
+   /* A bucket is a node and its chain the bindings it holds. Spare
+   nodes count as empty buckets*/
+   psStats->uLength = oSymTable->length;
+   psStats->uBucketCount =
+      oSymTable->uNodeCount + oSymTable->uSpareNodes;
+   psStats->dLoadFactor = psStats->uBucketCount == 0 ? 0.0 :
+      (double)oSymTable->length / (double)psStats->uBucketCount;
+   psStats->uLongestChain = 0;
+   memset(psStats->auChainLengths, 0, sizeof(psStats->auChainLengths));
+   psStats->auChainLengths[0] = oSymTable->uSpareNodes;
+   psStats->uKeyBytes = 0;
+   if (oSymTable->psRoot != NULL)
+      SymTable_statsSubtree(oSymTable->psRoot, psStats);
+   psStats->uBindingBytes = psStats->uBucketCount * sizeof(struct Node);
+}
+
+void SymTable_map(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+   SymTable_mapRange(oSymTable, NULL, NULL, pfApply, pvExtra);
+}
+
+void SymTable_mapRange(SymTable_T oSymTable,
+    const char *pcLow, const char *pcHigh,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+   struct Range sRange;
+
+   assert(oSymTable != NULL);
+   assert(pfApply != NULL);
+
+   sRange.iHasLow = pcLow != NULL;
+   if (pcLow != NULL)
+      SymTable_makeKey(&sRange.sLow, pcLow, strlen(pcLow));
+   sRange.iHasHigh = pcHigh != NULL;
+   if (pcHigh != NULL)
+      SymTable_makeKey(&sRange.sHigh, pcHigh, strlen(pcHigh));
+   sRange.iPrefix = 0;
+   sRange.pfApply = pfApply;
+   sRange.pvExtra = (void *) pvExtra;
+   SymTable_mapWithin(oSymTable, &sRange);
+}
+
+void SymTable_mapPrefix(SymTable_T oSymTable, const char *pcPrefix,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+   struct Range sRange;
+
+   assert(oSymTable != NULL);
+   assert(pcPrefix != NULL);
+   assert(pfApply != NULL);
+
+   /* The keys starting with pcPrefix are the ones from pcPrefix up
+   to the first that does not start with it*/
+   SymTable_makeKey(&sRange.sLow, pcPrefix, strlen(pcPrefix));
+   sRange.sHigh = sRange.sLow;
+   sRange.iHasLow = 1;
+   sRange.iHasHigh = 1;
+   sRange.iPrefix = 1;
+   sRange.pfApply = pfApply;
+   sRange.pvExtra = (void *) pvExtra;
+   SymTable_mapWithin(oSymTable, &sRange);
+}
+
+const char *SymTable_lowerBound(SymTable_T oSymTable,
+    const char *pcKey, void **ppvValue)
+{
+   struct Binding *psBound = NULL;
+   struct Node *psNode;
+   struct Key sKey;
+   size_t i;
+   int iFound;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   /* Each node down the path can only offer a nearer bound than
+   the one above it*/
+   SymTable_makeKey(&sKey, pcKey, strlen(pcKey));
+   for (psNode = oSymTable->psRoot; psNode != NULL;
+         psNode = psNode->apsChildren[i]){
+      i = SymTable_search(oSymTable, psNode, &sKey, &iFound);
+      if (i < psNode->uCount)
+         psBound = &psNode->asBindings[i];
+      if (iFound || psNode->iLeaf)
+         break;
+   }
+   if (psBound == NULL)
+      return NULL;
+   if (ppvValue != NULL)
+      *ppvValue = psBound->pvValue;
+   return psBound->pcKey;
+}
+
+/* Takes in SymTableIter_T oIter and struct Node *psNode and pushes
+psNode and its leftmost descendants on the path of oIter, so the
+first binding of psNode comes next. Returns nothing*/
+static void SymTable_iterPushLeft(SymTableIter_T oIter,
+   struct Node *psNode)
+{
+   while (psNode != NULL){
+      assert(oIter->uDepth < MAX_DEPTH);
+      oIter->apsPath[oIter->uDepth] = psNode;
+      oIter->auIndex[oIter->uDepth] = 0;
+      oIter->uDepth++;
+      if (psNode->iLeaf)
+         break;
+      psNode = psNode->apsChildren[0];
+   }
+}
+
+/* Takes in SymTableIter_T oIter and const struct Key *psKey and
+sets the path of oIter so the first key not before *psKey comes
+next, the way SymTable_lowerBound goes down. Returns nothing*/
+static void SymTable_iterSeek(SymTableIter_T oIter,
+   const struct Key *psKey)
+{
+   struct Node *psNode;
+   size_t i;
+   int iFound;
+
+   oIter->uDepth = 0;
+   for (psNode = oIter->oSymTable->psRoot; psNode != NULL;
+         psNode = psNode->apsChildren[i]){
+      i = SymTable_search(oIter->oSymTable, psNode, psKey, &iFound);
+      assert(oIter->uDepth < MAX_DEPTH);
+      oIter->apsPath[oIter->uDepth] = psNode;
+      oIter->auIndex[oIter->uDepth] = i;
+      oIter->uDepth++;
+      if (iFound || psNode->iLeaf)
+         break;
+   }
+}
+
+/* Takes in SymTableIter_T oIter and moves its path past the next
+binding. Returns that binding, or NULL if every one was visited*/
+static struct Binding *SymTable_iterStep(SymTableIter_T oIter)
+{
+   struct Node *psNode;
+   size_t i;
+
+   /* A node whose bindings are all visited is done, its parent's
+   next binding follows it*/
+   while (oIter->uDepth > 0 &&
+         oIter->auIndex[oIter->uDepth - 1] ==
+         oIter->apsPath[oIter->uDepth - 1]->uCount)
+      oIter->uDepth--;
+   if (oIter->uDepth == 0)
+      return NULL;
+
+   psNode = oIter->apsPath[oIter->uDepth - 1];
+   i = oIter->auIndex[oIter->uDepth - 1]++;
+   if (! psNode->iLeaf)
+      SymTable_iterPushLeft(oIter, psNode->apsChildren[i + 1]);
+   return &psNode->asBindings[i];
+}
+
+SymTableIter_T SymTable_iterBegin(SymTable_T oSymTable)
+{
+   SymTableIter_T oIter;
+
+   assert(oSymTable != NULL);
+
+   oIter = malloc(sizeof(struct SymTableIter));
+   if (oIter == NULL)
+      return NULL;
+   oIter->oSymTable = oSymTable;
+   oIter->uDepth = 0;
+   oIter->psCurrent = NULL;
+   SymTable_iterPushLeft(oIter, oSymTable->psRoot);
+   return oIter;
+}
+
+int SymTable_iterNext(SymTableIter_T oIter, const char **ppcKey,
+   void **ppvValue)
+{
+   assert(oIter != NULL);
+
+   oIter->psCurrent = SymTable_iterStep(oIter);
+   if (oIter->psCurrent == NULL)
+      return 0;
+   if (ppcKey != NULL)
+      *ppcKey = oIter->psCurrent->pcKey;
+   if (ppvValue != NULL)
+      *ppvValue = oIter->psCurrent->pvValue;
+   return 1;
+}
+
+void *SymTable_iterRemove(SymTableIter_T oIter)
+{
+   struct Binding *psNext;
+   struct Key sNext;
+   void *value;
+
+   assert(oIter != NULL);
+
+   if (oIter->psCurrent == NULL)
+      return NULL;
+
+   /* Merging and borrowing move bindings between nodes, so the
+   path is found again from the key that comes next. That key
+   string stays where it is whatever node its binding moves to*/
+   psNext = SymTable_iterStep(oIter);
+   if (psNext != NULL)
+      SymTable_makeKey(&sNext, psNext->pcKey, psNext->uLength);
+   value = SymTable_removeN(oIter->oSymTable,
+      oIter->psCurrent->pcKey, oIter->psCurrent->uLength);
+   oIter->psCurrent = NULL;
+   if (psNext != NULL)
+      SymTable_iterSeek(oIter, &sNext);
+   else
+      oIter->uDepth = 0;
+   return value;
+}
+
+void SymTable_iterEnd(SymTableIter_T oIter)
+{
+   assert(oIter != NULL);
+   free(oIter);
+}
+
+/* Takes in size_t uStart, size_t uEnd and the struct MapTask
+*pvTask and maps the nodes uStart to uEnd - 1 of it. Returns
+nothing*/
+static void SymTable_mapTask(size_t uStart, size_t uEnd, void *pvTask)
+{
+   struct MapTask *psTask = pvTask;
+   struct Node *psNode;
+   size_t i;
+   size_t j;
+
+   for (i = uStart; i < uEnd; i++){
+      psNode = psTask->apsNodes[i];
+      if (i >= psTask->uUpper)
+         (void)SymTable_mapSubtree(psTask->oSymTable, psNode,
+            &psTask->sRange, 0);
+      else
+         for (j = 0; j < psNode->uCount; j++)
+            (*psTask->sRange.pfApply)(psNode->asBindings[j].pcKey,
+               psNode->asBindings[j].pvValue, psTask->sRange.pvExtra);
+   }
+}
+
+void SymTable_mapParallel(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra, int iThreads)
+{
+   struct MapTask sTask;
+   size_t uLevelStart = 0;
+   size_t uLevelEnd = 1;
+   size_t uNext;
+   size_t i;
+   size_t j;
+
+   assert(oSymTable != NULL);
+   assert(pfApply != NULL);
+
+   if (iThreads <= 1 || oSymTable->psRoot == NULL){
+      SymTable_map(oSymTable, pfApply, pvExtra);
+      return;
+   }
+   sTask.apsNodes = malloc(oSymTable->uNodeCount
+      * sizeof(struct Node *));
+   if (sTask.apsNodes == NULL){
+      SymTable_map(oSymTable, pfApply, pvExtra);
+      return;
+   }
+
+   /* Lists the tree level by level, every leaf being as deep as
+   the others, until the last level listed is wide enough*/
+   sTask.apsNodes[0] = oSymTable->psRoot;
+   while (uLevelEnd - uLevelStart
+         < (size_t)iThreads * SUBTREES_PER_THREAD &&
+         ! sTask.apsNodes[uLevelStart]->iLeaf){
+      uNext = uLevelEnd;
+      for (i = uLevelStart; i < uLevelEnd; i++)
+         for (j = 0; j <= sTask.apsNodes[i]->uCount; j++)
+            sTask.apsNodes[uNext++] =
+               sTask.apsNodes[i]->apsChildren[j];
+      uLevelStart = uLevelEnd;
+      uLevelEnd = uNext;
+   }
+
+   sTask.oSymTable = oSymTable;
+   sTask.uUpper = uLevelStart;
+   sTask.sRange.iHasLow = 0;
+   sTask.sRange.iHasHigh = 0;
+   sTask.sRange.iPrefix = 0;
+   sTask.sRange.pfApply = pfApply;
+   sTask.sRange.pvExtra = (void *)pvExtra;
+   Parallel_run(uLevelEnd, 1, iThreads, SymTable_mapTask, &sTask);
+   free(sTask.apsNodes);
+}
@@ -0,0 +1,42 @@
+/* Interface of the ordered symbol table of symtableordered.c beyond
+the one of symtable.h. Its SymTable_map visits the bindings in
+increasing order of their keys, the order of strcmp, and so do the
+functions below*/
+#ifndef SYMTABLEORDERED_INCLUDED
+#define SYMTABLEORDERED_INCLUDED
+#include "symtable.h"
+
+/* SymTable_mapRange takes in a SymTable_T oSymTable, keys
+const char *pcLow and const char *pcHigh, function
+*pfApply(const char *pcKey, void *pvValue, void *pvExtra) and an
+extra parameter const void *pvExtra, and applies pfApply in order
+to each binding whose key is not before pcLow and is before
+pcHigh. Either bound may be NULL for no bound. It takes time
+proportional to the height of the tree plus the number of bindings
+visited. pfApply must not change oSymTable. Returns nothing
+(void)*/
+void SymTable_mapRange(SymTable_T oSymTable,
+    const char *pcLow, const char *pcHigh,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra);
+
+/* SymTable_mapPrefix takes in a SymTable_T oSymTable, a
+const char *pcPrefix, function *pfApply and const void *pvExtra,
+and applies pfApply in order to each binding whose key starts with
+pcPrefix ("" for every binding), in time proportional to the height
+of the tree plus the number of bindings visited. pfApply must not
+change oSymTable. Returns nothing (void)*/
+void SymTable_mapPrefix(SymTable_T oSymTable, const char *pcPrefix,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra);
+
+/* SymTable_lowerBound takes in a SymTable_T oSymTable, a key
+const char *pcKey and a void **ppvValue and returns the first key
+of oSymTable that is not before pcKey, storing its value in
+*ppvValue unless ppvValue is NULL. Returns NULL, leaving *ppvValue
+untouched, if every key is before pcKey. The key returned is the
+table's own copy and is valid until its binding is removed*/
+const char *SymTable_lowerBound(SymTable_T oSymTable,
+    const char *pcKey, void **ppvValue);
+
+#endif
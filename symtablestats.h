@@ -0,0 +1,40 @@
+/* Statistics counting of the SymTable implementations, compiled
+out unless SYMTABLE_STATS is defined. An implementation that counts
+keeps a struct SymTableStats sStats in its struct SymTable when
+SYMTABLE_STATS is defined*/
+#ifndef SYMTABLESTATS_INCLUDED
+#define SYMTABLESTATS_INCLUDED
+#include <time.h>
+
+/* STATS_ADD takes in a SymTable_T oSymTable, a field of struct
+SymTableStats and an amount n and adds n to that counter of
+oSymTable, with a plain increment. STATS_ADD_ATOMIC does the same
+with an atomic one. Lookups can run on one table from several
+threads at once, from pfApply of SymTable_mapParallel and in the
+lock-free reads of the concurrent table, so every counter a lookup
+adds to (ulGets, ulContains, ulProbes and ulFilterRejects) must be
+added to with STATS_ADD_ATOMIC, wherever else it is added to.
+STATS_ADD is only for counters that calls changing the table add
+to, which never overlap another call on it. STATS_CLOCK returns the
+CPU time for timing resizes. With SYMTABLE_STATS undefined they do
+nothing, and the amount added is evaluated only to be thrown away
+so it must have no side effects*/
+#ifdef SYMTABLE_STATS
+#define STATS_ADD(oSymTable, field, n) \
+   ((oSymTable)->sStats.field += (n))
+#define STATS_ADD_ATOMIC(oSymTable, field, n) \
+   ((void)__atomic_fetch_add(&(oSymTable)->sStats.field, (n), \
+      __ATOMIC_RELAXED))
+#define STATS_CLOCK() clock()
+#else
+#define STATS_ADD(oSymTable, field, n) ((void)(n))
+#define STATS_ADD_ATOMIC(oSymTable, field, n) ((void)(n))
+#define STATS_CLOCK() ((clock_t)0)
+#endif
+
+/* STATS_SECONDS takes in the clock_t iStart returned by
+STATS_CLOCK and returns the CPU seconds since, as a double*/
+#define STATS_SECONDS(iStart) \
+   ((double)(STATS_CLOCK() - (iStart)) / CLOCKS_PER_SEC)
+
+#endif
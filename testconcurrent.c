@@ -0,0 +1,638 @@
+/*--------------------------------------------------------------------*/
+/* testconcurrent.c                                                   */
+/* Multi-threaded stress and throughput test of a thread-safe        */
+/* SymTable implementation                                            */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200112L
+#include "symtableconcurrent.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <time.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+enum {MAX_KEY_LENGTH = 24, MAX_THREADS = 64};
+
+/* The percentages of gets and puts in the mixed workload, the rest
+   are removes. */
+enum {GET_PERCENT = 80, PUT_PERCENT = 10};
+
+/*--------------------------------------------------------------------*/
+
+/* What each worker thread is given. */
+
+struct Worker
+{
+   /* The table every worker shares. */
+   SymTable_T oSymTable;
+
+   /* The worker's number, 0 to the thread count - 1. */
+   int iThread;
+
+   /* The number of keys (or operations) the worker handles. */
+   int iCount;
+
+   /* The number of keys shared by all workers in the mixed
+      workload. */
+   int iKeySpace;
+
+   /* The number of new bindings the worker inserted. */
+   long lInserted;
+
+   /* The number of bindings the worker removed. */
+   long lRemoved;
+};
+
+/* Set once the writer of the read-mostly test is done, read and
+written atomically*/
+static int iWriterDone;
+
+/* The two values the stable keys of the read-mostly test take
+turns holding*/
+static int aiValues[2];
+
+/* The number of bindings visited by lookUpMapped, added to
+atomically*/
+static int iMapped;
+
+/* The number of threads the maps of testNestedMap use*/
+static int iNestedThreads;
+
+/* What a map of an inner table of testNestedMap is given. */
+
+struct NestedMap
+{
+   /* The outer table and the key it binds the inner one to. */
+   SymTable_T oOuter;
+   const char *pcOuterKey;
+
+   /* The inner table mapped. */
+   SymTable_T oInner;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the current wall clock time in seconds. */
+
+static double wallTime(void)
+{
+   struct timespec sTime;
+   clock_gettime(CLOCK_MONOTONIC, &sTime);
+   return (double)sTime.tv_sec + (double)sTime.tv_nsec / 1e9;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the next pseudo-random number of the sequence whose state
+   is *puState. Each worker keeps its own state, unlike rand(). */
+
+static unsigned long nextRandom(unsigned long *puState)
+{
+   *puState = *puState * 1103515245UL + 12345UL;
+   return (*puState >> 16) & 0x7FFFFFFFUL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Start iCount threads running pfWorker, one per element of
+   asWorkers, and wait for all of them. */
+
+static void runWorkers(struct Worker *asWorkers, int iCount,
+   void *(*pfWorker)(void *))
+{
+   pthread_t aThreads[MAX_THREADS];
+   int i;
+
+   for (i = 0; i < iCount; i++)
+      ASSURE(pthread_create(&aThreads[i], NULL, pfWorker,
+         &asWorkers[i]) == 0);
+   for (i = 0; i < iCount; i++)
+      pthread_join(aThreads[i], NULL);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put, get, replace and remove keys that only this worker uses,
+   while the other workers do the same with theirs. pvWorker is
+   the struct Worker of this thread. */
+
+static void *disjointWorker(void *pvWorker)
+{
+   struct Worker *psWorker = pvWorker;
+   char acKey[MAX_KEY_LENGTH];
+   int i;
+
+   for (i = 0; i < psWorker->iCount; i++)
+   {
+      sprintf(acKey, "d%d:%d", psWorker->iThread, i);
+      ASSURE(SymTable_put(psWorker->oSymTable, acKey, psWorker));
+   }
+   for (i = 0; i < psWorker->iCount; i++)
+   {
+      sprintf(acKey, "d%d:%d", psWorker->iThread, i);
+      ASSURE(SymTable_get(psWorker->oSymTable, acKey) == psWorker);
+      ASSURE(SymTable_replace(psWorker->oSymTable, acKey, acKey)
+         == psWorker);
+   }
+   for (i = 0; i < psWorker->iCount; i += 2)
+   {
+      sprintf(acKey, "d%d:%d", psWorker->iThread, i);
+      ASSURE(SymTable_remove(psWorker->oSymTable, acKey) != NULL);
+      ASSURE(! SymTable_contains(psWorker->oSymTable, acKey));
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Race every other worker to insert the same keys with
+   SymTable_putOrGet, counting the keys this worker won. pvWorker
+   is the struct Worker of this thread. */
+
+static void *sharedWorker(void *pvWorker)
+{
+   struct Worker *psWorker = pvWorker;
+   char acKey[MAX_KEY_LENGTH];
+   void *pvValue;
+   int iResult;
+   int i;
+
+   for (i = 0; i < psWorker->iCount; i++)
+   {
+      sprintf(acKey, "s%d", i);
+      iResult = SymTable_putOrGet(psWorker->oSymTable, acKey,
+         psWorker, &pvValue);
+      ASSURE(iResult == 0 || iResult == 1);
+      ASSURE(pvValue != NULL);
+      if (iResult == 1)
+      {
+         ASSURE(pvValue == psWorker);
+         psWorker->lInserted++;
+      }
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run a random mix of gets, puts and removes over keys shared by
+   every worker, counting the bindings this worker inserted and
+   removed. pvWorker is the struct Worker of this thread. */
+
+static void *mixedWorker(void *pvWorker)
+{
+   struct Worker *psWorker = pvWorker;
+   char acKey[MAX_KEY_LENGTH];
+   unsigned long uState = (unsigned long)psWorker->iThread + 1;
+   unsigned long uChoice;
+   int i;
+
+   for (i = 0; i < psWorker->iCount; i++)
+   {
+      sprintf(acKey, "m%lu",
+         nextRandom(&uState) % (unsigned long)psWorker->iKeySpace);
+      uChoice = nextRandom(&uState) % 100;
+      if (uChoice < GET_PERCENT)
+         (void)SymTable_get(psWorker->oSymTable, acKey);
+      else if (uChoice < GET_PERCENT + PUT_PERCENT)
+      {
+         if (SymTable_put(psWorker->oSymTable, acKey, psWorker))
+            psWorker->lInserted++;
+      }
+      else if (SymTable_remove(psWorker->oSymTable, acKey) != NULL)
+         psWorker->lRemoved++;
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Worker 0 is the writer: it flips the value of every stable key
+between the two of aiValues, and inserts and removes keys of its
+own, expanding the table a few times. Every other worker reads the
+stable keys until the writer is done, each of which must always
+hold one of the two values. pvWorker is the struct Worker of this
+thread. */
+
+static void *readMostlyWorker(void *pvWorker)
+{
+   struct Worker *psWorker = pvWorker;
+   char acKey[MAX_KEY_LENGTH];
+   SymTableIter_T oIter;
+   const char *pcKey;
+   void *pvValue;
+   int iKeyRound;
+   int iRound;
+   int i;
+
+   if (psWorker->iThread == 0)
+   {
+      for (iRound = 1; iRound <= 4; iRound++)
+      {
+         for (i = 0; i < psWorker->iKeySpace; i++)
+         {
+            sprintf(acKey, "r%d", i);
+            ASSURE(SymTable_replace(psWorker->oSymTable, acKey,
+               &aiValues[iRound % 2]) == &aiValues[(iRound + 1) % 2]);
+         }
+         for (i = 0; i < psWorker->iCount; i++)
+         {
+            sprintf(acKey, "w%d:%d", iRound, i);
+            ASSURE(SymTable_put(psWorker->oSymTable, acKey, acKey));
+         }
+         /* Odd rounds remove through an iterator, which holds
+            every lock the readers never take. */
+         if (iRound % 2 == 0)
+            for (i = 0; i < psWorker->iCount; i += 64)
+            {
+               sprintf(acKey, "w%d:%d", iRound, i);
+               ASSURE(SymTable_remove(psWorker->oSymTable, acKey)
+                  != NULL);
+            }
+         else
+         {
+            oIter = SymTable_iterBegin(psWorker->oSymTable);
+            ASSURE(oIter != NULL);
+            while (SymTable_iterNext(oIter, &pcKey, &pvValue))
+               if (sscanf(pcKey, "w%d:%d", &iKeyRound, &i) == 2 &&
+                   iKeyRound == iRound && i % 64 == 0)
+                  ASSURE(SymTable_iterRemove(oIter) == pvValue);
+            SymTable_iterEnd(oIter);
+         }
+      }
+      __atomic_store_n(&iWriterDone, 1, __ATOMIC_RELEASE);
+      return NULL;
+   }
+
+   while (! __atomic_load_n(&iWriterDone, __ATOMIC_ACQUIRE))
+      for (i = 0; i < psWorker->iKeySpace; i++)
+      {
+         sprintf(acKey, "r%d", i);
+         pvValue = SymTable_get(psWorker->oSymTable, acKey);
+         ASSURE(pvValue == &aiValues[0] || pvValue == &aiValues[1]);
+         ASSURE(SymTable_contains(psWorker->oSymTable, acKey));
+      }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run iThreadCount workers on one table, each handling iCount keys
+   or operations, and check that the table agrees with what the
+   workers did. Write the wall clock time of the mixed workload to
+   stdout. */
+
+static void testConcurrent(int iThreadCount, int iCount)
+{
+   struct Worker asWorkers[MAX_THREADS];
+   SymTable_T oSymTable;
+   long lInserted;
+   long lRemoved;
+   double dStart;
+   double dSeconds;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a SymTable object shared by %d threads.\n",
+      iThreadCount);
+   printf("No output except the throughput should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < iThreadCount; i++)
+   {
+      asWorkers[i].oSymTable = oSymTable;
+      asWorkers[i].iThread = i;
+      asWorkers[i].iCount = iCount;
+      asWorkers[i].iKeySpace = iCount;
+      asWorkers[i].lInserted = 0;
+      asWorkers[i].lRemoved = 0;
+   }
+
+   /* Disjoint keys: every odd key of every worker is left. */
+   runWorkers(asWorkers, iThreadCount, disjointWorker);
+   ASSURE(SymTable_getLength(oSymTable)
+      == (size_t)iThreadCount * (size_t)(iCount / 2));
+
+   /* Shared keys: each key is inserted by exactly one worker. */
+   runWorkers(asWorkers, iThreadCount, sharedWorker);
+   lInserted = 0;
+   for (i = 0; i < iThreadCount; i++)
+      lInserted += asWorkers[i].lInserted;
+   ASSURE(lInserted == iCount);
+   ASSURE(SymTable_getLength(oSymTable)
+      == (size_t)iThreadCount * (size_t)(iCount / 2) + (size_t)iCount);
+   SymTable_free(oSymTable);
+
+   /* Mixed workload: the final length has to match the inserts
+      and removes the workers saw succeed. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < iThreadCount; i++)
+   {
+      asWorkers[i].oSymTable = oSymTable;
+      asWorkers[i].lInserted = 0;
+      asWorkers[i].lRemoved = 0;
+   }
+   dStart = wallTime();
+   runWorkers(asWorkers, iThreadCount, mixedWorker);
+   dSeconds = wallTime() - dStart;
+   lInserted = 0;
+   lRemoved = 0;
+   for (i = 0; i < iThreadCount; i++)
+   {
+      lInserted += asWorkers[i].lInserted;
+      lRemoved += asWorkers[i].lRemoved;
+   }
+   ASSURE(SymTable_getLength(oSymTable)
+      == (size_t)(lInserted - lRemoved));
+   SymTable_free(oSymTable);
+
+   printf("Mixed workload (%d threads x %d operations): "
+      "%f seconds, %.0f operations/second\n", iThreadCount, iCount,
+      dSeconds, (double)iThreadCount * iCount / dSeconds);
+   fflush(stdout);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Read a read-mostly table from iThreadCount - 1 workers while
+one more writes it, iCount keys at a time. */
+
+static void testReadMostly(int iThreadCount, int iCount)
+{
+   struct Worker asWorkers[MAX_THREADS];
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a read-mostly SymTable object.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_newReadMostly();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < iCount; i++)
+   {
+      sprintf(acKey, "r%d", i);
+      ASSURE(SymTable_put(oSymTable, acKey, &aiValues[0]));
+   }
+   for (i = 0; i < iThreadCount; i++)
+   {
+      asWorkers[i].oSymTable = oSymTable;
+      asWorkers[i].iThread = i;
+      asWorkers[i].iCount = iCount;
+      asWorkers[i].iKeySpace = iCount;
+   }
+
+   runWorkers(asWorkers, iThreadCount, readMostlyWorker);
+   /* Each of the 4 rounds leaves all but every 64th of its keys*/
+   ASSURE(SymTable_getLength(oSymTable) == (size_t)iCount
+      + 4 * ((size_t)iCount - (size_t)(iCount + 63) / 64));
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Look pcKey up in the table that pvTable points to, which must
+bind it to pvValue, and count the visit atomically. A pfApply of
+SymTable_map and SymTable_mapParallel. */
+
+static void lookUpMapped(const char *pcKey, void *pvValue,
+   void *pvTable)
+{
+   SymTable_T oSymTable = *(SymTable_T *)pvTable;
+   static const char *apcMissing[1] = {"absent"};
+   void *pvMissing;
+
+   ASSURE(SymTable_get(oSymTable, pcKey) == pvValue);
+   ASSURE(SymTable_contains(oSymTable, pcKey));
+   ASSURE(! SymTable_contains(oSymTable, "absent"));
+   SymTable_getBatch(oSymTable, apcMissing, 1, &pvMissing);
+   ASSURE(pvMissing == NULL);
+   __atomic_add_fetch(&iMapped, 1, __ATOMIC_RELAXED);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Map a table of iCount keys, then map it from iThreadCount
+threads, with a function that looks every key up in the same table
+again, first for a table made by SymTable_new and then for one made
+by SymTable_newReadMostly. */
+
+static void testMapLookup(int iThreadCount, int iCount)
+{
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   int iReadMostly;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing lookups from the function of SymTable_map.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (iReadMostly = 0; iReadMostly <= 1; iReadMostly++)
+   {
+      oSymTable = iReadMostly ? SymTable_newReadMostly()
+         : SymTable_new();
+      ASSURE(oSymTable != NULL);
+      for (i = 0; i < iCount; i++)
+      {
+         sprintf(acKey, "l%d", i);
+         ASSURE(SymTable_put(oSymTable, acKey, &aiValues[i % 2]));
+      }
+
+      iMapped = 0;
+      SymTable_map(oSymTable, lookUpMapped, &oSymTable);
+      ASSURE(iMapped == iCount);
+
+      iMapped = 0;
+      SymTable_mapParallel(oSymTable, lookUpMapped, &oSymTable,
+         iThreadCount);
+      ASSURE(iMapped == iCount);
+
+      /* The stripe locks are taken again once the maps are over. */
+      ASSURE(SymTable_put(oSymTable, "absent", NULL));
+      ASSURE(SymTable_remove(oSymTable, "absent") == NULL);
+      ASSURE(SymTable_get(oSymTable, "l0") == &aiValues[0]);
+      SymTable_free(oSymTable);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Look pcKey up in the inner table of the struct NestedMap pvNested,
+which must bind it to pvValue, and the inner table up in the outer
+one, and count the visit atomically. A pfApply of the maps of an
+inner table. */
+
+static void visitInner(const char *pcKey, void *pvValue,
+   void *pvNested)
+{
+   struct NestedMap *psNested = pvNested;
+
+   ASSURE(SymTable_get(psNested->oOuter, psNested->pcOuterKey)
+      == psNested->oInner);
+   ASSURE(SymTable_get(psNested->oInner, pcKey) == pvValue);
+   __atomic_add_fetch(&iMapped, 1, __ATOMIC_RELAXED);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Look pcKey up in the outer table pvOuter, which must bind it to
+pvValue. A pfApply of a map of the outer table nested in another
+one. */
+
+static void visitOuterAgain(const char *pcKey, void *pvValue,
+   void *pvOuter)
+{
+   ASSURE(SymTable_get((SymTable_T)pvOuter, pcKey) == pvValue);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Map the inner table pvInner, bound to pcKey in the outer table
+pvOuter, both with and without threads, then map the outer table
+again and look pcKey up in it once more. A pfApply of the maps of
+the outer table. */
+
+static void visitOuter(const char *pcKey, void *pvInner,
+   void *pvOuter)
+{
+   struct NestedMap sNested;
+
+   sNested.oOuter = pvOuter;
+   sNested.pcOuterKey = pcKey;
+   sNested.oInner = pvInner;
+   SymTable_map(sNested.oInner, visitInner, &sNested);
+   SymTable_mapParallel(sNested.oInner, visitInner, &sNested,
+      iNestedThreads);
+   SymTable_map(sNested.oOuter, visitOuterAgain, sNested.oOuter);
+   ASSURE(SymTable_get(sNested.oOuter, pcKey) == pvInner);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Map a table of tables, each of up to iCount keys, with and
+without iThreadCount threads, with a function that maps each inner
+table in turn and looks keys of both tables up from there. */
+
+static void testNestedMap(int iThreadCount, int iCount)
+{
+   enum {INNER_TABLE_COUNT = 8, MAX_INNER_KEYS = 1000};
+
+   SymTable_T oOuter;
+   SymTable_T aoInner[INNER_TABLE_COUNT];
+   char acKey[MAX_KEY_LENGTH];
+   int iInnerKeys;
+   int i;
+   int j;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing nested maps of a table of tables.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   iInnerKeys = iCount < MAX_INNER_KEYS ? iCount : MAX_INNER_KEYS;
+   iNestedThreads = iThreadCount;
+   oOuter = SymTable_new();
+   ASSURE(oOuter != NULL);
+   for (i = 0; i < INNER_TABLE_COUNT; i++)
+   {
+      /* Every other inner table is read without locks. */
+      aoInner[i] = i % 2 ? SymTable_newReadMostly() : SymTable_new();
+      ASSURE(aoInner[i] != NULL);
+      for (j = 0; j < iInnerKeys; j++)
+      {
+         sprintf(acKey, "i%d", j);
+         ASSURE(SymTable_put(aoInner[i], acKey, &aiValues[j % 2]));
+      }
+      sprintf(acKey, "o%d", i);
+      ASSURE(SymTable_put(oOuter, acKey, aoInner[i]));
+   }
+
+   iMapped = 0;
+   SymTable_map(oOuter, visitOuter, oOuter);
+   ASSURE(iMapped == 2 * INNER_TABLE_COUNT * iInnerKeys);
+
+   iMapped = 0;
+   SymTable_mapParallel(oOuter, visitOuter, oOuter, iThreadCount);
+   ASSURE(iMapped == 2 * INNER_TABLE_COUNT * iInnerKeys);
+
+   /* Every lock is released once the outermost map is over. */
+   ASSURE(SymTable_put(oOuter, "absent", NULL));
+   ASSURE(SymTable_remove(oOuter, "absent") == NULL);
+   for (i = 0; i < INNER_TABLE_COUNT; i++)
+   {
+      ASSURE(SymTable_put(aoInner[i], "absent", NULL));
+      SymTable_free(aoInner[i]);
+   }
+   SymTable_free(oOuter);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Stress test a thread-safe SymTable implementation. As always,
+   argc is the command-line argument count, argv contains the
+   command-line arguments, and argv[0] is the name of the executable
+   binary file. argv[1] is the number of threads and argv[2] the
+   number of keys or operations per thread. Exit with EXIT_FAILURE
+   if either is missing or out of range. Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iThreadCount;
+   int iCount;
+
+   if (argc != 3)
+   {
+      fprintf(stderr, "Usage: %s threadcount count\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+   if (sscanf(argv[1], "%d", &iThreadCount) != 1 ||
+       sscanf(argv[2], "%d", &iCount) != 1)
+   {
+      fprintf(stderr, "threadcount and count must be numeric\n");
+      exit(EXIT_FAILURE);
+   }
+   if (iThreadCount < 1 || iThreadCount > MAX_THREADS || iCount < 1)
+   {
+      fprintf(stderr, "threadcount must be 1 to %d and count "
+         "positive\n", MAX_THREADS);
+      exit(EXIT_FAILURE);
+   }
+
+   testConcurrent(iThreadCount, iCount);
+   testReadMostly(iThreadCount, iCount);
+   testMapLookup(iThreadCount, iCount);
+   testNestedMap(iThreadCount, iCount);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
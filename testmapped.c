@@ -0,0 +1,369 @@
+/*--------------------------------------------------------------------*/
+/* testmapped.c                                                       */
+/* Test of the snapshots of symtablemapped.c                          */
+/*--------------------------------------------------------------------*/
+
+#include "symtablemapped.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+enum {MAX_KEY_LENGTH = 24};
+
+/* The file every test saves to, removed at the end. */
+static const char acPath[] = "testmapped.tmp";
+
+/*--------------------------------------------------------------------*/
+
+/* What a SymTableMapped_map() has seen. */
+
+struct Visit
+{
+   /* The number of bindings visited. */
+   size_t uCount;
+
+   /* 1 as long as every value matched its key. */
+   int iMatched;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the bytes of the int pvValue points to and store their
+   number in *puSize. pvExtra is unused. */
+
+static const void *serializeInt(const void *pvValue, size_t *puSize,
+   void *pvExtra)
+{
+   (void)pvExtra;
+   *puSize = sizeof(int);
+   return pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the characters of the string pvValue, with its null
+   character, and store their number in *puSize, or return NULL
+   with a size of 0 for a NULL value. pvExtra is unused. */
+
+static const void *serializeString(const void *pvValue,
+   size_t *puSize, void *pvExtra)
+{
+   (void)pvExtra;
+   *puSize = pvValue == NULL ? 0 : strlen((const char*)pvValue) + 1;
+   return pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Check that the int value pvValue of uSize bytes is the number in
+   the key pcKey, recording the binding in the struct Visit
+   pvExtra. */
+
+static void visitInt(const char *pcKey, const void *pvValue,
+   size_t uSize, void *pvExtra)
+{
+   struct Visit *psVisit = (struct Visit*)pvExtra;
+
+   assert(pcKey != NULL);
+   assert(pvExtra != NULL);
+
+   if (uSize != sizeof(int) || *(const int*)pvValue != atoi(pcKey + 1))
+      psVisit->iMatched = 0;
+   psVisit->uCount++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test saving a table of iBindingCount int values, freeing it and
+   reading every binding back from the mapped snapshot. */
+
+static void testSaveAndOpen(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   SymTableMapped_T oMapped;
+   struct Visit sVisit;
+   char acKey[MAX_KEY_LENGTH];
+   int *aiNumbers;
+   const void *pvValue;
+   size_t uSize;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_save and SymTable_openMapped.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   aiNumbers = (int*)malloc((size_t)iBindingCount * sizeof(int));
+   ASSURE(aiNumbers != NULL);
+   if (aiNumbers == NULL)
+      return;
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      aiNumbers[i] = i;
+      sprintf(acKey, "k%d", i);
+      ASSURE(SymTable_put(oSymTable, acKey, &aiNumbers[i]));
+   }
+   ASSURE(SymTable_save(oSymTable, acPath, serializeInt, NULL));
+   SymTable_free(oSymTable);
+
+   /* The snapshot owns copies of everything. */
+   for (i = 0; i < iBindingCount; i++)
+      aiNumbers[i] = -1;
+
+   oMapped = SymTable_openMapped(acPath);
+   ASSURE(oMapped != NULL);
+   if (oMapped == NULL)
+   {
+      free(aiNumbers);
+      return;
+   }
+   ASSURE(SymTableMapped_getLength(oMapped) == (size_t)iBindingCount);
+
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "k%d", i);
+      uSize = 0;
+      pvValue = SymTableMapped_get(oMapped, acKey, &uSize);
+      ASSURE(pvValue != NULL);
+      ASSURE(uSize == sizeof(int));
+      ASSURE((size_t)pvValue % sizeof(double) == 0);
+      ASSURE(pvValue != NULL && *(const int*)pvValue == i);
+      ASSURE(SymTableMapped_contains(oMapped, acKey));
+   }
+
+   uSize = 12345;
+   ASSURE(SymTableMapped_get(oMapped, "k-1", &uSize) == NULL);
+   ASSURE(uSize == 12345);
+   ASSURE(! SymTableMapped_contains(oMapped, "k"));
+   ASSURE(! SymTableMapped_contains(oMapped, ""));
+   sprintf(acKey, "k%d", iBindingCount);
+   ASSURE(! SymTableMapped_contains(oMapped, acKey));
+
+   sVisit.uCount = 0;
+   sVisit.iMatched = 1;
+   SymTableMapped_map(oMapped, visitInt, &sVisit);
+   ASSURE(sVisit.uCount == (size_t)iBindingCount);
+   ASSURE(sVisit.iMatched);
+
+   SymTableMapped_free(oMapped);
+   free(aiNumbers);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test values of different sizes, a NULL value, the empty key, an
+   empty table and a table saved without a serializer. */
+
+static void testValues(void)
+{
+   SymTable_T oSymTable;
+   SymTableMapped_T oMapped;
+   const char *pcValue;
+   size_t uSize;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the values of a snapshot.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* An empty table. */
+   ASSURE(SymTable_save(oSymTable, acPath, serializeString, NULL));
+   oMapped = SymTable_openMapped(acPath);
+   ASSURE(oMapped != NULL);
+   if (oMapped != NULL)
+   {
+      ASSURE(SymTableMapped_getLength(oMapped) == 0);
+      ASSURE(! SymTableMapped_contains(oMapped, ""));
+      SymTableMapped_free(oMapped);
+   }
+
+   ASSURE(SymTable_put(oSymTable, "Ruth", "Right Field"));
+   ASSURE(SymTable_put(oSymTable, "Gehrig", "1B"));
+   ASSURE(SymTable_put(oSymTable, "", "The empty key"));
+   ASSURE(SymTable_put(oSymTable, "Jeter", NULL));
+
+   ASSURE(SymTable_save(oSymTable, acPath, serializeString, NULL));
+   oMapped = SymTable_openMapped(acPath);
+   ASSURE(oMapped != NULL);
+   if (oMapped != NULL)
+   {
+      ASSURE(SymTableMapped_getLength(oMapped) == 4);
+      pcValue = SymTableMapped_get(oMapped, "Ruth", &uSize);
+      ASSURE(pcValue != NULL && strcmp(pcValue, "Right Field") == 0);
+      ASSURE(uSize == sizeof("Right Field"));
+      pcValue = SymTableMapped_get(oMapped, "Gehrig", NULL);
+      ASSURE(pcValue != NULL && strcmp(pcValue, "1B") == 0);
+      pcValue = SymTableMapped_get(oMapped, "", NULL);
+      ASSURE(pcValue != NULL && strcmp(pcValue, "The empty key") == 0);
+
+      /* A value of 0 bytes is still there. */
+      pcValue = SymTableMapped_get(oMapped, "Jeter", &uSize);
+      ASSURE(pcValue != NULL);
+      ASSURE(uSize == 0);
+      ASSURE(SymTableMapped_get(oMapped, "Mantle", NULL) == NULL);
+      SymTableMapped_free(oMapped);
+   }
+
+   /* Without a serializer only the keys are saved. */
+   ASSURE(SymTable_save(oSymTable, acPath, NULL, NULL));
+   oMapped = SymTable_openMapped(acPath);
+   ASSURE(oMapped != NULL);
+   if (oMapped != NULL)
+   {
+      ASSURE(SymTableMapped_contains(oMapped, "Ruth"));
+      pcValue = SymTableMapped_get(oMapped, "Ruth", &uSize);
+      ASSURE(pcValue != NULL);
+      ASSURE(uSize == 0);
+      SymTableMapped_free(oMapped);
+   }
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write the first lSize bytes of the file at pcFrom to pcTo, and a
+   0 byte after them if iExtend is 1. */
+
+static void copyPrefix(const char *pcFrom, const char *pcTo,
+   long lSize, int iExtend)
+{
+   FILE *psFrom;
+   FILE *psTo;
+   int iChar;
+   long l;
+
+   psFrom = fopen(pcFrom, "rb");
+   psTo = fopen(pcTo, "wb");
+   ASSURE(psFrom != NULL && psTo != NULL);
+   if (psFrom == NULL || psTo == NULL)
+      exit(EXIT_FAILURE);
+   for (l = 0; l < lSize && (iChar = getc(psFrom)) != EOF; l++)
+      putc(iChar, psTo);
+   if (iExtend)
+      putc(0, psTo);
+   fclose(psFrom);
+   fclose(psTo);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that SymTable_openMapped refuses what is not a whole
+   snapshot. */
+
+static void testBadFiles(void)
+{
+   enum {BAD_BINDING_COUNT = 100};
+
+   static const char acCopy[] = "testmapped.tmp2";
+
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   FILE *psFile;
+   long lSize;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_openMapped on bad files.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   ASSURE(SymTable_openMapped("testmapped.missing") == NULL);
+
+   psFile = fopen(acCopy, "wb");
+   ASSURE(psFile != NULL);
+   if (psFile == NULL)
+      return;
+   fputs("This is not a snapshot of a symbol table at all.\n", psFile);
+   fclose(psFile);
+   ASSURE(SymTable_openMapped(acCopy) == NULL);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < BAD_BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "k%d", i);
+      ASSURE(SymTable_put(oSymTable, acKey, acKey));
+   }
+   ASSURE(SymTable_save(oSymTable, acPath, NULL, NULL));
+   SymTable_free(oSymTable);
+
+   psFile = fopen(acPath, "rb");
+   ASSURE(psFile != NULL);
+   if (psFile == NULL)
+      return;
+   fseek(psFile, 0L, SEEK_END);
+   lSize = ftell(psFile);
+   fclose(psFile);
+
+   /* Cut short or grown by a byte, it is not what was saved. */
+   copyPrefix(acPath, acCopy, lSize - 1, 0);
+   ASSURE(SymTable_openMapped(acCopy) == NULL);
+   copyPrefix(acPath, acCopy, lSize, 1);
+   ASSURE(SymTable_openMapped(acCopy) == NULL);
+   copyPrefix(acPath, acCopy, 16, 0);
+   ASSURE(SymTable_openMapped(acCopy) == NULL);
+
+   remove(acCopy);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the snapshots of symtablemapped.c. As always, argc is the
+   command-line argument count, argv contains the command-line
+   arguments, and argv[0] is the name of the executable binary file.
+   argv[1] is the number of bindings to save. Exit with
+   EXIT_FAILURE if it is missing or not positive. Otherwise return
+   0. */
+
+int main(int argc, char *argv[])
+{
+   int iCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s count\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+   if (sscanf(argv[1], "%d", &iCount) != 1 || iCount < 1)
+   {
+      fprintf(stderr, "count must be a positive number\n");
+      exit(EXIT_FAILURE);
+   }
+
+   testSaveAndOpen(iCount);
+   testValues();
+   testBadFiles();
+   remove(acPath);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
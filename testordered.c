@@ -0,0 +1,509 @@
+/*--------------------------------------------------------------------*/
+/* testordered.c                                                      */
+/* Test of the ordered scans of the B-tree SymTable implementation   */
+/*--------------------------------------------------------------------*/
+
+#include "symtableordered.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+enum {MAX_KEY_LENGTH = 24};
+
+/* The scan tests use the keys "k00000", "k00002" and so on, the
+   even numbers below RANGE_LIMIT. */
+enum {RANGE_LIMIT = 1000};
+
+/*--------------------------------------------------------------------*/
+
+/* What a scan has seen. */
+
+struct Visit
+{
+   /* The number of bindings visited. */
+   size_t uCount;
+
+   /* 1 as long as every key came after the one before. */
+   int iOrdered;
+
+   /* The first and last keys visited, NULL before the first. */
+   const char *pcFirst;
+   const char *pcLast;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the next pseudo-random number of the sequence whose state
+   is *puState. */
+
+static unsigned long nextRandom(unsigned long *puState)
+{
+   *puState = *puState * 1103515245UL + 12345UL;
+   return (*puState >> 16) & 0x7FFFFFFFUL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Reset *psVisit for a new scan. */
+
+static void startVisit(struct Visit *psVisit)
+{
+   psVisit->uCount = 0;
+   psVisit->iOrdered = 1;
+   psVisit->pcFirst = NULL;
+   psVisit->pcLast = NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Record the binding whose key is pcKey in the struct Visit
+   pvExtra. */
+
+static void visitBinding(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   struct Visit *psVisit = (struct Visit*)pvExtra;
+
+   assert(pcKey != NULL);
+   assert(pvExtra != NULL);
+   (void)pvValue;
+
+   if (psVisit->pcLast != NULL && strcmp(psVisit->pcLast, pcKey) >= 0)
+      psVisit->iOrdered = 0;
+   if (psVisit->pcFirst == NULL)
+      psVisit->pcFirst = pcKey;
+   psVisit->pcLast = pcKey;
+   psVisit->uCount++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put the keys "k00000", "k00002" and so on below RANGE_LIMIT into
+   oSymTable, from the last to the first, each with its number from
+   aiNumbers as value. */
+
+static void putRangeKeys(SymTable_T oSymTable, int *aiNumbers)
+{
+   char acKey[MAX_KEY_LENGTH];
+   int i;
+
+   for (i = RANGE_LIMIT - 2; i >= 0; i -= 2)
+   {
+      aiNumbers[i] = i;
+      sprintf(acKey, "k%05d", i);
+      ASSURE(SymTable_put(oSymTable, acKey, &aiNumbers[i]));
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that SymTable_map and the iterators visit the bindings in
+   order of key, with iBindingCount bindings put in a random order,
+   also while the iterator removes some of them. */
+
+static void testOrder(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   SymTableIter_T oIter;
+   struct Visit sVisit;
+   char acKey[MAX_KEY_LENGTH];
+   char acLast[MAX_KEY_LENGTH];
+   const char *pcKey;
+   size_t uRemoved;
+   size_t uCount;
+   int *aiOrder;
+   unsigned long uState = 1;
+   int iSwap;
+   int i;
+   int j;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the order of SymTable_map and the iterators.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   aiOrder = (int*)malloc((size_t)iBindingCount * sizeof(int));
+   ASSURE(aiOrder != NULL);
+   if (aiOrder == NULL)
+      return;
+   for (i = 0; i < iBindingCount; i++)
+      aiOrder[i] = i;
+   for (i = iBindingCount - 1; i > 0; i--)
+   {
+      j = (int)(nextRandom(&uState) % (unsigned long)(i + 1));
+      iSwap = aiOrder[i];
+      aiOrder[i] = aiOrder[j];
+      aiOrder[j] = iSwap;
+   }
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", aiOrder[i]);
+      ASSURE(SymTable_put(oSymTable, acKey, NULL));
+   }
+
+   startVisit(&sVisit);
+   SymTable_map(oSymTable, visitBinding, &sVisit);
+   ASSURE(sVisit.uCount == (size_t)iBindingCount);
+   ASSURE(sVisit.iOrdered);
+   ASSURE(strcmp(sVisit.pcFirst, "0") == 0);
+
+   /* Removing a random third of the keys on the way moves bindings
+      between nodes, which the iterator must not notice. */
+   oIter = SymTable_iterBegin(oSymTable);
+   ASSURE(oIter != NULL);
+   acLast[0] = '\0';
+   uCount = 0;
+   uRemoved = 0;
+   while (SymTable_iterNext(oIter, &pcKey, NULL))
+   {
+      ASSURE(uCount == 0 || strcmp(acLast, pcKey) < 0);
+      strcpy(acLast, pcKey);
+      uCount++;
+      if (nextRandom(&uState) % 3 == 0)
+      {
+         SymTable_iterRemove(oIter);
+         uRemoved++;
+         ASSURE(! SymTable_contains(oSymTable, acLast));
+      }
+   }
+   SymTable_iterEnd(oIter);
+   ASSURE(uCount == (size_t)iBindingCount);
+   ASSURE(SymTable_getLength(oSymTable) + uRemoved == uCount);
+
+   startVisit(&sVisit);
+   SymTable_map(oSymTable, visitBinding, &sVisit);
+   ASSURE(sVisit.uCount + uRemoved == (size_t)iBindingCount);
+   ASSURE(sVisit.iOrdered);
+
+   SymTable_free(oSymTable);
+   free(aiOrder);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_mapRange. */
+
+static void testMapRange(void)
+{
+   SymTable_T oSymTable;
+   struct Visit sVisit;
+   int aiNumbers[RANGE_LIMIT];
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_mapRange.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* An empty table has nothing in range. */
+   startVisit(&sVisit);
+   SymTable_mapRange(oSymTable, NULL, NULL, visitBinding, &sVisit);
+   ASSURE(sVisit.uCount == 0);
+
+   putRangeKeys(oSymTable, aiNumbers);
+
+   /* Bounds that are keys: the low one is in, the high one out. */
+   startVisit(&sVisit);
+   SymTable_mapRange(oSymTable, "k00100", "k00200", visitBinding,
+      &sVisit);
+   ASSURE(sVisit.uCount == 50);
+   ASSURE(sVisit.iOrdered);
+   ASSURE(strcmp(sVisit.pcFirst, "k00100") == 0);
+   ASSURE(strcmp(sVisit.pcLast, "k00198") == 0);
+
+   /* Bounds between keys. */
+   startVisit(&sVisit);
+   SymTable_mapRange(oSymTable, "k00101", "k002", visitBinding,
+      &sVisit);
+   ASSURE(sVisit.uCount == 49);
+   ASSURE(strcmp(sVisit.pcFirst, "k00102") == 0);
+   ASSURE(strcmp(sVisit.pcLast, "k00198") == 0);
+
+   /* Missing bounds. */
+   startVisit(&sVisit);
+   SymTable_mapRange(oSymTable, NULL, "k00010", visitBinding,
+      &sVisit);
+   ASSURE(sVisit.uCount == 5);
+   ASSURE(strcmp(sVisit.pcFirst, "k00000") == 0);
+   startVisit(&sVisit);
+   SymTable_mapRange(oSymTable, "k00990", NULL, visitBinding,
+      &sVisit);
+   ASSURE(sVisit.uCount == 5);
+   ASSURE(strcmp(sVisit.pcLast, "k00998") == 0);
+   startVisit(&sVisit);
+   SymTable_mapRange(oSymTable, NULL, NULL, visitBinding, &sVisit);
+   ASSURE(sVisit.uCount == RANGE_LIMIT / 2);
+   ASSURE(sVisit.iOrdered);
+
+   /* Empty ranges. */
+   startVisit(&sVisit);
+   SymTable_mapRange(oSymTable, "k00200", "k00200", visitBinding,
+      &sVisit);
+   ASSURE(sVisit.uCount == 0);
+   startVisit(&sVisit);
+   SymTable_mapRange(oSymTable, "k00300", "k00200", visitBinding,
+      &sVisit);
+   ASSURE(sVisit.uCount == 0);
+   startVisit(&sVisit);
+   SymTable_mapRange(oSymTable, "z", NULL, visitBinding, &sVisit);
+   ASSURE(sVisit.uCount == 0);
+   startVisit(&sVisit);
+   SymTable_mapRange(oSymTable, NULL, "a", visitBinding, &sVisit);
+   ASSURE(sVisit.uCount == 0);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_lowerBound. */
+
+static void testLowerBound(void)
+{
+   SymTable_T oSymTable;
+   int aiNumbers[RANGE_LIMIT];
+   const char *pcBound;
+   void *pvValue = NULL;
+   char acKey[MAX_KEY_LENGTH];
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_lowerBound.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_lowerBound(oSymTable, "", NULL) == NULL);
+
+   putRangeKeys(oSymTable, aiNumbers);
+
+   /* Every key is its own bound, and the next key that of every
+      string between them. */
+   for (i = 0; i < RANGE_LIMIT; i++)
+   {
+      sprintf(acKey, "k%05d", i);
+      pcBound = SymTable_lowerBound(oSymTable, acKey, &pvValue);
+      if (i == RANGE_LIMIT - 1)
+      {
+         ASSURE(pcBound == NULL);
+         continue;
+      }
+      ASSURE(pcBound != NULL);
+      ASSURE(pvValue == &aiNumbers[i + i % 2]);
+      ASSURE(atoi(pcBound + 1) == i + i % 2);
+   }
+
+   pcBound = SymTable_lowerBound(oSymTable, "k00010x", NULL);
+   ASSURE(pcBound != NULL && strcmp(pcBound, "k00012") == 0);
+   pcBound = SymTable_lowerBound(oSymTable, "", NULL);
+   ASSURE(pcBound != NULL && strcmp(pcBound, "k00000") == 0);
+   pvValue = NULL;
+   ASSURE(SymTable_lowerBound(oSymTable, "l", &pvValue) == NULL);
+   ASSURE(pvValue == NULL);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_mapPrefix. */
+
+static void testMapPrefix(void)
+{
+   SymTable_T oSymTable;
+   struct Visit sVisit;
+   int aiNumbers[RANGE_LIMIT];
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_mapPrefix.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   putRangeKeys(oSymTable, aiNumbers);
+   ASSURE(SymTable_put(oSymTable, "k001", NULL));
+   ASSURE(SymTable_put(oSymTable, "k0009", NULL));
+
+   startVisit(&sVisit);
+   SymTable_mapPrefix(oSymTable, "k001", visitBinding, &sVisit);
+   ASSURE(sVisit.uCount == 51);
+   ASSURE(sVisit.iOrdered);
+   ASSURE(strcmp(sVisit.pcFirst, "k001") == 0);
+   ASSURE(strcmp(sVisit.pcLast, "k00198") == 0);
+
+   startVisit(&sVisit);
+   SymTable_mapPrefix(oSymTable, "k0009", visitBinding, &sVisit);
+   ASSURE(sVisit.uCount == 6);
+   ASSURE(strcmp(sVisit.pcLast, "k00098") == 0);
+
+   startVisit(&sVisit);
+   SymTable_mapPrefix(oSymTable, "k00100", visitBinding, &sVisit);
+   ASSURE(sVisit.uCount == 1);
+
+   startVisit(&sVisit);
+   SymTable_mapPrefix(oSymTable, "", visitBinding, &sVisit);
+   ASSURE(sVisit.uCount == RANGE_LIMIT / 2 + 2);
+   ASSURE(sVisit.iOrdered);
+
+   startVisit(&sVisit);
+   SymTable_mapPrefix(oSymTable, "k001000", visitBinding, &sVisit);
+   ASSURE(sVisit.uCount == 0);
+   startVisit(&sVisit);
+   SymTable_mapPrefix(oSymTable, "x", visitBinding, &sVisit);
+   ASSURE(sVisit.uCount == 0);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put and remove iOperationCount random keys, checking the table
+   against an array of which keys it should hold, for each way of
+   creating a table. */
+
+static void testRandomOperations(int iOperationCount)
+{
+   enum {KEY_SPACE = 3000, CHECK_EVERY = 5000, CONSTRUCTOR_COUNT = 3};
+
+   SymTable_T oSymTable;
+   struct Visit sVisit;
+   char acKey[MAX_KEY_LENGTH];
+   char acPresent[KEY_SPACE];
+   unsigned long uState = 7;
+   size_t uLength;
+   int iConstructor;
+   int iKey;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing random puts and removes.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (iConstructor = 0; iConstructor < CONSTRUCTOR_COUNT;
+      iConstructor++)
+   {
+      if (iConstructor == 0)
+         oSymTable = SymTable_new();
+      else if (iConstructor == 1)
+         oSymTable = SymTable_newWithArena(0);
+      else
+         oSymTable = SymTable_newWithCapacity(KEY_SPACE / 2);
+      ASSURE(oSymTable != NULL);
+      memset(acPresent, 0, sizeof(acPresent));
+      uLength = 0;
+
+      for (i = 0; i < iOperationCount; i++)
+      {
+         iKey = (int)(nextRandom(&uState) % KEY_SPACE);
+         sprintf(acKey, "r%d", iKey);
+         /* Puts slightly outnumber removes so the table fills. */
+         if (nextRandom(&uState) % 100 < 55)
+         {
+            ASSURE(SymTable_put(oSymTable, acKey, acPresent)
+               == ! acPresent[iKey]);
+            if (! acPresent[iKey])
+               uLength++;
+            acPresent[iKey] = 1;
+         }
+         else
+         {
+            ASSURE(SymTable_remove(oSymTable, acKey)
+               == (acPresent[iKey] ? acPresent : NULL));
+            if (acPresent[iKey])
+               uLength--;
+            acPresent[iKey] = 0;
+         }
+         if (i % CHECK_EVERY == 0)
+         {
+            startVisit(&sVisit);
+            SymTable_map(oSymTable, visitBinding, &sVisit);
+            ASSURE(sVisit.iOrdered);
+            ASSURE(sVisit.uCount == uLength);
+         }
+      }
+
+      ASSURE(SymTable_getLength(oSymTable) == uLength);
+      for (iKey = 0; iKey < KEY_SPACE; iKey++)
+      {
+         sprintf(acKey, "r%d", iKey);
+         ASSURE(SymTable_contains(oSymTable, acKey)
+            == acPresent[iKey]);
+      }
+      SymTable_compact(oSymTable);
+      for (iKey = 0; iKey < KEY_SPACE; iKey++)
+      {
+         sprintf(acKey, "r%d", iKey);
+         ASSURE(SymTable_remove(oSymTable, acKey)
+            == (acPresent[iKey] ? acPresent : NULL));
+      }
+      ASSURE(SymTable_getLength(oSymTable) == 0);
+      startVisit(&sVisit);
+      SymTable_map(oSymTable, visitBinding, &sVisit);
+      ASSURE(sVisit.uCount == 0);
+      SymTable_free(oSymTable);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the ordered scans of a SymTable implementation. As always,
+   argc is the command-line argument count, argv contains the
+   command-line arguments, and argv[0] is the name of the executable
+   binary file. argv[1] is the number of bindings to put in the
+   table, and of random operations. Exit with EXIT_FAILURE if it is
+   missing or not positive. Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s count\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+   if (sscanf(argv[1], "%d", &iCount) != 1 || iCount < 1)
+   {
+      fprintf(stderr, "count must be a positive number\n");
+      exit(EXIT_FAILURE);
+   }
+
+   testOrder(iCount);
+   testMapRange();
+   testLowerBound();
+   testMapPrefix();
+   testRandomOperations(iCount);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
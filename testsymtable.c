@@ -383,6 +383,206 @@ static void testRemove(void)
 
 /*--------------------------------------------------------------------*/
 
+/* Test the SymTable_putOrGet() function. */
+
+static void testPutOrGet(void)
+{
+   SymTable_T oSymTable;
+   char acJeter[] = "Jeter";
+   char acMantle[] = "Mantle";
+   char acShortstop[] = "Shortstop";
+   char acCenterField[] = "Center Field";
+
+   void *pvValue;
+   char *pcValue;
+   int iResult;
+   size_t uLength;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_putOrGet() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* A new key is inserted and its own value is handed back. */
+   pvValue = NULL;
+   iResult = SymTable_putOrGet(oSymTable, acJeter, acShortstop,
+      &pvValue);
+   ASSURE(iResult == 1);
+   ASSURE(pvValue == acShortstop);
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == 1);
+
+   /* An existing key is left alone and its value is returned. */
+   pvValue = NULL;
+   iResult = SymTable_putOrGet(oSymTable, acJeter, acCenterField,
+      &pvValue);
+   ASSURE(iResult == 0);
+   ASSURE(pvValue == acShortstop);
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == 1);
+
+   pcValue = (char*)SymTable_get(oSymTable, acJeter);
+   ASSURE(pcValue == acShortstop);
+
+   /* ppvValue may be NULL, and NULL values are reported as such. */
+   iResult = SymTable_putOrGet(oSymTable, acMantle, NULL, NULL);
+   ASSURE(iResult == 1);
+
+   pvValue = acCenterField;
+   iResult = SymTable_putOrGet(oSymTable, acMantle, acCenterField,
+      &pvValue);
+   ASSURE(iResult == 0);
+   ASSURE(pvValue == NULL);
+
+   iResult = SymTable_put(oSymTable, acMantle, acCenterField);
+   ASSURE(! iResult);
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == 2);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test a SymTable object whose bindings come from an arena. */
+
+static void testArena(void)
+{
+   enum {ARENA_BINDING_COUNT = 1000, MAX_KEY_LENGTH = 10};
+
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   char acShortstop[] = "Shortstop";
+   char acCenterField[] = "Center Field";
+   char *pcValue;
+   int i;
+   int iSuccessful;
+   size_t uLength;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a SymTable object that uses an arena.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* A hint smaller than the number of bindings forces the
+      arena to add chunks. */
+   oSymTable = SymTable_newWithArena(ARENA_BINDING_COUNT / 10);
+   ASSURE(oSymTable != NULL);
+
+   for (i = 0; i < ARENA_BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acShortstop);
+      ASSURE(iSuccessful);
+   }
+
+   /* Remove every other binding, then put them back so the
+      freed bindings get reused. */
+   for (i = 0; i < ARENA_BINDING_COUNT; i += 2)
+   {
+      sprintf(acKey, "%d", i);
+      pcValue = (char*)SymTable_remove(oSymTable, acKey);
+      ASSURE(pcValue == acShortstop);
+   }
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == ARENA_BINDING_COUNT / 2);
+
+   for (i = 0; i < ARENA_BINDING_COUNT; i += 2)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acCenterField);
+      ASSURE(iSuccessful);
+   }
+
+   for (i = 0; i < ARENA_BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      pcValue = (char*)SymTable_get(oSymTable, acKey);
+      ASSURE(pcValue == ((i % 2 == 0) ? acCenterField : acShortstop));
+   }
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == ARENA_BINDING_COUNT);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTable_putBatch() and SymTable_getBatch() functions. */
+
+static void testBatch(void)
+{
+   enum {BATCH_KEY_COUNT = 100, MAX_KEY_LENGTH = 10};
+
+   SymTable_T oSymTable;
+   char aacKeys[BATCH_KEY_COUNT][MAX_KEY_LENGTH];
+   const char *apcKeys[BATCH_KEY_COUNT];
+   void *apvValues[BATCH_KEY_COUNT];
+   char acShortstop[] = "Shortstop";
+   char acCenterField[] = "Center Field";
+   int i;
+   int iSuccessful;
+   size_t uInserted;
+   size_t uLength;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable batch functions.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   iSuccessful = SymTable_put(oSymTable, "10", acCenterField);
+   ASSURE(iSuccessful);
+
+   /* Key "10" is already present and key "20" appears twice in the
+      batch, so two of the pairs are not inserted. */
+   for (i = 0; i < BATCH_KEY_COUNT; i++)
+   {
+      sprintf(aacKeys[i], "%d", (i == BATCH_KEY_COUNT - 1) ? 20 : i);
+      apcKeys[i] = aacKeys[i];
+      apvValues[i] = acShortstop;
+   }
+   uInserted = SymTable_putBatch(oSymTable, apcKeys, apvValues,
+      BATCH_KEY_COUNT);
+   ASSURE(uInserted == BATCH_KEY_COUNT - 2);
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == BATCH_KEY_COUNT - 1);
+
+   /* Odd positions look up keys that are not in the table. */
+   for (i = 0; i < BATCH_KEY_COUNT; i++)
+   {
+      sprintf(aacKeys[i], "%d", (i % 2 == 0) ? i : -i);
+      apvValues[i] = acCenterField;
+   }
+   SymTable_getBatch(oSymTable, apcKeys, BATCH_KEY_COUNT, apvValues);
+   for (i = 0; i < BATCH_KEY_COUNT; i++)
+   {
+      if (i == 10)
+         ASSURE(apvValues[i] == acCenterField);
+      else if (i % 2 == 0)
+         ASSURE(apvValues[i] == acShortstop);
+      else
+         ASSURE(apvValues[i] == NULL);
+   }
+
+   SymTable_getBatch(oSymTable, apcKeys, 0, apvValues);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
 /* Test the SymTable_map() function. */
 
 static void testMap(void)
@@ -431,6 +631,440 @@ static void testMap(void)
 
 /*--------------------------------------------------------------------*/
 
+/* Increment the size_t count pointed to by pvExtra. pcKey and
+   pvValue are unused. */
+
+static void countBinding(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   assert(pcKey != NULL);
+   assert(pvExtra != NULL);
+   (void)pvValue;
+
+   (*(size_t*)pvExtra)++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that SymTable_map() visits every binding of a table that
+   has grown, checking along the way while it grows. */
+
+static void testMapGrowing(void)
+{
+   enum {GROWING_BINDING_COUNT = 5000, MAX_KEY_LENGTH = 10};
+
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   char acShortstop[] = "Shortstop";
+   int i;
+   int iSuccessful;
+   size_t uCount;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_map() on a growing SymTable object.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   for (i = 0; i < GROWING_BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acShortstop);
+      ASSURE(iSuccessful);
+      if (i % 97 == 0)
+      {
+         uCount = 0;
+         SymTable_map(oSymTable, countBinding, &uCount);
+         ASSURE(uCount == (size_t)(i + 1));
+      }
+   }
+
+   uCount = 0;
+   SymTable_map(oSymTable, countBinding, &uCount);
+   ASSURE(uCount == GROWING_BINDING_COUNT);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Increment the int pointed to by pvValue, each binding's own, so
+   concurrent calls never touch the same one. pcKey and pvExtra are
+   unused. */
+
+static void countVisit(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   assert(pcKey != NULL);
+   assert(pvValue != NULL);
+   (void)pvExtra;
+
+   (*(int*)pvValue)++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Look pcKey up in the SymTable_T that pvExtra points to, which
+   must bind it to pvValue, and count the visit like countVisit().
+   Only makes the calls that SymTable_mapParallel() allows. */
+
+static void lookUpVisit(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   SymTable_T oSymTable = *(SymTable_T *)pvExtra;
+
+   assert(pcKey != NULL);
+   assert(pvValue != NULL);
+
+   ASSURE(SymTable_get(oSymTable, pcKey) == pvValue);
+   ASSURE(SymTable_containsN(oSymTable, pcKey, strlen(pcKey)));
+   ASSURE(SymTable_get(oSymTable, "absent") == NULL);
+   (*(int*)pvValue)++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that SymTable_mapParallel() visits every binding exactly
+   once, whatever the number of threads, and that the function it
+   applies may look bindings up. */
+
+static void testMapParallel(void)
+{
+   enum {PARALLEL_BINDING_COUNT = 5000, LOOKUP_BINDING_COUNT = 4100,
+      MAX_KEY_LENGTH = 10};
+
+   static const int aiThreads[] = {1, 2, 4, 0, 64};
+
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   static int aiVisits[PARALLEL_BINDING_COUNT];
+   int iSuccessful;
+   size_t i;
+   size_t j;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_mapParallel() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* An empty table has nothing to visit. */
+   SymTable_mapParallel(oSymTable, countVisit, NULL, 4);
+
+   for (i = 0; i < PARALLEL_BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%lu", (unsigned long)i);
+      aiVisits[i] = 0;
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiVisits[i]);
+      ASSURE(iSuccessful);
+   }
+
+   for (j = 0; j < sizeof(aiThreads) / sizeof(aiThreads[0]); j++)
+   {
+      SymTable_mapParallel(oSymTable, countVisit, NULL, aiThreads[j]);
+      for (i = 0; i < PARALLEL_BINDING_COUNT; i++)
+         ASSURE(aiVisits[i] == (int)j + 1);
+   }
+
+   /* A small table gives each thread little or nothing to do. */
+   for (i = 100; i < PARALLEL_BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%lu", (unsigned long)i);
+      ASSURE(SymTable_remove(oSymTable, acKey) == &aiVisits[i]);
+   }
+   SymTable_mapParallel(oSymTable, countVisit, NULL, 8);
+   for (i = 0; i < 100; i++)
+      ASSURE(aiVisits[i] == (int)j + 1);
+
+   SymTable_free(oSymTable);
+
+   /* Lookups from every thread, in a table that has just outgrown
+      4096 buckets and may still be moving bindings into the new
+      ones. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < LOOKUP_BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%lu", (unsigned long)i);
+      aiVisits[i] = 0;
+      ASSURE(SymTable_put(oSymTable, acKey, &aiVisits[i]));
+   }
+   SymTable_mapParallel(oSymTable, lookUpVisit, &oSymTable, 8);
+   for (i = 0; i < LOOKUP_BINDING_COUNT; i++)
+      ASSURE(aiVisits[i] == 1);
+   SymTable_mapParallel(oSymTable, lookUpVisit, &oSymTable, 1);
+   for (i = 0; i < LOOKUP_BINDING_COUNT; i++)
+      ASSURE(aiVisits[i] == 2);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The keys SymTable_map() visits, in the order it visits them. */
+
+struct KeyOrder
+{
+   const char **ppcKeys;
+   size_t uCount;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Append pcKey to the struct KeyOrder pointed to by pvExtra.
+   pvValue is unused. */
+
+static void recordKey(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   struct KeyOrder *psOrder = (struct KeyOrder*)pvExtra;
+
+   assert(pcKey != NULL);
+   assert(pvExtra != NULL);
+   (void)pvValue;
+
+   psOrder->ppcKeys[psOrder->uCount++] = pcKey;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTable_iter*() functions: a full traversal in the
+   order of SymTable_map(), stopping early, and removing bindings
+   as they are visited. */
+
+static void testIterator(void)
+{
+   enum {ITER_BINDING_COUNT = 1000, MAX_KEY_LENGTH = 10};
+
+   SymTable_T oSymTable;
+   SymTableIter_T oIter;
+   struct KeyOrder sOrder;
+   const char *apcMapKeys[ITER_BINDING_COUNT];
+   char aacKeys[ITER_BINDING_COUNT][MAX_KEY_LENGTH];
+   int aiValues[ITER_BINDING_COUNT];
+   const char *pcKey;
+   void *pvValue;
+   int iSuccessful;
+   size_t uCount;
+   size_t uLength;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_iter*() functions.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* An empty table has nothing to visit or remove. */
+   oIter = SymTable_iterBegin(oSymTable);
+   ASSURE(oIter != NULL);
+   ASSURE(SymTable_iterRemove(oIter) == NULL);
+   ASSURE(! SymTable_iterNext(oIter, &pcKey, &pvValue));
+   ASSURE(! SymTable_iterNext(oIter, NULL, NULL));
+   ASSURE(SymTable_iterRemove(oIter) == NULL);
+   SymTable_iterEnd(oIter);
+
+   for (i = 0; i < ITER_BINDING_COUNT; i++)
+   {
+      sprintf(aacKeys[i], "%d", i);
+      aiValues[i] = i;
+      iSuccessful = SymTable_put(oSymTable, aacKeys[i], &aiValues[i]);
+      ASSURE(iSuccessful);
+   }
+
+   /* Every binding is visited once, with its value, in the order
+      of SymTable_map(). */
+   sOrder.ppcKeys = apcMapKeys;
+   sOrder.uCount = 0;
+   SymTable_map(oSymTable, recordKey, &sOrder);
+   ASSURE(sOrder.uCount == ITER_BINDING_COUNT);
+
+   oIter = SymTable_iterBegin(oSymTable);
+   ASSURE(oIter != NULL);
+   uCount = 0;
+   while (SymTable_iterNext(oIter, &pcKey, &pvValue))
+   {
+      ASSURE(uCount < ITER_BINDING_COUNT);
+      ASSURE(strcmp(pcKey, apcMapKeys[uCount]) == 0);
+      ASSURE(*(int*)pvValue == atoi(pcKey));
+      uCount++;
+   }
+   ASSURE(uCount == ITER_BINDING_COUNT);
+   ASSURE(! SymTable_iterNext(oIter, &pcKey, &pvValue));
+   SymTable_iterEnd(oIter);
+
+   /* Stopping early leaves the table usable. */
+   oIter = SymTable_iterBegin(oSymTable);
+   ASSURE(oIter != NULL);
+   for (i = 0; i < 10; i++)
+      ASSURE(SymTable_iterNext(oIter, NULL, &pvValue));
+   SymTable_iterEnd(oIter);
+   ASSURE(SymTable_get(oSymTable, "0") == &aiValues[0]);
+
+   /* Removing every even binding as it is visited still visits
+      every binding. */
+   oIter = SymTable_iterBegin(oSymTable);
+   ASSURE(oIter != NULL);
+   ASSURE(SymTable_iterRemove(oIter) == NULL);
+   uCount = 0;
+   while (SymTable_iterNext(oIter, &pcKey, &pvValue))
+   {
+      uCount++;
+      if (*(int*)pvValue % 2 == 0)
+      {
+         ASSURE(SymTable_iterRemove(oIter) == pvValue);
+         ASSURE(SymTable_iterRemove(oIter) == NULL);
+      }
+   }
+   ASSURE(uCount == ITER_BINDING_COUNT);
+   ASSURE(SymTable_iterRemove(oIter) == NULL);
+   SymTable_iterEnd(oIter);
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == ITER_BINDING_COUNT / 2);
+   for (i = 0; i < ITER_BINDING_COUNT; i++)
+      ASSURE(SymTable_contains(oSymTable, aacKeys[i]) == (i % 2));
+
+   /* Removing every binding empties the table. */
+   oIter = SymTable_iterBegin(oSymTable);
+   ASSURE(oIter != NULL);
+   uCount = 0;
+   while (SymTable_iterNext(oIter, NULL, &pvValue))
+   {
+      ASSURE(*(int*)pvValue % 2 == 1);
+      ASSURE(SymTable_iterRemove(oIter) == pvValue);
+      uCount++;
+   }
+   ASSURE(uCount == ITER_BINDING_COUNT / 2);
+   SymTable_iterEnd(oIter);
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == 0);
+   iSuccessful = SymTable_put(oSymTable, aacKeys[1], &aiValues[1]);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_get(oSymTable, aacKeys[1]) == &aiValues[1]);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable objects made by SymTable_newWithIntern() sharing
+   one Intern_T: both hold the same copy of each key, the pool's
+   copy finds a binding, and the pool empties as the tables let
+   go of their keys. */
+
+static void testIntern(void)
+{
+   enum {INTERN_BINDING_COUNT = 100, MAX_KEY_LENGTH = 10};
+
+   Intern_T oIntern;
+   SymTable_T oSymTable1;
+   SymTable_T oSymTable2;
+   struct KeyOrder sOrder;
+   const char *apcKeys[INTERN_BINDING_COUNT];
+   char acKey[MAX_KEY_LENGTH];
+   int aiValues[INTERN_BINDING_COUNT];
+   const char *pcKey;
+   int iSuccessful;
+   size_t u;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_newWithIntern() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oIntern = Intern_new();
+   ASSURE(oIntern != NULL);
+   ASSURE(Intern_getLength(oIntern) == 0);
+   ASSURE(Intern_find(oIntern, "0") == NULL);
+
+   oSymTable1 = SymTable_newWithIntern(oIntern);
+   ASSURE(oSymTable1 != NULL);
+   oSymTable2 = SymTable_newWithIntern(oIntern);
+   ASSURE(oSymTable2 != NULL);
+
+   for (i = 0; i < INTERN_BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      aiValues[i] = i;
+      iSuccessful = SymTable_put(oSymTable1, acKey, &aiValues[i]);
+      ASSURE(iSuccessful);
+      iSuccessful = SymTable_put(oSymTable2, acKey, &aiValues[i]);
+      ASSURE(iSuccessful);
+      iSuccessful = SymTable_put(oSymTable2, acKey, &aiValues[0]);
+      ASSURE(! iSuccessful);
+   }
+
+   /* Both tables hold the pool's one copy of each key. */
+   ASSURE(Intern_getLength(oIntern) == INTERN_BINDING_COUNT);
+   sOrder.ppcKeys = apcKeys;
+   sOrder.uCount = 0;
+   SymTable_map(oSymTable1, recordKey, &sOrder);
+   ASSURE(sOrder.uCount == INTERN_BINDING_COUNT);
+   for (u = 0; u < sOrder.uCount; u++)
+      ASSURE(Intern_find(oIntern, apcKeys[u]) == apcKeys[u]);
+   sOrder.uCount = 0;
+   SymTable_map(oSymTable2, recordKey, &sOrder);
+   ASSURE(sOrder.uCount == INTERN_BINDING_COUNT);
+   for (u = 0; u < sOrder.uCount; u++)
+      ASSURE(Intern_find(oIntern, apcKeys[u]) == apcKeys[u]);
+
+   /* The pool's copy and any other copy find the same binding. */
+   pcKey = Intern_find(oIntern, "42");
+   ASSURE(pcKey != NULL);
+   ASSURE(strcmp(pcKey, "42") == 0);
+   ASSURE(SymTable_get(oSymTable1, pcKey) == &aiValues[42]);
+   ASSURE(SymTable_get(oSymTable2, "42") == &aiValues[42]);
+   ASSURE(SymTable_replace(oSymTable1, pcKey, &aiValues[0])
+      == &aiValues[42]);
+   ASSURE(SymTable_contains(oSymTable1, pcKey));
+   ASSURE(Intern_find(oIntern, "42") == pcKey);
+
+   /* Keys with embedded null characters are pooled as well. */
+   iSuccessful = SymTable_putN(oSymTable1, "a\0b", 3, &aiValues[1]);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_putN(oSymTable1, "a\0c", 3, &aiValues[2]);
+   ASSURE(iSuccessful);
+   ASSURE(Intern_getLength(oIntern) == INTERN_BINDING_COUNT + 2);
+   ASSURE(SymTable_getN(oSymTable1, "a\0c", 3) == &aiValues[2]);
+   ASSURE(SymTable_removeN(oSymTable1, "a\0b", 3) == &aiValues[1]);
+   ASSURE(SymTable_removeN(oSymTable1, "a\0c", 3) == &aiValues[2]);
+   ASSURE(Intern_getLength(oIntern) == INTERN_BINDING_COUNT);
+
+   /* A key stays pooled while either table holds it. */
+   for (i = 0; i < INTERN_BINDING_COUNT; i += 2)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_remove(oSymTable1, acKey) != NULL);
+   }
+   ASSURE(Intern_getLength(oIntern) == INTERN_BINDING_COUNT);
+   for (i = 1; i < INTERN_BINDING_COUNT; i += 2)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_remove(oSymTable2, acKey) == &aiValues[i]);
+   }
+   ASSURE(Intern_getLength(oIntern) == INTERN_BINDING_COUNT);
+
+   /* Freeing the tables gives back every key. */
+   SymTable_free(oSymTable1);
+   ASSURE(Intern_getLength(oIntern) == INTERN_BINDING_COUNT / 2);
+   SymTable_free(oSymTable2);
+   ASSURE(Intern_getLength(oIntern) == 0);
+   ASSURE(Intern_find(oIntern, "42") == NULL);
+
+   Intern_free(oIntern);
+}
+
+/*--------------------------------------------------------------------*/
+
 /* Test a SymTable object that contains no bindings. */
 
 static void testEmptyTable(void)
@@ -555,17 +1189,230 @@ static void testNullValue(void)
    pcValue = (char*)SymTable_get(oSymTable, "Mantle");
    ASSURE(pcValue == acCenterField);
 
-   pcValue = SymTable_replace(oSymTable, "Mantle", NULL);
-   ASSURE(pcValue == acCenterField);
+   pcValue = SymTable_replace(oSymTable, "Mantle", NULL);
+   ASSURE(pcValue == acCenterField);
+
+   iFound = SymTable_contains(oSymTable, "Mantle");
+   ASSURE(iFound);
+   
+   pcValue = (char*)SymTable_get(oSymTable, "Mantle");
+   ASSURE(pcValue == NULL);
+
+   pcValue = (char*)SymTable_remove(oSymTable, "Mantle");
+   ASSURE(pcValue == NULL);   
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test keys of every length around the one up to which keys are
+   stored inside the bindings, while the table grows and shrinks
+   around them. */
+
+static void testKeyLengths(void)
+{
+   enum {MAX_KEY_LENGTH = 40, FILLER_COUNT = 2000,
+      FILLER_KEY_LENGTH = 10};
+
+   SymTable_T oSymTable;
+   char aacKeys[MAX_KEY_LENGTH + 1][MAX_KEY_LENGTH + 1];
+   char acFiller[FILLER_KEY_LENGTH];
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing keys of many lengths.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   for (i = 0; i <= MAX_KEY_LENGTH; i++)
+   {
+      memset(aacKeys[i], 'a' + i % 26, (size_t)i);
+      aacKeys[i][i] = '\0';
+      ASSURE(SymTable_put(oSymTable, aacKeys[i], aacKeys[i]));
+   }
+
+   /* The table grows, and later shrinks, with the keys in it. */
+   for (i = 0; i < FILLER_COUNT; i++)
+   {
+      sprintf(acFiller, "f%d", i);
+      ASSURE(SymTable_put(oSymTable, acFiller, NULL));
+   }
+   for (i = 0; i <= MAX_KEY_LENGTH; i++)
+      ASSURE(SymTable_get(oSymTable, aacKeys[i]) == aacKeys[i]);
+   for (i = 0; i < FILLER_COUNT; i++)
+   {
+      sprintf(acFiller, "f%d", i);
+      ASSURE(SymTable_contains(oSymTable, acFiller));
+      SymTable_remove(oSymTable, acFiller);
+   }
+   SymTable_compact(oSymTable);
+   ASSURE(SymTable_getLength(oSymTable) == MAX_KEY_LENGTH + 1);
+
+   /* Keys that differ from the stored ones only in their last
+      character or their length are not found. */
+   for (i = 1; i <= MAX_KEY_LENGTH; i++)
+   {
+      char acKey[MAX_KEY_LENGTH + 2];
+      strcpy(acKey, aacKeys[i]);
+      acKey[i - 1] = 'Z';
+      ASSURE(! SymTable_contains(oSymTable, acKey));
+      acKey[i - 1] = aacKeys[i][i - 1];
+      acKey[i] = 'Z';
+      acKey[i + 1] = '\0';
+      ASSURE(SymTable_get(oSymTable, acKey) == NULL);
+   }
+
+   for (i = 0; i <= MAX_KEY_LENGTH; i++)
+      ASSURE(SymTable_remove(oSymTable, aacKeys[i]) == aacKeys[i]);
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that the address of a stored key, given with fewer
+   characters than the key has, is taken for the shorter key and
+   not for the stored one, with and without an intern pool. */
+
+static void testStoredKeyPrefix(void)
+{
+   enum {SHORTER_LENGTH = 9};
+
+   Intern_T oIntern;
+   SymTable_T oSymTable;
+   SymTableIter_T oIter;
+   const char *pcKey;
+   int iValue1;
+   int iValue2;
+   int iInterned;
+   int iFound;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing stored keys passed with a shorter length.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oIntern = Intern_new();
+   ASSURE(oIntern != NULL);
+   for (iInterned = 0; iInterned <= 1; iInterned++)
+   {
+      oSymTable = iInterned ? SymTable_newWithIntern(oIntern)
+         : SymTable_new();
+      ASSURE(oSymTable != NULL);
+      ASSURE(SymTable_put(oSymTable, "abcdefghij", &iValue1));
+
+      /* The iterator hands out the table's own copy of the key. */
+      oIter = SymTable_iterBegin(oSymTable);
+      ASSURE(oIter != NULL);
+      iFound = SymTable_iterNext(oIter, &pcKey, NULL);
+      ASSURE(iFound);
+      SymTable_iterEnd(oIter);
+      ASSURE(strcmp(pcKey, "abcdefghij") == 0);
+
+      ASSURE(SymTable_getN(oSymTable, pcKey, SHORTER_LENGTH) == NULL);
+      ASSURE(! SymTable_containsN(oSymTable, pcKey, SHORTER_LENGTH));
+      ASSURE(SymTable_removeN(oSymTable, pcKey, SHORTER_LENGTH)
+         == NULL);
+      ASSURE(SymTable_replaceN(oSymTable, pcKey, SHORTER_LENGTH,
+         &iValue2) == NULL);
+      ASSURE(SymTable_getLength(oSymTable) == 1);
+      ASSURE(SymTable_get(oSymTable, "abcdefghij") == &iValue1);
+
+      ASSURE(SymTable_putN(oSymTable, pcKey, SHORTER_LENGTH,
+         &iValue2));
+      ASSURE(SymTable_getLength(oSymTable) == 2);
+      ASSURE(SymTable_get(oSymTable, "abcdefghi") == &iValue2);
+      ASSURE(SymTable_get(oSymTable, "abcdefghij") == &iValue1);
+      ASSURE(SymTable_remove(oSymTable, "abcdefghi") == &iValue2);
+      ASSURE(SymTable_get(oSymTable, "abcdefghij") == &iValue1);
+
+      SymTable_free(oSymTable);
+   }
+   Intern_free(oIntern);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTable functions that take the length of their key,
+   on slices of a buffer that holds no '\0' at all. */
+
+static void testLengthKeys(void)
+{
+   enum {TEXT_LENGTH = 14, LONG_LENGTH = 40};
+
+   SymTable_T oSymTable;
+   char acText[TEXT_LENGTH];
+   char acLong[LONG_LENGTH];
+   char acKey[LONG_LENGTH + 1];
+   const char *pcAlpha = acText;
+   const char *pcBeta = acText + 5;
+   const char *pcGamma = acText + 9;
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing keys given with their length.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
 
-   iFound = SymTable_contains(oSymTable, "Mantle");
-   ASSURE(iFound);
-   
-   pcValue = (char*)SymTable_get(oSymTable, "Mantle");
-   ASSURE(pcValue == NULL);
+   memcpy(acText, "alphabetagamma", TEXT_LENGTH);
+   memset(acLong, 'L', LONG_LENGTH);
 
-   pcValue = (char*)SymTable_remove(oSymTable, "Mantle");
-   ASSURE(pcValue == NULL);   
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   iSuccessful = SymTable_putN(oSymTable, pcAlpha, 5, "1");
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_putN(oSymTable, pcBeta, 4, "2");
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_putN(oSymTable, pcGamma, 5, "3");
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_putN(oSymTable, acLong, LONG_LENGTH, "4");
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_putN(oSymTable, pcBeta, 4, "x");
+   ASSURE(! iSuccessful);
+   ASSURE(SymTable_getLength(oSymTable) == 4);
+
+   ASSURE(strcmp((char*)SymTable_getN(oSymTable, pcAlpha, 5), "1")
+      == 0);
+   ASSURE(strcmp((char*)SymTable_getN(oSymTable, pcBeta, 4), "2")
+      == 0);
+   ASSURE(SymTable_containsN(oSymTable, pcGamma, 5));
+   ASSURE(SymTable_containsN(oSymTable, acLong, LONG_LENGTH));
+
+   /* The keys equal their NUL-terminated forms. */
+   ASSURE(strcmp((char*)SymTable_get(oSymTable, "alpha"), "1") == 0);
+   ASSURE(SymTable_contains(oSymTable, "beta"));
+   memcpy(acKey, acLong, LONG_LENGTH);
+   acKey[LONG_LENGTH] = '\0';
+   ASSURE(strcmp((char*)SymTable_get(oSymTable, acKey), "4") == 0);
+   ASSURE(SymTable_containsN(oSymTable, "gamma!", 5));
+
+   /* Prefixes and extensions of the keys are not found. */
+   ASSURE(! SymTable_containsN(oSymTable, pcAlpha, 4));
+   ASSURE(! SymTable_containsN(oSymTable, pcAlpha, 6));
+   ASSURE(! SymTable_containsN(oSymTable, pcGamma, 0));
+   ASSURE(SymTable_getN(oSymTable, acLong, LONG_LENGTH - 1) == NULL);
+   ASSURE(! SymTable_contains(oSymTable, "alphabeta"));
+
+   ASSURE(strcmp((char*)SymTable_replaceN(oSymTable, pcBeta, 4, "5"),
+      "2") == 0);
+   ASSURE(strcmp((char*)SymTable_get(oSymTable, "beta"), "5") == 0);
+   ASSURE(SymTable_replaceN(oSymTable, pcBeta, 3, "6") == NULL);
+
+   ASSURE(strcmp((char*)SymTable_removeN(oSymTable, pcAlpha, 5), "1")
+      == 0);
+   ASSURE(SymTable_removeN(oSymTable, pcAlpha, 5) == NULL);
+   ASSURE(strcmp((char*)SymTable_remove(oSymTable, acKey), "4") == 0);
+   ASSURE(SymTable_getLength(oSymTable) == 2);
+
+   /* The empty key given by length is the empty string. */
+   iSuccessful = SymTable_putN(oSymTable, acText, 0, "7");
+   ASSURE(iSuccessful);
+   ASSURE(strcmp((char*)SymTable_get(oSymTable, ""), "7") == 0);
 
    SymTable_free(oSymTable);
 }
@@ -776,6 +1623,588 @@ static void testCollisions(void)
 
 /*--------------------------------------------------------------------*/
 
+/* Return the same hash for any key, so every binding of a
+   SymTable object that uses it collides. pcKey and uLength are
+   unused. */
+
+static size_t hashConstant(const char *pcKey, size_t uLength)
+{
+   assert(pcKey != NULL);
+   (void)uLength;
+   return 123;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test a SymTable object created with a user hash function, one
+   that makes every key collide. */
+
+static void testCustomHash(void)
+{
+   enum {COLLIDING_BINDING_COUNT = 300, MAX_KEY_LENGTH = 10};
+
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   char acShortstop[] = "Shortstop";
+   char *pcValue;
+   int i;
+   int iSuccessful;
+   int iFound;
+   size_t uLength;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a SymTable object with a user hash function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_newWithHash(hashConstant);
+   ASSURE(oSymTable != NULL);
+
+   for (i = 0; i < COLLIDING_BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acShortstop);
+      ASSURE(iSuccessful);
+   }
+   iSuccessful = SymTable_put(oSymTable, "7", acShortstop);
+   ASSURE(! iSuccessful);
+
+   for (i = 0; i < COLLIDING_BINDING_COUNT; i += 3)
+   {
+      sprintf(acKey, "%d", i);
+      pcValue = (char*)SymTable_remove(oSymTable, acKey);
+      ASSURE(pcValue == acShortstop);
+   }
+
+   for (i = 0; i < COLLIDING_BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iFound = SymTable_contains(oSymTable, acKey);
+      ASSURE(iFound == (i % 3 != 0));
+   }
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == COLLIDING_BINDING_COUNT
+      - (COLLIDING_BINDING_COUNT + 2) / 3);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_setReorder with each way of reordering, on a table
+   whose keys all collide so that a hash table keeps them in one
+   chain, by looking up a few keys much more often than the others
+   and then checking every binding is still there once. */
+
+static void testReorder(void)
+{
+   enum {REORDER_BINDING_COUNT = 200, HOT_KEY_COUNT = 5,
+      ROUND_COUNT = 50, MAX_KEY_LENGTH = 10};
+   static const enum SymTableReorder aeReorders[] =
+      {SYMTABLE_REORDER_NONE, SYMTABLE_REORDER_MOVE_TO_FRONT,
+       SYMTABLE_REORDER_TRANSPOSE};
+
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   const char *apcKeys[2];
+   void *apvValues[2];
+   int aiValues[REORDER_BINDING_COUNT];
+   size_t uReorder;
+   size_t uCount;
+   int iRound;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_setReorder() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (uReorder = 0;
+      uReorder < sizeof(aeReorders) / sizeof(aeReorders[0]);
+      uReorder++)
+   {
+      oSymTable = SymTable_newWithHash(hashConstant);
+      ASSURE(oSymTable != NULL);
+      SymTable_setReorder(oSymTable, aeReorders[uReorder]);
+
+      for (i = 0; i < REORDER_BINDING_COUNT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         aiValues[i] = i;
+         iSuccessful = SymTable_put(oSymTable, acKey, &aiValues[i]);
+         ASSURE(iSuccessful);
+      }
+
+      /* The hot keys are the ones put first, at the end of a list
+         that puts new bindings in front. */
+      for (iRound = 0; iRound < ROUND_COUNT; iRound++)
+      {
+         for (i = 0; i < HOT_KEY_COUNT; i++)
+         {
+            sprintf(acKey, "%d", i);
+            ASSURE(SymTable_get(oSymTable, acKey) == &aiValues[i]);
+         }
+         sprintf(acKey, "%d", iRound);
+         ASSURE(SymTable_get(oSymTable, acKey) == &aiValues[iRound]);
+         ASSURE(SymTable_get(oSymTable, "missing") == NULL);
+      }
+
+      /* A batch can find the same key twice. */
+      apcKeys[0] = "3";
+      apcKeys[1] = "3";
+      SymTable_getBatch(oSymTable, apcKeys, 2, apvValues);
+      ASSURE(apvValues[0] == &aiValues[3]);
+      ASSURE(apvValues[1] == &aiValues[3]);
+
+      uCount = 0;
+      SymTable_map(oSymTable, countBinding, &uCount);
+      ASSURE(uCount == REORDER_BINDING_COUNT);
+      ASSURE(SymTable_getLength(oSymTable) == REORDER_BINDING_COUNT);
+
+      for (i = 0; i < REORDER_BINDING_COUNT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         ASSURE(SymTable_get(oSymTable, acKey) == &aiValues[i]);
+      }
+      for (i = REORDER_BINDING_COUNT - 1; i >= 0; i -= 2)
+      {
+         sprintf(acKey, "%d", i);
+         ASSURE(SymTable_remove(oSymTable, acKey) == &aiValues[i]);
+      }
+      for (i = 0; i < REORDER_BINDING_COUNT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         ASSURE(SymTable_contains(oSymTable, acKey) == (i % 2 == 0));
+      }
+
+      SymTable_free(oSymTable);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_setFilter: a filter enabled on a table that already
+   has bindings, grown well past its first size, kept up to date by
+   removals through SymTable_remove and an iterator, and one whose
+   counters all stick at their maximum because every key has the
+   same hash. No key held may ever be reported missing. */
+
+static void testFilter(void)
+{
+   enum {FILTER_BINDING_COUNT = 3000, COLLIDING_BINDING_COUNT = 40,
+      MAX_KEY_LENGTH = 12};
+
+   SymTable_T oSymTable;
+   SymTableIter_T oIter;
+   char acKey[MAX_KEY_LENGTH];
+   int aiValues[FILTER_BINDING_COUNT];
+   const char *pcKey;
+   void *pvValue;
+   void *pvFound;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_setFilter() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < FILTER_BINDING_COUNT / 10; i++)
+   {
+      sprintf(acKey, "%d", i);
+      aiValues[i] = i;
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiValues[i]);
+      ASSURE(iSuccessful);
+   }
+   iSuccessful = SymTable_setFilter(oSymTable, 1);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_setFilter(oSymTable, 1);
+   ASSURE(iSuccessful);
+
+   for (i = FILTER_BINDING_COUNT / 10; i < FILTER_BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      aiValues[i] = i;
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiValues[i]);
+      ASSURE(iSuccessful);
+   }
+   iSuccessful = SymTable_put(oSymTable, "7", &aiValues[0]);
+   ASSURE(! iSuccessful);
+   iSuccessful = SymTable_putOrGet(oSymTable, "8", &aiValues[0],
+      &pvFound);
+   ASSURE(iSuccessful == 0);
+   ASSURE(pvFound == &aiValues[8]);
+
+   for (i = 0; i < FILTER_BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_get(oSymTable, acKey) == &aiValues[i]);
+      sprintf(acKey, "x%d", i);
+      ASSURE(SymTable_get(oSymTable, acKey) == NULL);
+      ASSURE(! SymTable_contains(oSymTable, acKey));
+      ASSURE(SymTable_replace(oSymTable, acKey, &aiValues[0])
+         == NULL);
+      ASSURE(SymTable_remove(oSymTable, acKey) == NULL);
+   }
+   ASSURE(SymTable_getLength(oSymTable) == FILTER_BINDING_COUNT);
+
+   /* Removed keys are gone, put back they are found again. */
+   for (i = 0; i < FILTER_BINDING_COUNT; i += 2)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_remove(oSymTable, acKey) == &aiValues[i]);
+   }
+   for (i = 0; i < FILTER_BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_contains(oSymTable, acKey) == (i % 2 != 0));
+   }
+   for (i = 0; i < FILTER_BINDING_COUNT; i += 4)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiValues[i]);
+      ASSURE(iSuccessful);
+   }
+
+   /* An iterator removes the keys that are multiples of 3. */
+   oIter = SymTable_iterBegin(oSymTable);
+   ASSURE(oIter != NULL);
+   while (SymTable_iterNext(oIter, &pcKey, &pvValue))
+      if (*(int*)pvValue % 3 == 0)
+         ASSURE(SymTable_iterRemove(oIter) == pvValue);
+   SymTable_iterEnd(oIter);
+
+   SymTable_compact(oSymTable);
+   iSuccessful = SymTable_reserve(oSymTable, FILTER_BINDING_COUNT * 2);
+   ASSURE(iSuccessful);
+   for (i = 0; i < FILTER_BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_contains(oSymTable, acKey)
+         == ((i % 2 != 0 || i % 4 == 0) && i % 3 != 0));
+   }
+
+   iSuccessful = SymTable_setFilter(oSymTable, 0);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_get(oSymTable, "1") == &aiValues[1]);
+   ASSURE(SymTable_get(oSymTable, "3") == NULL);
+   SymTable_free(oSymTable);
+
+   /* With one hash for every key, nothing can be turned away. */
+   oSymTable = SymTable_newWithHash(hashConstant);
+   ASSURE(oSymTable != NULL);
+   iSuccessful = SymTable_setFilter(oSymTable, 1);
+   ASSURE(iSuccessful);
+   for (i = 0; i < COLLIDING_BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiValues[i]);
+      ASSURE(iSuccessful);
+   }
+   for (i = 0; i < COLLIDING_BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_remove(oSymTable, acKey) == &aiValues[i]);
+      ASSURE(SymTable_get(oSymTable, acKey) == NULL);
+   }
+   iSuccessful = SymTable_put(oSymTable, "0", &aiValues[0]);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_get(oSymTable, "0") == &aiValues[0]);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The number of times lookUpRepeatedly() gets each key. */
+
+enum {REPEATED_LOOKUPS = 100};
+
+/* Get pcKey REPEATED_LOOKUPS times from the SymTable_T that pvExtra
+   points to, which must bind it to pvValue, so that the lookups of
+   the threads of SymTable_mapParallel() overlap. */
+
+static void lookUpRepeatedly(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   SymTable_T oSymTable = *(SymTable_T *)pvExtra;
+   int i;
+
+   for (i = 0; i < REPEATED_LOOKUPS; i++)
+      ASSURE(SymTable_get(oSymTable, pcKey) == pvValue);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_getStats, on a table of ordinary keys and on one
+   whose keys all collide. The counters are only checked when the
+   implementation keeps them, and must count lookups from several
+   threads at once exactly. */
+
+static void testStats(void)
+{
+   enum {BINDING_COUNT = 100, COLLIDING_BINDING_COUNT = 20,
+      MAX_KEY_LENGTH = 10};
+
+   SymTable_T oSymTable;
+   struct SymTableStats sStats;
+   char acKey[MAX_KEY_LENGTH];
+   char acShortstop[] = "Shortstop";
+   size_t uKeyBytes = 0;
+   size_t uBuckets = 0;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_getStats.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_put(oSymTable, acKey, acShortstop));
+      uKeyBytes += strlen(acKey) + 1;
+   }
+   ASSURE(! SymTable_put(oSymTable, "7", acShortstop));
+   ASSURE(SymTable_get(oSymTable, "1") == acShortstop);
+   ASSURE(SymTable_get(oSymTable, "2") == acShortstop);
+   ASSURE(SymTable_get(oSymTable, "x") == NULL);
+   ASSURE(SymTable_contains(oSymTable, "3"));
+   ASSURE(SymTable_replace(oSymTable, "4", acShortstop)
+      == acShortstop);
+   ASSURE(SymTable_remove(oSymTable, "5") == acShortstop);
+   uKeyBytes -= 2;
+
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.uLength == BINDING_COUNT - 1);
+   ASSURE(sStats.uBucketCount > 0);
+   ASSURE(sStats.dLoadFactor * (double)sStats.uBucketCount
+      > (double)(BINDING_COUNT - 1) - 0.5);
+   ASSURE(sStats.dLoadFactor * (double)sStats.uBucketCount
+      < (double)(BINDING_COUNT - 1) + 0.5);
+   ASSURE(sStats.uLongestChain >= 1);
+   ASSURE(sStats.uLongestChain <= BINDING_COUNT - 1);
+   for (i = 0; i < SYMTABLE_STATS_CHAIN_LENGTHS; i++)
+      uBuckets += sStats.auChainLengths[i];
+   ASSURE(uBuckets > 0);
+   ASSURE(sStats.uKeyBytes == uKeyBytes);
+   ASSURE(sStats.uBindingBytes > 0);
+   if (sStats.ulPuts != 0)
+   {
+      ASSURE(sStats.ulPuts == BINDING_COUNT + 1);
+      ASSURE(sStats.ulGets == 3);
+      ASSURE(sStats.ulContains == 1);
+      ASSURE(sStats.ulReplaces == 1);
+      ASSURE(sStats.ulRemoves == 1);
+      ASSURE(sStats.ulProbes > 0);
+   }
+   else
+   {
+      ASSURE(sStats.ulGets == 0);
+      ASSURE(sStats.ulProbes == 0);
+      ASSURE(sStats.ulResizes == 0);
+   }
+
+   SymTable_mapParallel(oSymTable, lookUpRepeatedly, &oSymTable, 8);
+   SymTable_getStats(oSymTable, &sStats);
+   if (sStats.ulPuts != 0)
+      ASSURE(sStats.ulGets
+         == 3 + (unsigned long)(BINDING_COUNT - 1) * REPEATED_LOOKUPS);
+   SymTable_free(oSymTable);
+
+   /* Every key in one chain. */
+   oSymTable = SymTable_newWithHash(hashConstant);
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < COLLIDING_BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_put(oSymTable, acKey, acShortstop));
+   }
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.uLength == COLLIDING_BINDING_COUNT);
+   ASSURE(sStats.uLongestChain == COLLIDING_BINDING_COUNT);
+   ASSURE(sStats.auChainLengths[SYMTABLE_STATS_CHAIN_LENGTHS - 1] >= 1);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that a SymTable object gives memory back as bindings are
+   removed, and through SymTable_compact, without losing the
+   bindings that are left. */
+
+static void testShrink(void)
+{
+   enum {BINDING_COUNT = 5000, KEPT_EVERY = 100, MAX_KEY_LENGTH = 10};
+
+   SymTable_T oSymTable;
+   struct SymTableStats sStats;
+   char acKey[MAX_KEY_LENGTH];
+   size_t uPeakBuckets;
+   size_t uSparseBuckets;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing shrinking and SymTable_compact.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* Compacting an empty table is harmless. */
+   SymTable_compact(oSymTable);
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_put(oSymTable, acKey, (void*)acKey));
+   }
+   SymTable_getStats(oSymTable, &sStats);
+   uPeakBuckets = sStats.uBucketCount;
+
+   /* Removing most of the bindings shrinks the table, unless it
+      has only one bucket to begin with. */
+   for (i = 0; i < BINDING_COUNT; i++)
+      if (i % KEPT_EVERY != 0)
+      {
+         sprintf(acKey, "%d", i);
+         ASSURE(SymTable_remove(oSymTable, acKey) == (void*)acKey);
+      }
+   ASSURE(SymTable_getLength(oSymTable)
+      == BINDING_COUNT / KEPT_EVERY);
+   SymTable_getStats(oSymTable, &sStats);
+   uSparseBuckets = sStats.uBucketCount;
+   ASSURE(uSparseBuckets <= uPeakBuckets);
+   if (uPeakBuckets > 1)
+      ASSURE(uSparseBuckets < uPeakBuckets);
+
+   SymTable_compact(oSymTable);
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.uBucketCount <= uSparseBuckets);
+   ASSURE(SymTable_getLength(oSymTable)
+      == BINDING_COUNT / KEPT_EVERY);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      if (i % KEPT_EVERY == 0)
+         ASSURE(SymTable_get(oSymTable, acKey) == (void*)acKey);
+      else
+         ASSURE(! SymTable_contains(oSymTable, acKey));
+   }
+
+   /* A shrunk table grows again. */
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_put(oSymTable, acKey, (void*)acKey)
+         == (i % KEPT_EVERY != 0));
+   }
+   ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_contains(oSymTable, acKey));
+   }
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_newWithCapacity and SymTable_reserve: a table sized
+   up front never resizes while it is filled, nor shrinks below that
+   size, and reserving on a table that already has bindings, with or
+   without an arena, keeps them. */
+
+static void testReserve(void)
+{
+   enum {BINDING_COUNT = 5000, EARLY_BINDING_COUNT = 100,
+      MAX_KEY_LENGTH = 10};
+
+   SymTable_T oSymTable;
+   struct SymTableStats sStats;
+   char acKey[MAX_KEY_LENGTH];
+   size_t uReservedBuckets;
+   unsigned long ulResizes;
+   int iArena;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_newWithCapacity and SymTable_reserve.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_newWithCapacity(BINDING_COUNT);
+   ASSURE(oSymTable != NULL);
+   SymTable_getStats(oSymTable, &sStats);
+   uReservedBuckets = sStats.uBucketCount;
+   ulResizes = sStats.ulResizes;
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_put(oSymTable, acKey, (void*)acKey));
+   }
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.uBucketCount == uReservedBuckets);
+   ASSURE(sStats.ulResizes == ulResizes);
+
+   for (i = 1; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_remove(oSymTable, acKey) == (void*)acKey);
+   }
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.uBucketCount == uReservedBuckets);
+   SymTable_compact(oSymTable);
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.uBucketCount <= uReservedBuckets);
+   ASSURE(SymTable_get(oSymTable, "0") == (void*)acKey);
+   SymTable_free(oSymTable);
+
+   /* Reserving late, and reserving less than is there. */
+   for (iArena = 0; iArena <= 1; iArena++)
+   {
+      if (iArena)
+         oSymTable = SymTable_newWithArena(0);
+      else
+         oSymTable = SymTable_new();
+      ASSURE(oSymTable != NULL);
+      for (i = 0; i < EARLY_BINDING_COUNT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         ASSURE(SymTable_put(oSymTable, acKey, (void*)acKey));
+      }
+      ASSURE(SymTable_reserve(oSymTable, BINDING_COUNT));
+      ASSURE(SymTable_reserve(oSymTable, 0));
+      ASSURE(SymTable_getLength(oSymTable) == EARLY_BINDING_COUNT);
+      for (i = 0; i < BINDING_COUNT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         ASSURE(SymTable_put(oSymTable, acKey, (void*)acKey)
+            == (i >= EARLY_BINDING_COUNT));
+      }
+      for (i = 0; i < BINDING_COUNT; i += 2)
+      {
+         sprintf(acKey, "%d", i);
+         ASSURE(SymTable_remove(oSymTable, acKey) == (void*)acKey);
+      }
+      for (i = 0; i < BINDING_COUNT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         ASSURE(SymTable_contains(oSymTable, acKey) == (i % 2));
+      }
+      SymTable_free(oSymTable);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
 /* Test the ability of a SymTable object to be large, that is, to
    contain iBindingCount bindings. Write the time consumed to stdout. */
 
@@ -953,13 +2382,29 @@ int main(int argc, char *argv[])
    testKeyComparison();
    testKeyOwnership();
    testRemove();
+   testPutOrGet();
+   testArena();
+   testBatch();
    testMap();
+   testMapGrowing();
+   testMapParallel();
+   testIterator();
+   testIntern();
    testEmptyTable();
    testEmptyKey();
    testNullValue();
    testLongKey();
+   testKeyLengths();
+   testStoredKeyPrefix();
+   testLengthKeys();
    testTableOfTables();
    testCollisions();
+   testCustomHash();
+   testReorder();
+   testFilter();
+   testStats();
+   testShrink();
+   testReserve();
    testLargeTable(iBindingCount);
 
    printf("------------------------------------------------------\n");